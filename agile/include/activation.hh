@@ -57,6 +57,16 @@ agile::vector exp_sigmoid_deriv(const agile::vector &v);
  */
 agile::vector softmax(const agile::vector &v);
 //----------------------------------------------------------------------------
+/**
+ * @brief Applies an activation to a block of samples in place.
+ * @details Each row of M holds the pre-activations of one sample, so a
+ * softmax is taken along every row separately.
+ * 
+ * @param M The block of pre-activations, one sample per row.
+ * @param type Which activation to apply.
+ */
+void activate_rows(agile::matrix &M, layer_type type);
+//----------------------------------------------------------------------------
 
 /**
  * @brief Adds noise to an agile::vector passed.
@@ -9,6 +9,7 @@
 
 #include "agile/include/layer.hh"
 #include "agile/include/autoencoder.hh"
+#include <functional>
 
 
 //-----------------------------------------------------------------------------
@@ -96,6 +97,13 @@ public:
 //  Prediction and training methods
 //-----------------------------------------------------------------------------
     agile::vector predict(const agile::vector &v);
+
+    // predicts a whole block at once, one sample per row of X. Each layer is
+    // one matrix product over tile_rows samples at a time, and the tiles are
+    // shared out over n_threads threads (0 means one per core). Unlike 
+    // predict(), this leaves the layers untouched.
+    agile::matrix predict_batch(const agile::matrix &X, 
+        std::size_t tile_rows = 1024, unsigned int n_threads = 1) const;
     
     void correct(const agile::vector &in, const agile::vector &target);
     void correct(const agile::vector &in, const agile::vector &target, 
@@ -115,6 +123,20 @@ public:
     friend struct YAML::convert<architecture>;
 
 protected:
+//-----------------------------------------------------------------------------
+//  Batched prediction helpers
+//-----------------------------------------------------------------------------
+    // runs a tile of samples (one per row) through every layer, in place
+    void forward(agile::matrix &A) const;
+
+    // calls f(worker, first_row, n_rows) for each tile of rows, on 
+    // n_threads threads. worker is below default_threads(n_threads) and 
+    // only one tile at a time has the same one, so it can index whatever
+    // the threads each need their own of.
+    static void for_tiles(std::size_t rows, std::size_t tile_rows, 
+        unsigned int n_threads, 
+        const std::function<void(unsigned int, std::size_t, std::size_t)> &f);
+
 //-----------------------------------------------------------------------------
 //  Protected Members
 //-----------------------------------------------------------------------------
@@ -52,6 +52,8 @@ std::mt19937_64& mersenne_engine();
 //----------------------------------------------------------------------------
 /**
  * @brief Converts an agile::matrix to a string for storage in yaml.
+ * @details Each value is written with the fewest digits (up to 17) that
+ * read back as exactly the same double.
  * 
  * @param M An agile::matrix.
  * @return a std::string containing the data from the agile::matrix
@@ -66,6 +68,30 @@ std::string stringify(const agile::matrix &M);
  */
 agile::matrix destringify(const std::string &s);
 //----------------------------------------------------------------------------
+/**
+ * @brief Somewhere other than the YAML text to keep matrices.
+ * @details While one is installed on a thread (see use_matrix_store()), 
+ * stringify() hands every matrix to put() and returns the short reference
+ * it gives back, and destringify() passes references to get(). The binary
+ * model files in model_file.hh use this to keep the weights out of the 
+ * YAML, without the serialization code having to know.
+ */
+class matrix_store
+{
+public:
+    virtual ~matrix_store() {}
+    virtual std::string put(const agile::matrix &M) = 0;
+    virtual agile::matrix get(const std::string &reference) = 0;
+};
+//----------------------------------------------------------------------------
+/**
+ * @brief Installs a matrix_store for this thread (nullptr for none).
+ * 
+ * @param store The store to use from now on.
+ * @return The store that was installed before.
+ */
+matrix_store* use_matrix_store(matrix_store *store);
+//----------------------------------------------------------------------------
 /**
  * @brief Converts a std::vector<numeric> to an agile::vector.
  * 
@@ -78,11 +104,9 @@ template<class D>
 inline agile::matrix eigen_spew(D &d)
 {
     agile::matrix M(d.rows(), d.columns());
-    int ctr = 0;
-    for (auto &row : d.raw())
+    for (std::size_t col = 0; col < d.columns(); ++col)
     {
-        M.row(ctr) = agile::std_to_Eigen(row);
-        ++ctr;
+        d.copy_column(col, M.col(col).data());
     }
     return std::move(M);
 }
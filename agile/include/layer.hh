@@ -164,6 +164,10 @@ public:
     {
         return W;
     }
+    agile::vector get_bias()
+    {
+        return b;
+    }
 //-----------------------------------------------------------------------------
 //  Access for YAML serialization
 //-----------------------------------------------------------------------------
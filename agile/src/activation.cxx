@@ -59,6 +59,31 @@ agile::vector agile::functions::softmax(const agile::vector &v)
     return std::move(w);
 }
 //----------------------------------------------------------------------------
+void agile::functions::activate_rows(agile::matrix &M, layer_type type)
+{
+    switch(type)
+    {
+        case ::linear: 
+            return;
+        case ::rectified: 
+            M = M.cwiseMax(0.0);
+            return;
+        case ::sigmoid: 
+            M = (1.0 + (-M.array()).exp()).inverse().matrix();
+            return;
+        case ::softmax:
+        {
+            // shifting by the row max changes nothing but the overflow
+            agile::colvec top = M.rowwise().maxCoeff();
+            M = (M.colwise() - top).array().exp().matrix();
+            agile::colvec norm = M.rowwise().sum();
+            M = M.array().colwise() / norm.array();
+            return;
+        }
+        default: throw std::domain_error("layer type not recognized.");
+    }
+}
+//----------------------------------------------------------------------------
 agile::vector agile::functions::add_noise(const agile::vector &v, 
     double level)
 {
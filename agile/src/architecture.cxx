@@ -5,6 +5,8 @@
 //-----------------------------------------------------------------------------
 
 #include "agile/include/architecture.hh"
+#include "dataframe/include/parallel.hh"
+#include <atomic>
 
 
 architecture::architecture(int num_layers) 
@@ -148,6 +150,64 @@ agile::vector architecture::predict(const agile::vector &v)
     return stack.at(n_layers - 1)->fire();
 }
 //----------------------------------------------------------------------------
+agile::matrix architecture::predict_batch(const agile::matrix &X, 
+    std::size_t tile_rows, unsigned int n_threads) const
+{
+    if (n_layers == 0)
+    {
+        throw std::logic_error("can't predict with an empty architecture.");
+    }
+    if (X.cols() != stack.front()->m_inputs)
+    {
+        throw std::invalid_argument("batch has " + std::to_string(X.cols()) +
+            " columns, network takes " + 
+            std::to_string(stack.front()->m_inputs) + " inputs.");
+    }
+    agile::matrix Y(X.rows(), stack.back()->m_outputs);
+    for_tiles(X.rows(), tile_rows, n_threads, 
+        [&](unsigned int, std::size_t first, std::size_t n)
+    {
+        agile::matrix A = X.middleRows(first, n);
+        forward(A);
+        Y.middleRows(first, n) = A;
+    });
+    return Y;
+}
+//----------------------------------------------------------------------------
+void architecture::forward(agile::matrix &A) const
+{
+    agile::matrix Z;
+    for (unsigned int i = 0; i < n_layers; ++i)
+    {
+        const layer &L = *stack[i];
+        Z.noalias() = A * L.W.transpose();
+        Z.rowwise() += L.b.transpose();
+        agile::functions::activate_rows(Z, L.m_layer_type);
+        A.swap(Z);
+    }
+}
+//----------------------------------------------------------------------------
+void architecture::for_tiles(std::size_t rows, std::size_t tile_rows, 
+    unsigned int n_threads, 
+    const std::function<void(unsigned int, std::size_t, std::size_t)> &f)
+{
+    tile_rows = std::max<std::size_t>(tile_rows, 1);
+    const std::size_t n_tiles = (rows + tile_rows - 1) / tile_rows;
+    unsigned int n = std::max<std::size_t>(1, std::min<std::size_t>(
+        agile::default_threads(n_threads), n_tiles));
+
+    // threads pull tiles off a shared counter, so a slow one holds no one up
+    std::atomic<std::size_t> next(0);
+    agile::run_parallel(n, [&](unsigned int worker)
+    {
+        for (std::size_t t = next++; t < n_tiles; t = next++)
+        {
+            std::size_t first = t * tile_rows;
+            f(worker, first, std::min(tile_rows, rows - first));
+        }
+    });
+}
+//----------------------------------------------------------------------------
 void architecture::correct(const agile::vector &in, 
     const agile::vector &target)
 {
@@ -4,6 +4,8 @@
 //  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
 //-----------------------------------------------------------------------------
 #include "agile/include/basedefs.hh"
+#include "dataframe/include/number_format.hh"
+#include <cstdio>
 
 //----------------------------------------------------------------------------
 std::mt19937_64& agile::mersenne_engine() // dumb random number generator
@@ -12,49 +14,71 @@ std::mt19937_64& agile::mersenne_engine() // dumb random number generator
     return _eng;
 }
 //----------------------------------------------------------------------------
+namespace
+{
+agile::matrix_store*& thread_store()
+{
+    static thread_local agile::matrix_store *store = nullptr;
+    return store;
+}
+}
+//----------------------------------------------------------------------------
+agile::matrix_store* agile::use_matrix_store(agile::matrix_store *store)
+{
+    std::swap(thread_store(), store);
+    return store;
+}
+//----------------------------------------------------------------------------
 std::string agile::stringify(const agile::matrix &M)
 {
-    std::stringstream ss;
-    ss << "#EM|" << M.rows() << "|" << M.cols() << std::setprecision(15);
+    if (thread_store())
+    {
+        return thread_store()->put(M);
+    }
+    std::string s = "#EM|" + std::to_string(M.rows()) + "|" + 
+        std::to_string(M.cols());
+    s.reserve(s.size() + 24 * M.size());
     for (int i = 0; i < M.rows(); ++i)
     {
         for (int j = 0; j < M.cols(); ++j)
         {
-            ss << "," << M(i, j);
+            s += ',';
+            agile::append_double(s, M(i, j));
         }
     }
-    return ss.str();
+    return s;
 }
 //----------------------------------------------------------------------------
 agile::matrix agile::destringify(const std::string &s)
 {
-    auto t(s);
-    auto first_bar = s.find_first_of("|");
-    auto last_bar = s.find_last_of("|");
-    auto found = s.find_first_of(",");
-    int rows = std::stoi(s.substr(first_bar + 1, last_bar - first_bar - 1));
-    int cols = std::stoi(s.substr(last_bar + 1, found - last_bar - 1));
-    
-    t.erase(0, found + 1);
-
-    agile::matrix M(rows, cols);
-    std::istringstream iss( t );
-    std::vector<double> data;
-
-    while (std::getline(iss, t, ',')) 
+    if (s.compare(0, 4, "#EM|") != 0)
     {
-        double fieldvalue = 0.000;
-        std::istringstream( t ) >> fieldvalue;
-        data.push_back( fieldvalue );
+        if (!thread_store())
+        {
+            throw std::invalid_argument("not a stringified matrix: " + 
+                s.substr(0, 16));
+        }
+        return thread_store()->get(s);
     }
-    for (int i = 0; i < rows; ++i)
+    const char *p = s.c_str() + 4;
+    char *end;
+    long rows = std::strtol(p, &end, 10);
+    long cols = std::strtol(end + 1, &end, 10);
+
+    // the values are stored row by row, straight after the dimensions
+    agile::matrix M(rows, cols);
+    for (long i = 0; i < rows; ++i)
     {
-        for (int j = 0; j < cols; ++j)
+        for (long j = 0; j < cols; ++j)
         {
-            M(i, j) = data.at(i * cols + j);
+            if (*end != ',')
+            {
+                throw std::out_of_range("stringified matrix is missing values.");
+            }
+            M(i, j) = std::strtod(end + 1, &end);
         }
     }
-    return std::move(M);
+    return M;
 }
 //----------------------------------------------------------------------------
 agile::vector agile::std_to_Eigen(std::vector<numeric> &v)
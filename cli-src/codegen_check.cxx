@@ -0,0 +1,58 @@
+// Checks a header from AGILECodegen against the network it was generated
+// from. Built and run by `make codegen-check NET=<file.yaml>`, with
+// AGILE_GENERATED_HEADER naming the header and agile_net its namespace.
+
+#include "include/neural_net.hh"
+#include AGILE_GENERATED_HEADER
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " net.yaml [samples]" << std::endl;
+        return 1;
+    }
+    agile::neural_net net;
+    net.from_file(argv[1]);
+    int samples = (argc > 2) ? std::stoi(argv[2]) : 10000;
+
+    auto inputs = net.get_base_inputs();
+    auto outputs = net.get_outputs();
+    auto scaling = net.get_scaling();
+    if ((inputs.size() != agile_net::n_inputs) || 
+        (outputs.size() != agile_net::n_outputs))
+    {
+        std::cerr << "generated code doesn't match the network's shape." << std::endl;
+        return 1;
+    }
+
+    // inputs spread over a couple of standard deviations of each one
+    std::normal_distribution<double> normal(0.0, 2.0);
+    std::vector<double> in(inputs.size()), out(outputs.size());
+    double deviation = 0.0;
+    for (int n = 0; n < samples; ++n)
+    {
+        std::map<std::string, double> x;
+        for (unsigned int i = 0; i < inputs.size(); ++i)
+        {
+            double mean = scaling.mean.count(inputs[i]) ? scaling.mean[inputs[i]] : 0.0,
+                   sd = scaling.sd.count(inputs[i]) ? scaling.sd[inputs[i]] : 1.0;
+            in[i] = mean + sd * normal(agile::mersenne_engine());
+            x[inputs[i]] = in[i];
+        }
+        auto expected = net.predict_map(x);
+        agile_net::predict(in.data(), out.data());
+        for (unsigned int i = 0; i < outputs.size(); ++i)
+        {
+            double diff = std::fabs(out[i] - expected[outputs[i]]);
+            // nan == nan as far as this check goes
+            if (!(diff <= deviation) && !(std::isnan(out[i]) && std::isnan(expected[outputs[i]])))
+            {
+                deviation = std::isnan(diff) ? HUGE_VAL : diff;
+            }
+        }
+    }
+    std::cout << "Largest deviation from predict_map over " << samples 
+              << " samples: " << deviation << std::endl;
+    return (deviation <= 1e-9) ? 0 : 1;
+}
@@ -0,0 +1,56 @@
+#include "include/code_generator.hh"
+#include "include/parser.hh"
+
+void complain(const std::string &complaint);
+
+//----------------------------------------------------------------------------
+int main(int argc, char const *argv[])
+{
+    std::string s("Turns a trained AGILEPack network into a standalone C++ header, ");
+    s += "with \nthe layer shapes and weights fixed at compile time";
+
+    optionparser::parser p(s);
+
+//----------------------------------------------------------------------------
+    p.add_option("--net", "-n")     .help("Network file (YAML or binary) to generate code for.")
+                                    .mode(optionparser::store_value);
+//----------------------------------------------------------------------------
+    p.add_option("--out", "-o")     .help("Header to write. (Default = <name>.hh)")
+                                    .mode(optionparser::store_value);
+//----------------------------------------------------------------------------
+    p.add_option("--name")          .help("Namespace of the generated code. (Default = agile_net)")
+                                    .mode(optionparser::store_value)
+                                    .default_value(std::string("agile_net"));
+//----------------------------------------------------------------------------
+    std::string unroll_help = "Layers with at most this many weights are unrolled into\n";
+    unroll_help.append(25, ' ');
+    unroll_help += "straight-line code. (Default = 4096)";
+
+    p.add_option("--unroll")        .help(unroll_help)
+                                    .mode(optionparser::store_value)
+                                    .default_value(4096);
+//----------------------------------------------------------------------------
+    p.eat_arguments(argc, argv);
+
+    if (!p.get_value("net")) complain("need a network file to generate code for.");
+
+    std::string name = p.get_value<std::string>("name");
+    std::string out = p.get_value("out") ? p.get_value<std::string>("out") : 
+        name + ".hh";
+
+    agile::neural_net net;
+    net.from_file(p.get_value<std::string>("net"));
+
+    agile::code_generator gen(net);
+    gen.set_name(name).set_unroll(p.get_value<int>("unroll"));
+    gen.write(out);
+
+    std::cout << "Wrote " << out << "." << std::endl;
+    return 0;
+}
+
+void complain(const std::string &complaint)
+{
+    std::cerr << "Error: " << complaint << std::endl;
+    exit(1);
+}
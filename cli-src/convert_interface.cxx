@@ -0,0 +1,145 @@
+#include "Base"
+#include "include/parser.hh"
+#include <chrono>
+
+void complain(const std::string &complaint);
+
+//----------------------------------------------------------------------------
+int main(int argc, char const *argv[])
+{
+    std::string s("Converts saved AGILEPack networks between YAML and the binary ");
+    s += "model \nformat, whichever --in isn't, and checks how quantizing them changes their outputs";
+
+    optionparser::parser p(s);
+
+//----------------------------------------------------------------------------
+    p.add_option("--in", "-i")      .help("YAML or binary network file to convert.")
+                                    .mode(optionparser::store_value);
+//----------------------------------------------------------------------------
+    p.add_option("--out", "-o")     .help("File to write the other format to.")
+                                    .mode(optionparser::store_value);
+//----------------------------------------------------------------------------
+    p.add_option("--check")         .help("Load both files back and compare the networks.");
+//----------------------------------------------------------------------------
+    std::string quantize_help = "Bits (8 and/or 16) to quantize the network to, calibrating on\n";
+    quantize_help.append(25, ' ');
+    quantize_help += "--sample and reporting how far its outputs are from the\n";
+    quantize_help.append(25, ' ');
+    quantize_help += "original. --out is optional with this.";
+
+    p.add_option("--quantize", "-q").help(quantize_help)
+                                    .mode(optionparser::store_mult_values);
+//----------------------------------------------------------------------------
+    p.add_option("--sample")        .help("CSV (with a header) or binary frame to calibrate --quantize on.")
+                                    .mode(optionparser::store_value);
+//----------------------------------------------------------------------------
+    p.add_option("--tolerance")     .help("Largest deviation --quantize accepts. (Default, anything)")
+                                    .mode(optionparser::store_value)
+                                    .default_value(-1.0);
+//----------------------------------------------------------------------------
+    p.eat_arguments(argc, argv);
+
+    if (!p.get_value("in")) complain("need a network file to convert.");
+
+    bool quantize = p.get_value("quantize");
+
+    if (!p.get_value("out") && !quantize) complain("need a file to write to.");
+
+    if (quantize && !p.get_value("sample")) complain("need a --sample to quantize with.");
+
+    std::string in = p.get_value<std::string>("in"),
+                out = p.get_value("out") ? p.get_value<std::string>("out") : "";
+
+    bool binary = agile::is_model_file(in);
+    if (!out.empty())
+    {
+        if (binary)
+        {
+            agile::model_file_to_yaml(in, out);
+        }
+        else
+        {
+            agile::yaml_to_model_file(in, out);
+        }
+        std::cout << "Wrote " << out << (binary ? " (YAML)." : " (binary).") 
+                  << std::endl;
+    }
+
+    if (quantize)
+    {
+        std::string sample = p.get_value<std::string>("sample");
+        double tolerance = p.get_value<double>("tolerance");
+
+        bool within = true;
+        try
+        {
+            agile::dataframe D;
+            bool csv = (sample.size() >= 4) && 
+                (sample.compare(sample.size() - 4, 4, ".csv") == 0);
+            if (csv)
+            {
+                D.from_csv(sample, true);
+            }
+            else
+            {
+                D.from_binary(sample);
+            }
+            agile::neural_net net;
+            net.from_file(in);
+
+            for (auto bits : p.get_value<std::vector<std::string>>("quantize"))
+            {
+                if ((bits != "8") && (bits != "16"))
+                {
+                    complain("can only quantize to 8 or 16 bits.");
+                }
+                agile::quantized_net Q(net, std::stoi(bits));
+                double deviation = Q.calibrate(D);
+                std::cout << bits << " bit: largest deviation from " << in 
+                          << " over " << std::min<std::size_t>(D.rows(),
+                              100000) << " rows of " << sample << " is "
+                          << deviation << std::endl;
+                within = within &&
+                    ((tolerance < 0) || (deviation <= tolerance));
+            }
+        }
+        catch(std::exception &e)
+        {
+            complain(e.what());
+        }
+        if (!within)
+        {
+            complain("quantized network is further than --tolerance from " +
+                in + ".");
+        }
+    }
+
+    if (p.get_value("check") && !out.empty())
+    {
+        typedef std::chrono::steady_clock clock;
+        auto load = [](const std::string &file, agile::neural_net &net)
+        {
+            auto t = clock::now();
+            net.from_file(file);
+            return std::chrono::duration<double>(clock::now() - t).count();
+        };
+        agile::neural_net a, b;
+        double t_in = load(in, a), t_out = load(out, b);
+
+        agile::matrix X = agile::matrix::Random(16, a.get_base_inputs().size());
+        agile::matrix Y = a.predict_batch(X), Z = b.predict_batch(X);
+        if ((Y.rows() != Z.rows()) || (Y.cols() != Z.cols()) || (Y != Z))
+        {
+            complain("the networks in " + in + " and " + out + " differ.");
+        }
+        std::cout << "Networks match. Loaded " << in << " in " << t_in 
+                  << " s, " << out << " in " << t_out << " s." << std::endl;
+    }
+    return 0;
+}
+
+void complain(const std::string &complaint)
+{
+    std::cerr << "Error: " << complaint << std::endl;
+    exit(1);
+}
@@ -0,0 +1,151 @@
+#include "include/inference_client.hh"
+#include "include/parser.hh"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <thread>
+
+void complain(const std::string &complaint);
+
+//----------------------------------------------------------------------------
+int main(int argc, char const *argv[])
+{
+    std::string s("Hammers a running AGILEServe with concurrent clients sending ");
+    s += "random \ninputs, and reports the latency and throughput";
+
+    optionparser::parser p(s);
+
+//----------------------------------------------------------------------------
+    p.add_option("--socket", "-s")  .help("Path of the server's socket. (Default = /tmp/agile.sock)")
+                                    .mode(optionparser::store_value)
+                                    .default_value(std::string("/tmp/agile.sock"));
+//----------------------------------------------------------------------------
+    p.add_option("--clients", "-c") .help("Number of concurrent clients. (Default = 8)")
+                                    .mode(optionparser::store_value)
+                                    .default_value(8);
+//----------------------------------------------------------------------------
+    p.add_option("--requests", "-r") .help("Requests sent by each client. (Default = 10000)")
+                                    .mode(optionparser::store_value)
+                                    .default_value(10000);
+//----------------------------------------------------------------------------
+    p.eat_arguments(argc, argv);
+
+    typedef std::chrono::steady_clock clock;
+
+    std::string path = p.get_value<std::string>("socket");
+    int n_clients = std::max(p.get_value<int>("clients"), 1);
+    int n_requests = std::max(p.get_value<int>("requests"), 1);
+
+    // connect everyone up front, so that isn't part of the timing
+    std::vector<std::unique_ptr<agile::inference_client>> clients;
+    for (int c = 0; c < n_clients; ++c)
+    {
+        try
+        {
+            clients.emplace_back(new agile::inference_client(path));
+        }
+        catch(std::exception &e)
+        {
+            complain(e.what());
+        }
+    }
+
+    // latencies in microseconds of each client's answered requests, and the
+    // error that stopped a client early, if one did
+    std::vector<std::vector<double>> latencies(n_clients);
+    std::vector<std::string> errors(n_clients);
+    std::vector<std::thread> threads;
+
+    auto start = clock::now();
+    for (int c = 0; c < n_clients; ++c)
+    {
+        threads.emplace_back([&, c]()
+        {
+            agile::inference_client &client = *clients[c];
+            std::mt19937 gen(c);
+            std::normal_distribution<double> normal;
+            std::vector<double> in(client.inputs().size()),
+                                out(client.outputs().size());
+            latencies[c].reserve(n_requests);
+            for (int i = 0; i < n_requests; ++i)
+            {
+                for (auto &v : in)
+                {
+                    v = normal(gen);
+                }
+                auto sent = clock::now();
+                try
+                {
+                    client.predict(in.data(), out.data());
+                }
+                catch(std::exception &e)
+                {
+                    // the connection is gone, so the rest aren't sent
+                    errors[c] = e.what();
+                    return;
+                }
+                latencies[c].push_back(
+                    std::chrono::duration<double, std::micro>(clock::now() - sent).count());
+            }
+        });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+    double wall = std::chrono::duration<double>(clock::now() - start).count();
+
+    std::vector<double> latency;
+    int failed = 0;
+    for (int c = 0; c < n_clients; ++c)
+    {
+        latency.insert(latency.end(), latencies[c].begin(), latencies[c].end());
+        if (!errors[c].empty())
+        {
+            ++failed;
+            std::cerr << "client " << c << " failed after "
+                      << latencies[c].size() << " requests: " << errors[c]
+                      << std::endl;
+        }
+    }
+    if (latency.empty())
+    {
+        complain("no requests were answered.");
+    }
+
+    std::sort(latency.begin(), latency.end());
+    auto quantile = [&latency](double q)
+    {
+        return latency[std::min(latency.size() - 1,
+            static_cast<std::size_t>(q * latency.size()))];
+    };
+    double mean = 0.0;
+    for (auto v : latency)
+    {
+        mean += v;
+    }
+    mean /= latency.size();
+
+    std::cout << std::fixed << std::setprecision(1)
+              << n_clients << " clients x " << n_requests << " requests in "
+              << wall << " s" << std::endl
+              << "latency (us): p50 = " << quantile(0.50)
+              << ", p99 = " << quantile(0.99) << ", mean = " << mean
+              << ", max = " << latency.back() << std::endl
+              << "throughput: " << latency.size() / wall << " requests/s" << std::endl;
+    if (failed)
+    {
+        std::cout << failed << " failed requests, " << n_clients * n_requests
+                  - latency.size() - failed << " not sent after them." 
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+void complain(const std::string &complaint)
+{
+    std::cerr << "Error: " << complaint << std::endl;
+    exit(1);
+}
@@ -0,0 +1,319 @@
+#include "Base"
+#include "include/parser.hh"
+#include <chrono>
+
+void complain(const std::string &complaint);
+
+// output format from the file extension, unless one was asked for
+std::string pick_format(const std::string &out, const std::string &format);
+
+//----------------------------------------------------------------------------
+int main(int argc, char const *argv[])
+{
+    std::string s("Scores ROOT TTrees with trained AGILEPack networks, and writes ");
+    s += "the \npredictions and any columns to pass through";
+
+    optionparser::parser p(s + " to a binary frame, CSV or ROOT friend tree");
+
+//----------------------------------------------------------------------------
+    p.add_option("--file", "-f")    .help("Pass at least one file to add to a TChain for scoring.")
+                                    .mode(optionparser::store_mult_values);
+//----------------------------------------------------------------------------
+    p.add_option("--tree", "-t")    .help("Name of the TTree to extract.")
+                                    .mode(optionparser::store_value);
+//----------------------------------------------------------------------------
+    std::string load_help = "Network files (YAML or binary) to score with. Several are\n";
+    load_help.append(25, ' ');
+    load_help += "evaluated together, sharing the inputs they have in common.";
+
+    p.add_option("--load", "-l")    .help(load_help)
+                                    .mode(optionparser::store_mult_values);
+//----------------------------------------------------------------------------
+    std::string names_help = "Column prefix for each --load network. (Default = the file\n";
+    names_help.append(25, ' ');
+    names_help += "names, or the bare output names for a single network)";
+
+    p.add_option("--names")         .help(names_help)
+                                    .mode(optionparser::store_mult_values);
+//----------------------------------------------------------------------------
+    p.add_option("--config", "-c")  .help("Branch config file")
+                                    .mode(optionparser::store_value);
+//----------------------------------------------------------------------------
+    p.add_option("--out", "-o")     .help("File to write the scores to.")
+                                    .mode(optionparser::store_value);
+//----------------------------------------------------------------------------
+    std::string format_help = "One of binary, csv or root. (Default = from the extension\n";
+    format_help.append(25, ' ');
+    format_help += "of --out: .csv, .root, and binary for anything else)";
+
+    p.add_option("--format")        .help(format_help)
+                                    .mode(optionparser::store_value);
+//----------------------------------------------------------------------------
+    p.add_option("--keep", "-k")    .help("Branches to write out next to the scores.")
+                                    .mode(optionparser::store_mult_values);
+//----------------------------------------------------------------------------
+    p.add_option("--out-tree")      .help("Name of the tree written with --format root. (Default = scores)")
+                                    .mode(optionparser::store_value)
+                                    .default_value(std::string("scores"));
+//----------------------------------------------------------------------------
+    std::string threads_help = "Threads to read, score and format with. 0 means one per\n";
+    threads_help.append(25, ' ');
+    threads_help += "core. (Default = 0)";
+
+    p.add_option("--threads", "-j") .help(threads_help)
+                                    .mode(optionparser::store_value)
+                                    .default_value(0);
+//----------------------------------------------------------------------------
+    p.add_option("--cache")         .help("Size in MB of the TTreeCache to read through. (Default = 0)")
+                                    .mode(optionparser::store_value)
+                                    .default_value(0);
+//----------------------------------------------------------------------------
+    std::string chunk_help = "Entries read and scored at a time, so only the scores and\n";
+    chunk_help.append(25, ' ');
+    chunk_help += "--keep columns of the whole range are held. (Default = 1000000)";
+
+    p.add_option("--chunk")         .help(chunk_help)
+                                    .mode(optionparser::store_value)
+                                    .default_value(1000000);
+//----------------------------------------------------------------------------
+    p.add_option("--index")         .help("File to keep the entry count of each ROOT file in.")
+                                    .mode(optionparser::store_value);
+//----------------------------------------------------------------------------
+    p.add_option("--verbose", "-v") .help("Make the output verbose");
+//----------------------------------------------------------------------------
+    p.add_option("-start")          .help("Start index for scoring. (Default = 0)")
+                                    .mode(optionparser::store_value)
+                                    .default_value(0);
+//----------------------------------------------------------------------------
+    p.add_option("-end")            .help("End index for scoring. (Default, whole tree)")
+                                    .mode(optionparser::store_value)
+                                    .default_value(-1);
+//----------------------------------------------------------------------------
+
+    p.eat_arguments(argc, argv);
+
+    if (!p.get_value("file")) complain("need to pass at least one file.");
+
+    if (!p.get_value("tree")) complain("need to pass a tree name.");
+
+    if (!p.get_value("load")) complain("need a neural network to load.");
+
+    if (!p.get_value("config")) complain("need a root branch config file.");
+
+    if (!p.get_value("out")) complain("need a file to write the scores to.");
+
+    std::vector<std::string> root_files(p.get_value<std::vector<std::string>>("file")),
+                             load_files(p.get_value<std::vector<std::string>>("load")),
+                             keep;
+    if (p.get_value("keep"))
+    {
+        keep = p.get_value<std::vector<std::string>>("keep");
+    }
+
+    std::string ttree_name =    p.get_value<std::string>("tree"),
+                config_file =   p.get_value<std::string>("config"),
+                out_file =      p.get_value<std::string>("out"),
+                out_tree =      p.get_value<std::string>("outtree"),
+                format =        pick_format(out_file, p.get_value("format") ?
+                                    p.get_value<std::string>("format") : "");
+
+    int     start =       p.get_value<int>("start"),
+            end =         p.get_value<int>("end"),
+            threads =     p.get_value<int>("threads"),
+            cache =       p.get_value<int>("cache"),
+            chunk =       p.get_value<int>("chunk");
+
+    bool    verbose =     p.get_value("verbose");
+
+    if (chunk <= 0) complain("--chunk must be positive.");
+
+    typedef std::chrono::steady_clock clock;
+    auto seconds_since = [](clock::time_point t)
+    {
+        return std::chrono::duration<double>(clock::now() - t).count();
+    };
+
+//----------------------------------------------------------------------------
+
+    agile::model_set models;
+    if (p.get_value("names"))
+    {
+        auto names = p.get_value<std::vector<std::string>>("names");
+        if (names.size() != load_files.size())
+        {
+            complain("need one name per network.");
+        }
+        for (std::size_t i = 0; i < load_files.size(); ++i)
+        {
+            models.add(load_files[i], names[i]);
+        }
+    }
+    else if (load_files.size() == 1)
+    {
+        models.add(load_files[0], "");
+    }
+    else
+    {
+        for (auto &file : load_files)
+        {
+            models.add(file);
+        }
+    }
+
+    agile::root::tree_reader TR;
+    TR.set_threads(threads);
+    if (p.get_value("index"))
+    {
+        TR.set_index(p.get_value<std::string>("index"));
+    }
+    for (auto &file : root_files)
+    {
+       TR.add_file(file, ttree_name);
+    }
+
+    // only read the branches the networks and the passthrough columns need
+    std::string needed("~");
+    for (auto &name : models.inputs())
+    {
+        needed += name + "+";
+    }
+    for (auto &name : keep)
+    {
+        needed += name + "+";
+    }
+    needed.pop_back();
+
+    TR.set_branches(config_file, needed);
+    if (cache > 0)
+    {
+        TR.set_cache(cache * 1024LL * 1024LL);
+    }
+
+//----------------------------------------------------------------------------
+    // -end past the chain (or the default -1) means up to the last entry
+    const long long total = TR.size();
+    if ((start < 0) || (start > total))
+    {
+        complain("-start is outside the tree.");
+    }
+    const long long stop = ((end < 0) || (end > total)) ? total : end;
+    if (stop < start)
+    {
+        complain("-end comes before -start.");
+    }
+
+    // the range is read and scored a chunk at a time, and only the scores 
+    // and passthrough columns of each chunk are kept. The derived inputs and
+    // scaling the networks share are done once per tile, and the tiles are
+    // shared out over the threads.
+    std::vector<agile::dataframe> parts;
+    agile::root::extraction_report report;
+    double read_time = 0.0, score_time = 0.0;
+    long long first = start;
+    do
+    {
+        const int entries = std::min<long long>(chunk, stop - first);
+        auto t = clock::now();
+        agile::dataframe D = TR.get_dataframe(entries, first, verbose);
+        read_time += seconds_since(t);
+
+        const auto &last = TR.last_extraction();
+        report.entries_read += last.entries_read;
+        report.entries_kept += last.entries_kept;
+        report.bytes_read += last.bytes_read;
+        report.file_bytes_read += last.file_bytes_read;
+        report.read_calls += last.read_calls;
+        report.seconds += last.seconds;
+
+        t = clock::now();
+        agile::dataframe scores = models.predict(D, 4096, threads);
+        for (auto &name : keep)
+        {
+            scores.add_column(name, D.get_column(name));
+        }
+        parts.push_back(std::move(scores));
+        score_time += seconds_since(t);
+        first += entries;
+    } while (first < stop);
+
+    agile::dataframe scores = agile::concatenate(parts);
+    parts.clear();
+
+    if (format == "root")
+    {
+        if (report.entries_kept != report.entries_read)
+        {
+            std::cerr << "Warning: the config's constraints dropped "
+                      << report.entries_read - report.entries_kept 
+                      << " entries, so " << out_file << " can't be used as"
+                      << " a friend of the original tree." << std::endl;
+        }
+        if (start > 0)
+        {
+            std::cerr << "Warning: scoring starts at entry " << start 
+                      << ", so " << out_file << " can't be used as a friend"
+                      << " of the original tree." << std::endl;
+        }
+    }
+
+//----------------------------------------------------------------------------
+    auto t = clock::now();
+    if (format == "csv")
+    {
+        scores.to_csv(out_file);
+    }
+    else if (format == "root")
+    {
+        agile::root::write_tree(scores, out_file, out_tree);
+    }
+    else
+    {
+        scores.to_binary(out_file);
+    }
+    double write_time = seconds_since(t);
+
+    std::cout << "Scored " << scores.rows() << " entries into " << out_file
+              << " (" << format << "): read " << read_time << " s, scored "
+              << score_time << " s, wrote " << write_time << " s." << std::endl;
+    if (verbose)
+    {
+        std::cout << models.size() << " networks on " << models.inputs().size()
+                  << " branches, computing " << models.shared_inputs()
+                  << " scaled inputs for the " << models.total_inputs()
+                  << " they take." << std::endl;
+        std::cout << report << std::endl;
+    }
+    return 0;
+}
+
+std::string pick_format(const std::string &out, const std::string &format)
+{
+    if (!format.empty())
+    {
+        if ((format != "binary") && (format != "csv") && (format != "root"))
+        {
+            complain("format must be one of binary, csv or root.");
+        }
+        return format;
+    }
+    auto ends_with = [&out](const std::string &ext)
+    {
+        return (out.size() >= ext.size()) &&
+            (out.compare(out.size() - ext.size(), ext.size(), ext) == 0);
+    };
+    if (ends_with(".csv"))
+    {
+        return "csv";
+    }
+    if (ends_with(".root"))
+    {
+        return "root";
+    }
+    return "binary";
+}
+
+void complain(const std::string &complaint)
+{
+    std::cerr << "Error: " << complaint << std::endl;
+    exit(1);
+}
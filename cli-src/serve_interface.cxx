@@ -0,0 +1,70 @@
+#include "include/inference_server.hh"
+#include "include/parser.hh"
+#include <csignal>
+
+void complain(const std::string &complaint);
+
+//----------------------------------------------------------------------------
+int main(int argc, char const *argv[])
+{
+    std::string s("Serves a trained AGILEPack network to local clients over a ");
+    s += "Unix domain \nsocket, scoring concurrent requests in micro-batches";
+
+    optionparser::parser p(s);
+
+//----------------------------------------------------------------------------
+    p.add_option("--net", "-n")     .help("Network file (YAML or binary) to serve.")
+                                    .mode(optionparser::store_value);
+//----------------------------------------------------------------------------
+    p.add_option("--socket", "-s")  .help("Path of the socket to listen on. (Default = /tmp/agile.sock)")
+                                    .mode(optionparser::store_value)
+                                    .default_value(std::string("/tmp/agile.sock"));
+//----------------------------------------------------------------------------
+    p.add_option("--batch", "-b")   .help("Most requests scored together. (Default = 64)")
+                                    .mode(optionparser::store_value)
+                                    .default_value(64);
+//----------------------------------------------------------------------------
+    std::string deadline_help = "Microseconds the oldest request waits for a batch\n";
+    deadline_help.append(25, ' ');
+    deadline_help += "to fill up. (Default = 200)";
+
+    p.add_option("--deadline", "-d") .help(deadline_help)
+                                    .mode(optionparser::store_value)
+                                    .default_value(200);
+//----------------------------------------------------------------------------
+    p.eat_arguments(argc, argv);
+
+    if (!p.get_value("net")) complain("need a network file to serve.");
+
+    // the server's threads inherit this mask, so only sigwait sees these
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    std::string path = p.get_value<std::string>("socket");
+
+    agile::inference_server server(p.get_value<std::string>("net"));
+    server.set_max_batch(p.get_value<int>("batch"))
+          .set_deadline(std::chrono::microseconds(p.get_value<int>("deadline")));
+    server.start(path);
+
+    std::cout << "Serving " << server.inputs().size() << " inputs -> "
+              << server.outputs().size() << " outputs on " << path
+              << " (Ctrl-C to stop)." << std::endl;
+
+    int sig;
+    sigwait(&signals, &sig);
+    server.stop();
+
+    std::cout << "\nAnswered " << server.requests() << " requests in "
+              << server.batches() << " batches." << std::endl;
+    return 0;
+}
+
+void complain(const std::string &complaint)
+{
+    std::cerr << "Error: " << complaint << std::endl;
+    exit(1);
+}
@@ -112,6 +112,53 @@ int main(int argc, char const *argv[])
 //----------------------------------------------------------------------------
     p.add_option("--formula", "-F") .help("Specify Model Formula")
                                     .mode(optionparser::store_value);
+//----------------------------------------------------------------------------
+    std::string dump_help = "Write the extracted dataset to a binary frame that can be\n";
+    dump_help.append(25, ' ');
+    dump_help += "reloaded with agile::dataframe::from_binary().";
+
+    p.add_option("--dump")          .help(dump_help)
+                                    .mode(optionparser::store_value);
+//----------------------------------------------------------------------------
+    std::string threads_help = "Threads to read the ROOT files with, each on its own\n";
+    threads_help.append(25, ' ');
+    threads_help += "range of entries. 0 means one per core. (Default = 1)";
+
+    p.add_option("--threads", "-j") .help(threads_help)
+                                    .mode(optionparser::store_value)
+                                    .default_value(1);
+//----------------------------------------------------------------------------
+    std::string cache_help = "Size in MB of the TTreeCache to read the ROOT files through.\n";
+    cache_help.append(25, ' ');
+    cache_help += "0 turns it off. (Default = 0)";
+
+    p.add_option("--cache")         .help(cache_help)
+                                    .mode(optionparser::store_value)
+                                    .default_value(0);
+//----------------------------------------------------------------------------
+    std::string index_help = "File to keep the entry count of each ROOT file in, so later\n";
+    index_help.append(25, ' ');
+    index_help += "runs over the same files start without opening them.";
+
+    p.add_option("--index")         .help(index_help)
+                                    .mode(optionparser::store_value);
+//----------------------------------------------------------------------------
+    std::string cache_dir_help = "Directory to keep extracted datasets in. A later run over the\n";
+    cache_dir_help.append(25, ' ');
+    cache_dir_help += "same files, branches and entries loads them from there.";
+
+    p.add_option("--cache-dir")     .help(cache_dir_help)
+                                    .mode(optionparser::store_value);
+//----------------------------------------------------------------------------
+    p.add_option("--prefetch")      .help("Prefetch baskets for the TTreeCache asynchronously.");
+//----------------------------------------------------------------------------
+    p.add_option("--io-stats")      .help("Report bytes, baskets and time read for each branch.");
+//----------------------------------------------------------------------------
+    std::string fold_help = "Fold the input scaling into the first layer before saving, so\n";
+    fold_help.append(25, ' ');
+    fold_help += "the saved network takes raw inputs.";
+
+    p.add_option("--fold-scaling")  .help(fold_help);
 //----------------------------------------------------------------------------
     p.eat_arguments(argc, argv);
 
@@ -148,7 +195,9 @@ int main(int argc, char const *argv[])
             uepochs =      p.get_value<int>("uepochs"),
             sepochs =      p.get_value<int>("sepochs"),
             batch =       p.get_value<int>("batch"),
-            prog =        p.get_value<int>("prog");
+            prog =        p.get_value<int>("prog"),
+            threads =     p.get_value<int>("threads"),
+            cache =       p.get_value<int>("cache");
 
     bool    verbose =     p.get_value("verbose");
 
@@ -163,22 +212,43 @@ int main(int argc, char const *argv[])
 
     agile::root::tree_reader TR;
 
+    // has to be on before the files are opened
+    TR.set_prefetch(p.get_value("prefetch"));
+    TR.set_threads(threads);
+    if (p.get_value("index"))
+    {
+        TR.set_index(p.get_value<std::string>("index"));
+    }
+    if (p.get_value("cachedir"))
+    {
+        TR.set_dataset_cache(p.get_value<std::string>("cachedir"));
+    }
 
     for (auto &file : root_files)
     {
        TR.add_file(file, ttree_name);
     }
 
-    TR.set_branches(config_file);
+    // only read the branches the formula needs
+    TR.set_branches(config_file, model_formula);
+    if (cache > 0)
+    {
+        TR.set_cache(cache * 1024LL * 1024LL);
+    }
+    TR.set_branch_stats(p.get_value("iostats"));
 
 //----------------------------------------------------------------------------
     agile::dataframe D = TR.get_dataframe(end - start, start, verbose);
 
-    std::ofstream dframe("testfram.csv");
-   
-    dframe << D;
+    if (p.get_value("iostats") && !verbose)
+    {
+        std::cout << TR.last_extraction() << std::endl;
+    }
 
-    dframe.close();
+    if (p.get_value("dump"))
+    {
+        D.to_binary(p.get_value<std::string>("dump"));
+    }
 
     agile::neural_net net;
     net.add_data(D);
@@ -245,6 +315,15 @@ int main(int argc, char const *argv[])
         std::cout << "\nPerforming Supervised Training...\n";
     }
     net.train_supervised(sepochs, verbose);
+    if (p.get_value("foldscaling"))
+    {
+        double deviation = net.fold_scaling();
+        if (verbose)
+        {
+            std::cout << "\nFolded scaling into the first layer (largest ";
+            std::cout << "deviation " << deviation << ").";
+        }
+    }
     if (verbose)
     {
         std::cout << "\nDone.\nSaving to " << save_file << "...";
@@ -2,5 +2,8 @@
 #define DATAFRAME__CORE__HH 
 
 #include "include/dataframe.hh"
+#include "include/binary_frame.hh"
+#include "include/expression.hh"
+#include "include/formula.hh"
 
 #endif
\ No newline at end of file
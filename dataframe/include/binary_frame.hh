@@ -0,0 +1,146 @@
+//-----------------------------------------------------------------------------
+//  binary_frame.hh:
+//  Header for the native binary columnar dataset format, and a reader that
+//  memory maps it and hands out zero-copy Eigen views of the columns
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef BINARY__FRAME__HH
+#define BINARY__FRAME__HH
+
+#include "mapped_file.hh"
+#include "column.hh"
+#include <Eigen/Dense>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace agile
+{
+
+class dataframe;
+
+//-----------------------------------------------------------------------------
+//  Layout of a binary frame (all integers little endian):
+//
+//      char[8]   magic ("AGILEDF" + NUL)
+//      uint32    format version
+//      uint32    number of columns
+//      uint64    number of rows
+//      uint32    flags (bit 0 set if per column scaling stats are present)
+//      uint32    offset of the first data block
+//
+//  followed by one descriptor per column
+//
+//      uint8     column_type, then 3 bytes of padding
+//      uint32    length of the column name
+//      uint64    offset of the column data from the start of the file
+//      float64   mean, float64 sd (only meaningful if flag bit 0 is set)
+//      char[]    column name (not NUL terminated)
+//
+//  Every column is stored contiguously, and starts on a 64 byte boundary so
+//  that it can be used in place by Eigen.
+//-----------------------------------------------------------------------------
+namespace binary_format
+{
+    const char magic[8] = {'A', 'G', 'I', 'L', 'E', 'D', 'F', '\0'};
+    const std::uint32_t version = 1;
+    const std::uint32_t has_scaling = 1;
+    const std::size_t alignment = 64;
+}
+
+//-----------------------------------------------------------------------------
+//  Writes a set of columns to disk. The column pointers must each have
+//  rows * type_size(types[i]) bytes available.
+//-----------------------------------------------------------------------------
+struct binary_column
+{
+    std::string name;
+    column_type type;
+    const void *data;
+    double mean, sd;
+};
+
+void write_binary_frame(const std::string &filename, std::size_t rows,
+    const std::vector<binary_column> &columns, bool scaled = false);
+
+//-----------------------------------------------------------------------------
+//  mapped_frame -- read-only memory mapped view of a binary frame
+//-----------------------------------------------------------------------------
+class mapped_frame
+{
+public:
+    template <typename T>
+    using column_map = Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, 1>,
+        Eigen::Aligned>;
+
+    explicit mapped_frame(const std::string &filename = "");
+
+    void open(const std::string &filename);
+    void close();
+    bool is_open() const { return m_file.data() != nullptr; }
+
+//-----------------------------------------------------------------------------
+//  Size / other Information
+//-----------------------------------------------------------------------------
+    std::size_t rows() const { return m_rows; }
+    std::size_t columns() const { return m_names.size(); }
+    std::vector<std::string> get_column_names() const { return m_names; }
+    std::size_t get_column_idx(const std::string &name) const;
+    column_type get_column_type(std::size_t idx) const;
+
+    bool has_scaling() const { return m_scaled; }
+    std::map<std::string, double> get_mean() const;
+    std::map<std::string, double> get_sd() const;
+
+//-----------------------------------------------------------------------------
+//  Element Access (no copies -- the maps point straight into the file)
+//-----------------------------------------------------------------------------
+    template <typename T>
+    column_map<T> column(const std::string &name) const;
+
+    template <typename T>
+    column_map<T> column(std::size_t idx) const;
+
+    const void* column_data(std::size_t idx) const;
+
+    double value(std::size_t row, std::size_t col) const;
+
+    agile::dataframe to_dataframe() const;
+
+private:
+    mapped_file m_file;
+    std::size_t m_rows;
+    bool m_scaled;
+
+    std::vector<std::string> m_names;
+    std::vector<column_type> m_types;
+    std::vector<std::size_t> m_offsets;
+    std::vector<double> m_mean, m_sd;
+    std::map<std::string, std::size_t> m_index;
+};
+
+//----------------------------------------------------------------------------
+template <typename T>
+mapped_frame::column_map<T> mapped_frame::column(std::size_t idx) const
+{
+    if (get_column_type(idx) != column_traits<T>::type)
+    {
+        throw std::domain_error("column \'" + m_names[idx] + "\' is stored as "
+            + type_name(m_types[idx]) + ", not as requested type.");
+    }
+    return column_map<T>(static_cast<const T*>(column_data(idx)), m_rows);
+}
+//----------------------------------------------------------------------------
+template <typename T>
+mapped_frame::column_map<T> mapped_frame::column(const std::string &name) const
+{
+    return column<T>(get_column_idx(name));
+}
+
+}
+
+#endif
@@ -0,0 +1,59 @@
+//-----------------------------------------------------------------------------
+//  checks.hh:
+//  Header for the small check helpers shared by the *_test programs
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef CHECKS__HH
+#define CHECKS__HH
+
+#include <cmath>
+#include <iostream>
+#include <string>
+
+namespace agile
+{
+namespace checks
+{
+
+// how many checks have failed so far
+inline int& failures()
+{
+    static int n = 0;
+    return n;
+}
+//----------------------------------------------------------------------------
+inline void check(bool ok, const std::string &what)
+{
+    if (!ok)
+    {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++failures();
+    }
+}
+//----------------------------------------------------------------------------
+// |a - b| <= tol, failing on NaN
+inline void check_close(double a, double b, double tol, 
+    const std::string &what)
+{
+    check(std::fabs(a - b) <= tol, what + " (" + std::to_string(a) + 
+        " vs " + std::to_string(b) + ")");
+}
+//----------------------------------------------------------------------------
+// prints the outcome, and gives the exit code for main() to return
+inline int report(const std::string &test)
+{
+    if (failures())
+    {
+        std::cerr << test << ": " << failures() << " checks failed." 
+                  << std::endl;
+        return 1;
+    }
+    std::cout << test << ": all checks passed." << std::endl;
+    return 0;
+}
+
+}
+}
+
+#endif
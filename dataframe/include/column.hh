@@ -0,0 +1,301 @@
+//-----------------------------------------------------------------------------
+//  column.hh:
+//  Header for typed, chunked column storage used by the dataframe
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef COLUMN__HH
+#define COLUMN__HH
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace agile
+{
+
+//----------------------------------------------------------------------------
+//  Numeric types a column can be stored as
+//----------------------------------------------------------------------------
+enum column_type { int8, int16, int32, float32, float64 };
+
+std::size_t type_size(column_type type);
+std::string type_name(column_type type);
+
+// the narrowest type that can hold everything either of a or b can
+column_type common_type(column_type a, column_type b);
+
+//----------------------------------------------------------------------------
+//  Compile time mapping from C++ types to column types
+//----------------------------------------------------------------------------
+template <typename T> struct column_traits;
+
+template <> struct column_traits<std::int8_t>
+{
+    static const column_type type = int8;
+};
+template <> struct column_traits<std::int16_t>
+{
+    static const column_type type = int16;
+};
+template <> struct column_traits<std::int32_t>
+{
+    static const column_type type = int32;
+};
+template <> struct column_traits<float>
+{
+    static const column_type type = float32;
+};
+template <> struct column_traits<double>
+{
+    static const column_type type = float64;
+};
+
+//----------------------------------------------------------------------------
+//  A column resolved once from its name, so that per row access is a plain
+//  index instead of a name lookup. Handles stay valid as long as no columns
+//  are added to or removed from the dataframe they came from.
+//----------------------------------------------------------------------------
+struct column_handle
+{
+    std::size_t idx;
+    column_type type;
+};
+
+//-----------------------------------------------------------------------------
+//  column -- one variable, stored as its own numeric type in a list of
+//  contiguous chunks. Chunks are shared between columns when appending or
+//  copying, and are only cloned when a shared chunk is written to, so
+//  append() and concatenation are O(number of chunks), not O(rows).
+//  compact() merges everything into one chunk for consumers that need a
+//  single contiguous block.
+//-----------------------------------------------------------------------------
+class column
+{
+public:
+    explicit column(column_type type = float64, std::size_t n = 0);
+
+    column_type type() const { return m_type; }
+    std::size_t size() const { return m_size; }
+    std::size_t bytes() const { return m_size * type_size(m_type); }
+
+    void reserve(std::size_t n);
+    void resize(std::size_t n);
+    void clear();
+
+//-----------------------------------------------------------------------------
+//  Element Access (set() and push_back() turn the column into float64 first
+//  if its type can't hold val, as when a narrowed column gets a fraction
+//  or a value past its range)
+//-----------------------------------------------------------------------------
+    inline double get(std::size_t idx) const;
+    inline void set(std::size_t idx, double val);
+    inline void push_back(double val);
+
+    // whether a column of the given type stores val exactly (or, for
+    // float32, without overflowing)
+    static inline bool holds(column_type type, double val);
+
+//-----------------------------------------------------------------------------
+//  Chunk access
+//-----------------------------------------------------------------------------
+    std::size_t chunks() const { return m_chunks.size(); }
+    const void* chunk_data(std::size_t i) const;
+    std::size_t chunk_size(std::size_t i) const { return m_chunks[i].rows; }
+
+    bool contiguous() const { return m_chunks.size() <= 1; }
+
+    // merges all chunks into one, copying only if there's more than one
+    void compact();
+
+//-----------------------------------------------------------------------------
+//  Bulk access (these need a contiguous column -- the non-const versions
+//  compact() first, the const versions throw if there's more than one chunk)
+//-----------------------------------------------------------------------------
+    template <typename T>
+    T* data();
+
+    template <typename T>
+    const T* data() const;
+
+    void* raw();
+    const void* raw() const;
+
+    // converts [first, first + n) to double, in one linear pass
+    void copy_to(double *out, std::size_t first, std::size_t n) const;
+    void copy_to(double *out) const { copy_to(out, 0, m_size); }
+
+    // appends n values of the given type, converting if needed
+    void append(const void *values, column_type type, std::size_t n);
+
+    // splices the chunks of C onto this column if the types match,
+    // otherwise converts a copy
+    void append(const column &C);
+
+//-----------------------------------------------------------------------------
+//  Type manipulation
+//-----------------------------------------------------------------------------
+    void convert(column_type type);
+
+    // for integer columns, the narrowest integer type that holds every
+    // value. Floating point columns are returned as is.
+    column_type narrowest() const;
+
+private:
+    typedef std::vector<char> buffer;
+
+    struct chunk
+    {
+        std::shared_ptr<buffer> data;
+        std::size_t rows;
+    };
+
+    template <typename T>
+    static inline bool holds_int(double val);
+
+    inline std::size_t find_chunk(std::size_t idx) const;
+    static inline double value_at(const char *base, column_type type,
+        std::size_t idx);
+    static inline void store(char *base, column_type type, std::size_t idx,
+        double val);
+
+    // makes sure the chunk isn't shared before writing to it
+    void detach(chunk &c);
+
+    // a tail chunk with room for n more rows that nobody else references
+    chunk& writable_tail(std::size_t n);
+
+    column_type m_type;
+    std::size_t m_size;
+    std::vector<chunk> m_chunks;
+    std::vector<std::size_t> m_starts; // first row of each chunk
+};
+
+//----------------------------------------------------------------------------
+inline std::size_t column::find_chunk(std::size_t idx) const
+{
+    if (m_chunks.size() == 1)
+    {
+        return 0;
+    }
+    return std::upper_bound(m_starts.begin(), m_starts.end(), idx)
+        - m_starts.begin() - 1;
+}
+//----------------------------------------------------------------------------
+inline double column::value_at(const char *base, column_type type,
+    std::size_t idx)
+{
+    switch(type)
+    {
+        case int8: return reinterpret_cast<const std::int8_t*>(base)[idx];
+        case int16: return reinterpret_cast<const std::int16_t*>(base)[idx];
+        case int32: return reinterpret_cast<const std::int32_t*>(base)[idx];
+        case float32: return reinterpret_cast<const float*>(base)[idx];
+        case float64: return reinterpret_cast<const double*>(base)[idx];
+    }
+    throw std::domain_error("unrecognized column type.");
+}
+//----------------------------------------------------------------------------
+inline void column::store(char *base, column_type type, std::size_t idx,
+    double val)
+{
+    switch(type)
+    {
+        case int8: reinterpret_cast<std::int8_t*>(base)[idx] =
+            static_cast<std::int8_t>(val);
+            break;
+        case int16: reinterpret_cast<std::int16_t*>(base)[idx] =
+            static_cast<std::int16_t>(val);
+            break;
+        case int32: reinterpret_cast<std::int32_t*>(base)[idx] =
+            static_cast<std::int32_t>(val);
+            break;
+        case float32: reinterpret_cast<float*>(base)[idx] =
+            static_cast<float>(val);
+            break;
+        case float64: reinterpret_cast<double*>(base)[idx] = val;
+            break;
+    }
+}
+//----------------------------------------------------------------------------
+template <typename T>
+inline bool column::holds_int(double val)
+{
+    return (val >= std::numeric_limits<T>::min()) &&
+        (val <= std::numeric_limits<T>::max()) && (val == std::floor(val));
+}
+//----------------------------------------------------------------------------
+inline bool column::holds(column_type type, double val)
+{
+    switch(type)
+    {
+        case int8: return holds_int<std::int8_t>(val);
+        case int16: return holds_int<std::int16_t>(val);
+        case int32: return holds_int<std::int32_t>(val);
+        case float32: return std::isinf(val) || 
+            !(std::fabs(val) > std::numeric_limits<float>::max());
+        case float64: return true;
+    }
+    throw std::domain_error("unrecognized column type.");
+}
+//----------------------------------------------------------------------------
+inline double column::get(std::size_t idx) const
+{
+    std::size_t c = find_chunk(idx);
+    return value_at(m_chunks[c].data->data(), m_type, idx - m_starts[c]);
+}
+//----------------------------------------------------------------------------
+inline void column::set(std::size_t idx, double val)
+{
+    if (!holds(m_type, val))
+    {
+        convert(float64);
+    }
+    std::size_t c = find_chunk(idx);
+    detach(m_chunks[c]);
+    store(m_chunks[c].data->data(), m_type, idx - m_starts[c], val);
+}
+//----------------------------------------------------------------------------
+inline void column::push_back(double val)
+{
+    if (!holds(m_type, val))
+    {
+        convert(float64);
+    }
+    chunk &tail = writable_tail(1);
+    store(tail.data->data(), m_type, tail.rows, val);
+    ++tail.rows;
+    ++m_size;
+}
+//----------------------------------------------------------------------------
+template <typename T>
+T* column::data()
+{
+    if (column_traits<T>::type != m_type)
+    {
+        throw std::domain_error("column is stored as " + type_name(m_type)
+            + ", not as the requested type.");
+    }
+    return static_cast<T*>(raw());
+}
+//----------------------------------------------------------------------------
+template <typename T>
+const T* column::data() const
+{
+    if (column_traits<T>::type != m_type)
+    {
+        throw std::domain_error("column is stored as " + type_name(m_type)
+            + ", not as the requested type.");
+    }
+    return static_cast<const T*>(raw());
+}
+
+}
+
+#endif
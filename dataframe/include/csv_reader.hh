@@ -7,6 +7,7 @@
 #ifndef CSV__READER__HH
 #define CSV__READER__HH 
 
+#include "parallel.hh"
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -26,6 +27,29 @@ typedef std::vector <record_t> data_t;
 std::istream& operator >> ( std::istream& ins, record_t& record );
 std::istream& operator >> ( std::istream& ins, data_t& data );
 
+// bulk, multi-threaded csv reading and writing
+//----------------------------------------------------------------------------
+struct csv_columns
+{
+    std::vector<std::string> names;        // empty if there was no header
+    std::vector<std::vector<double>> data; // one contiguous vector per column
+    std::size_t rows;
+};
+
+// memory maps the file, splits it into line aligned chunks, and parses the 
+// chunks in parallel straight into preallocated columns. n_threads = 0 means
+// one thread per hardware core. A row with more or fewer fields than the
+// header (or the first row) throws a std::runtime_error giving its line.
+csv_columns read_csv(const std::string &filename, bool colnames = false, 
+    unsigned int n_threads = 0);
+
+// formats row blocks in parallel and writes them out in order. Values are 
+// written with the fewest digits (up to 17) that read back exactly.
+void write_csv(const std::string &filename, 
+    const std::vector<std::string> &names, 
+    const std::vector<const double*> &columns, std::size_t rows, 
+    unsigned int n_threads = 0);
+
 // Some string manip utility functions
 //----------------------------------------------------------------------------
 std::string trim(const std::string& str, const std::string& whitespace = " ");
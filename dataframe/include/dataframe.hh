@@ -7,6 +7,8 @@
 #define DATAFRAME__HH 
 
 #include "csv_reader.hh"
+#include "column.hh"
+#include "statistics.hh"
 #include <cstddef>
 #include <map>
 #include <utility>
@@ -41,29 +43,90 @@ public:
 
     void from_csv(std::string filename, bool colnames = false);
     void to_csv(std::string filename, bool write_colnames = true);
-    friend std::ostream& operator << ( std::ostream& os, dataframe &data );
 
-    data_t& raw();
+    void from_binary(std::string filename);
+    void to_binary(std::string filename);
+    void to_binary(std::string filename, 
+        const std::map<std::string, double> &mean, 
+        const std::map<std::string, double> &sd);
+    friend std::ostream& operator << ( std::ostream& os, dataframe &data );
 
 //-----------------------------------------------------------------------------
 //  Size / other Information
 //-----------------------------------------------------------------------------
-    std::size_t rows();
-    std::size_t columns();
-    std::vector<std::string> get_column_names();
-    std::size_t get_column_idx(const std::string &name);
+    std::size_t rows() const;
+    std::size_t columns() const;
+    std::size_t bytes() const;
+    std::vector<std::string> get_column_names() const;
+    std::size_t get_column_idx(const std::string &name) const;
     void set_column_names(std::vector<std::string> v);
 
+    column_type get_column_type(std::size_t idx) const;
+    void set_column_type(std::size_t idx, column_type type);
+    void set_column_type(const std::string &name, column_type type);
+
+    // stores every integer column in the narrowest type that holds it. A
+    // later set() of a value that type can't hold makes it float64 again.
+    void narrow();
+
+    // append() splices column chunks rather than copying them -- this
+    // merges each column back into a single contiguous block
+    void compact();
 
 //-----------------------------------------------------------------------------
-//  Element Access
+//  Element Access (rows are assembled on the fly from the columns)
 //-----------------------------------------------------------------------------
 
-    record_t& at(const std::size_t &idx);
+    record_t at(const std::size_t &idx) const;
+
+    double at(const std::size_t &idx, const std::string &colname) const;
+    std::map<std::string, double> at(const std::size_t &idx, const std::vector<std::string> cols) const;
+    record_t operator[](const std::size_t &idx) const;
 
-    double& at(const std::size_t &idx, const std::string &colname);
-    std::map<std::string, double> at(const std::size_t &idx, const std::vector<std::string> cols);
-    record_t& operator[](const std::size_t &idx);
+    void set(const std::size_t &idx, const std::string &colname, double val);
+
+//-----------------------------------------------------------------------------
+//  Handle based access (resolve names once, then no lookups per row)
+//-----------------------------------------------------------------------------
+
+    column_handle handle(const std::string &name) const;
+    std::vector<column_handle> handles(
+        const std::vector<std::string> &names) const;
+
+    double at(const std::size_t &idx, const column_handle &h) const;
+
+    // writes the values of the handled columns at row idx to out
+    void at(const std::size_t &idx, const std::vector<column_handle> &h,
+        double *out) const;
+
+    class row_view
+    {
+    public:
+        row_view(const dataframe &D, std::size_t idx) : m_D(&D), m_idx(idx) {}
+        double operator[](const column_handle &h) const
+        {
+            return m_D->m_columns[h.idx].get(m_idx);
+        }
+        std::size_t index() const { return m_idx; }
+    private:
+        const dataframe *m_D;
+        std::size_t m_idx;
+    };
+
+    row_view row(const std::size_t &idx) const;
+
+//-----------------------------------------------------------------------------
+//  Column Access
+//-----------------------------------------------------------------------------
+
+    agile::column& get_column(std::size_t idx);
+    const agile::column& get_column(std::size_t idx) const;
+    const agile::column& get_column(const std::string &name) const;
+
+    // writes rows() doubles to out, converting from the stored type
+    void copy_column(std::size_t idx, double *out) const;
+
+    void add_column(const std::string &name, agile::column C);
 
 //-----------------------------------------------------------------------------
 //  Additions
@@ -80,19 +143,31 @@ public:
 //  Scaling
 //-----------------------------------------------------------------------------
 
-    void scale();
+    // standardizes every column to mean 0, sd 1 (constant columns are only
+    // centered), converting them to double. Returns the statistics used.
+    std::vector<column_stats> scale(unsigned int n_threads = 0);
+    bool is_scaled() const { return m_scaled; }
 
 private:
+    void check_dimension(std::size_t n) const;
+    void check_row(std::size_t idx) const;
+
 //-----------------------------------------------------------------------------
 //  Private data fields
 //-----------------------------------------------------------------------------
     std::map<std::string, std::size_t> column_names;
-    data_t data;
+    std::vector<agile::column> m_columns;
     
     bool m_columns_set, m_scaled;
     std::size_t m_cols, m_rows;
 };
 
+//-----------------------------------------------------------------------------
+//  Stacks dataframes with the same columns on top of each other. Like 
+//  append(), this shares the column chunks instead of copying rows.
+//-----------------------------------------------------------------------------
+dataframe concatenate(const std::vector<dataframe> &frames);
+
 }
 //-----------------------------------------------------------------------------
 //  For invalid appending
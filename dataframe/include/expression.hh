@@ -0,0 +1,108 @@
+//-----------------------------------------------------------------------------
+//  expression.hh:
+//  Header for arithmetic expressions over columns (derived variables), which
+//  are compiled once into a small stack bytecode and evaluated in blocks
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef EXPRESSION__HH
+#define EXPRESSION__HH
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace agile
+{
+
+class dataframe;
+
+//-----------------------------------------------------------------------------
+//  expression -- something like "log(m) / abs(eta)" or "tau2 / tau1".
+//  Supports numbers, variable names, + - * /, unary minus, parentheses and
+//  the functions abs, log, exp, sqrt and I (the identity, as in R formulas).
+//  Syntax errors throw std::invalid_argument.
+//-----------------------------------------------------------------------------
+class expression
+{
+public:
+    expression();
+    explicit expression(const std::string &source);
+
+    const std::string& source() const { return m_source; }
+
+    // the variables the expression reads, in order of first appearance
+    const std::vector<std::string>& variables() const { return m_variables; }
+
+    // true if the whole expression is one variable name
+    bool is_variable() const;
+
+    // by default, value i passed to the evaluators below is variables()[i].
+    // bind() makes variable v read position k instead, where names[k] is
+    // its name, so that values can be passed in any (larger) layout.
+    void bind(const std::vector<std::string> &names);
+
+//-----------------------------------------------------------------------------
+//  Evaluation
+//-----------------------------------------------------------------------------
+    // one row, where values[k] is the k-th bound variable
+    double operator()(const double *values) const;
+
+    // what evaluate() works in. A thread calling it over and over should
+    // keep one and pass it in, so nothing is allocated per call. Any
+    // expression can use it, but only one thread at a time.
+    struct scratch
+    {
+        std::vector<double> registers;
+        std::vector<const double*> stack;
+    };
+
+    // n rows, where columns[k] points to n values of the k-th bound variable
+    void evaluate(const double * const *columns, std::size_t n,
+        double *out) const;
+    void evaluate(const double * const *columns, std::size_t n,
+        double *out, scratch &work) const;
+
+    // every row of a dataframe (looked up by name, ignoring bind()), split
+    // into one range of rows per thread
+    void evaluate(const dataframe &D, double *out,
+        unsigned int n_threads = 0) const;
+
+    // C++ source computing the same thing as operator(), with the k-th 
+    // bound variable read as array[k] (for generating code)
+    std::string to_code(const std::string &array = "values") const;
+
+private:
+    enum opcode { load, constant, add, subtract, multiply, divide, negate,
+        absolute, logarithm, exponential, square_root };
+
+    struct instruction
+    {
+        opcode op;
+        std::size_t var;
+        double value;
+    };
+
+    // recursive descent parser, emitting postfix code as it goes
+    void parse_sum(std::size_t &pos);
+    void parse_product(std::size_t &pos);
+    void parse_unary(std::size_t &pos);
+    void parse_primary(std::size_t &pos);
+    void emit(opcode op, std::size_t var = 0, double value = 0.0);
+    void skip_spaces(std::size_t &pos) const;
+    void fail(const std::string &what, std::size_t pos) const;
+
+    static double apply(opcode op, double x);
+    static double apply(opcode op, double a, double b);
+
+    std::string m_source;
+    std::vector<std::string> m_variables;
+    std::vector<std::size_t> m_slots; // where each variable is read from
+    std::vector<instruction> m_code;
+    std::size_t m_depth, m_max_depth;
+};
+
+}
+
+#endif
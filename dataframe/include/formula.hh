@@ -0,0 +1,84 @@
+//-----------------------------------------------------------------------------
+//  formula.hh:
+//  Header for parsing model formulae (bottom ~ pt + log(m) - eta | weight)
+//  into their outputs, inputs, exclusions, weight and derived terms
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef FORMULA__HH
+#define FORMULA__HH
+
+#include "expression.hh"
+#include <map>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace agile
+{
+
+//-----------------------------------------------------------------------------
+//  Error for bad formula parsing
+//-----------------------------------------------------------------------------
+class parsing_error : public std::runtime_error
+{
+public:
+    parsing_error(const std::string &what);
+};
+
+//-----------------------------------------------------------------------------
+//  formula -- a parsed model formula. Terms are split on + and - outside of
+//  parentheses; a term that isn't a plain name is compiled into an
+//  expression. Knowing the formula up front tells the readers which
+//  columns they need to load at all (see columns()).
+//-----------------------------------------------------------------------------
+class formula
+{
+public:
+    formula();
+    explicit formula(const std::string &text);
+
+    const std::string& text() const { return m_text; }
+
+    // the terms on each side of the ~, without the wildcard and exclusions
+    const std::vector<std::string>& outputs() const { return m_outputs; }
+    const std::vector<std::string>& inputs() const { return m_inputs; }
+
+    // terms after a -, and the term after the |
+    const std::vector<std::string>& exclusions() const { return m_exclusions; }
+    const std::string& weight() const { return m_weight; }
+
+    bool wildcard() const { return m_wildcard; }
+
+    // the terms that aren't plain names, by term
+    const std::map<std::string, agile::expression>& derived() const
+    {
+        return m_derived;
+    }
+
+    // the inputs, plus everything in `available` the wildcard pulls in
+    // (which leaves out the exclusions, outputs, weight, and whatever
+    // derived outputs and weights are computed from)
+    std::vector<std::string> expand_inputs(
+        const std::vector<std::string> &available) const;
+
+    // every column the outputs, inputs and weight read, in that order
+    std::vector<std::string> columns(
+        const std::vector<std::string> &available) const;
+
+private:
+    // compiles term if it's an expression rather than a column name
+    void add_term(const std::string &term);
+
+    // the column names behind a term
+    std::vector<std::string> term_variables(const std::string &term) const;
+
+    std::string m_text, m_weight;
+    std::vector<std::string> m_outputs, m_inputs, m_exclusions;
+    std::map<std::string, agile::expression> m_derived;
+    bool m_wildcard;
+};
+
+}
+
+#endif
@@ -0,0 +1,43 @@
+//-----------------------------------------------------------------------------
+//  mapped_file.hh:
+//  Header for a small RAII wrapper around a read-only mmap() of a file
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef MAPPED__FILE__HH
+#define MAPPED__FILE__HH
+
+#include <cstddef>
+#include <string>
+#include <stdexcept>
+
+namespace agile
+{
+
+class mapped_file
+{
+public:
+    explicit mapped_file(const std::string &filename = "");
+    mapped_file(mapped_file &&M);
+    mapped_file& operator=(mapped_file &&M);
+    ~mapped_file();
+
+    mapped_file(const mapped_file &M) = delete;
+    mapped_file& operator=(const mapped_file &M) = delete;
+
+    void open(const std::string &filename);
+    void close();
+
+    bool is_open() const { return m_base != nullptr || m_empty; }
+    const char* data() const { return m_base; }
+    std::size_t size() const { return m_length; }
+
+private:
+    char *m_base;
+    std::size_t m_length;
+    bool m_empty;
+};
+
+}
+
+#endif
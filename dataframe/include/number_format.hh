@@ -0,0 +1,43 @@
+//-----------------------------------------------------------------------------
+//  number_format.hh:
+//  Header for writing doubles as text that reads back as the same double
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef NUMBER__FORMAT__HH
+#define NUMBER__FORMAT__HH
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace agile
+{
+
+//----------------------------------------------------------------------------
+//  Appends val to out with 15 significant digits, or 17 if it takes that
+//  many for strtod() to give val back. Everything that writes doubles out
+//  to be read in again (CSV, stringified matrices, scaling) goes through
+//  this, so saving and loading never moves a value.
+//----------------------------------------------------------------------------
+inline void append_double(std::string &out, double val)
+{
+    char buf[32];
+    int n = std::snprintf(buf, sizeof(buf), "%.15g", val);
+    if (std::strtod(buf, nullptr) != val)
+    {
+        n = std::snprintf(buf, sizeof(buf), "%.17g", val);
+    }
+    out.append(buf, n);
+}
+//----------------------------------------------------------------------------
+inline std::string format_double(double val)
+{
+    std::string s;
+    append_double(s, val);
+    return s;
+}
+
+}
+
+#endif
@@ -0,0 +1,99 @@
+//-----------------------------------------------------------------------------
+//  parallel.hh:
+//  Header for the small threading helpers shared by the dataframe code
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef PARALLEL__HH
+#define PARALLEL__HH
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace agile
+{
+
+//----------------------------------------------------------------------------
+//  n_threads if it's nonzero, otherwise the number of hardware threads
+//----------------------------------------------------------------------------
+inline unsigned int default_threads(unsigned int n_threads = 0)
+{
+    if (n_threads > 0)
+    {
+        return n_threads;
+    }
+    unsigned int hw = std::thread::hardware_concurrency();
+    return (hw > 0) ? hw : 1;
+}
+
+//----------------------------------------------------------------------------
+//  Calls f(0), ..., f(n - 1) on n threads and waits for them. The first 
+//  exception thrown by a worker is rethrown on the calling thread.
+//----------------------------------------------------------------------------
+template <class Function>
+void run_parallel(unsigned int n, Function f)
+{
+    if (n == 1)
+    {
+        f(0);
+        return;
+    }
+    std::vector<std::thread> workers;
+    std::vector<std::exception_ptr> errors(n);
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        workers.emplace_back([&f, &errors, i]()
+        {
+            try
+            {
+                f(i);
+            }
+            catch(...)
+            {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    for (auto &error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+//  The row-wise loops (statistics, expressions, reweighting) give each
+//  thread one contiguous range of rows, and only start as many threads as
+//  have min_thread_rows rows each (but always one). row_threads() is how
+//  many threads that makes for rows rows, and for_row_ranges() calls 
+//  f(t, first, last) on each of the n threads with its rows [first, last).
+//----------------------------------------------------------------------------
+const std::size_t min_thread_rows = 65536;
+
+inline unsigned int row_threads(std::size_t rows, unsigned int n_threads = 0)
+{
+    return std::max<std::size_t>(1, std::min<std::size_t>(
+        default_threads(n_threads), rows / min_thread_rows));
+}
+
+template <class Function>
+void for_row_ranges(std::size_t rows, unsigned int n, Function f)
+{
+    run_parallel(n, [&](unsigned int t)
+    {
+        f(t, rows * t / n, rows * (t + 1) / n);
+    });
+}
+
+}
+
+#endif
@@ -0,0 +1,74 @@
+//-----------------------------------------------------------------------------
+//  statistics.hh:
+//  Header for one pass, mergeable column statistics (mean, sd, min, max and
+//  weighted moments) that can be combined across threads, files and jobs
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef STATISTICS__HH
+#define STATISTICS__HH
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace agile
+{
+
+class dataframe;
+
+//-----------------------------------------------------------------------------
+//  column_stats -- running moments of one variable. Two accumulators over
+//  disjoint sets of values merge into exactly the accumulator over their
+//  union (Chan et al.), so partial results from chunks, threads, files or
+//  separate processes can be combined in any order.
+//-----------------------------------------------------------------------------
+struct column_stats
+{
+    column_stats();
+
+    // single values -- push(x) is push(x, 1.0)
+    void push(double x);
+    void push(double x, double w);
+
+    // a block of n values (and optionally n weights), done as one two-pass
+    // update and then merged in
+    void push(const double *x, std::size_t n);
+    void push(const double *x, const double *w, std::size_t n);
+
+    void merge(const column_stats &other);
+
+    // the unweighted sd uses n - 1, like the scaling has always done
+    double variance() const;
+    double sd() const;
+
+    double weighted_variance() const;
+    double weighted_sd() const;
+
+    std::uint64_t count;
+    double mean, m2, min, max;
+
+    // weighted moments (West's algorithm), with sum_w the sum of weights
+    double sum_w, weighted_mean, weighted_m2;
+};
+
+//-----------------------------------------------------------------------------
+//  Computes statistics for a set of columns in one pass. The rows are split
+//  into one range per thread, each thread accumulates partial statistics
+//  for every column over its range, and the partials are merged at the end.
+//  An empty `names` means every column; an empty `weight` means unit
+//  weights. n_threads = 0 means one thread per hardware core.
+//-----------------------------------------------------------------------------
+std::vector<column_stats> column_statistics(const dataframe &D,
+    const std::vector<std::string> &names = {},
+    const std::string &weight = "", unsigned int n_threads = 0);
+
+// the same, for columns that already live in contiguous double arrays
+std::vector<column_stats> column_statistics(
+    const std::vector<const double*> &columns, std::size_t rows,
+    const double *weights = nullptr, unsigned int n_threads = 0);
+
+}
+
+#endif
@@ -0,0 +1,289 @@
+//-----------------------------------------------------------------------------
+//  binary_frame.cxx:
+//  Implementation for the native binary columnar dataset format
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "include/binary_frame.hh"
+#include "include/dataframe.hh"
+#include <cstring>
+#include <fstream>
+
+namespace agile
+{
+
+namespace
+{
+//----------------------------------------------------------------------------
+bool little_endian()
+{
+    const std::uint16_t probe = 1;
+    return *reinterpret_cast<const unsigned char*>(&probe) == 1;
+}
+//----------------------------------------------------------------------------
+std::size_t align_up(std::size_t n)
+{
+    const std::size_t a = binary_format::alignment;
+    return (n + a - 1) / a * a;
+}
+//----------------------------------------------------------------------------
+template <typename T>
+void put(std::string &buf, const T &val)
+{
+    buf.append(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+//----------------------------------------------------------------------------
+template <typename T>
+T get(const unsigned char *base, std::size_t length, std::size_t &pos)
+{
+    if (pos + sizeof(T) > length)
+    {
+        throw std::runtime_error("binary frame header is truncated.");
+    }
+    T val;
+    std::memcpy(&val, base + pos, sizeof(T));
+    pos += sizeof(T);
+    return val;
+}
+//----------------------------------------------------------------------------
+// size of the fixed part of a column descriptor
+const std::size_t descriptor_size = 4 + 4 + 8 + 8 + 8;
+const std::size_t preamble_size = 8 + 4 + 4 + 8 + 4 + 4;
+}
+
+//-----------------------------------------------------------------------------
+//  Writing
+//-----------------------------------------------------------------------------
+void write_binary_frame(const std::string &filename, std::size_t rows,
+    const std::vector<binary_column> &columns, bool scaled)
+{
+    if (!little_endian())
+    {
+        throw std::runtime_error(
+            "binary frames are only supported on little endian hosts.");
+    }
+    std::size_t header_size = preamble_size;
+    for (auto &col : columns)
+    {
+        header_size += descriptor_size + col.name.size();
+    }
+
+    std::vector<std::uint64_t> offsets;
+    std::size_t offset = align_up(header_size);
+    for (auto &col : columns)
+    {
+        offsets.push_back(offset);
+        offset = align_up(offset + rows * type_size(col.type));
+    }
+
+    std::string header;
+    header.reserve(align_up(header_size));
+    header.append(binary_format::magic, sizeof(binary_format::magic));
+    put(header, binary_format::version);
+    put(header, static_cast<std::uint32_t>(columns.size()));
+    put(header, static_cast<std::uint64_t>(rows));
+    put(header, static_cast<std::uint32_t>(
+        scaled ? binary_format::has_scaling : 0));
+    put(header, static_cast<std::uint32_t>(align_up(header_size)));
+
+    for (unsigned int i = 0; i < columns.size(); ++i)
+    {
+        const std::uint8_t pad[3] = {0, 0, 0};
+        put(header, static_cast<std::uint8_t>(columns[i].type));
+        header.append(reinterpret_cast<const char*>(pad), 3);
+        put(header, static_cast<std::uint32_t>(columns[i].name.size()));
+        put(header, offsets[i]);
+        put(header, columns[i].mean);
+        put(header, columns[i].sd);
+        header.append(columns[i].name);
+    }
+
+    std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+    if (!output.good())
+    {
+        throw std::runtime_error("can't open " + filename + " for writing.");
+    }
+    const std::string padding(binary_format::alignment, '\0');
+    header.append(padding, 0, align_up(header.size()) - header.size());
+    output.write(header.data(), header.size());
+
+    std::size_t written = header.size();
+    for (unsigned int i = 0; i < columns.size(); ++i)
+    {
+        output.write(padding.data(), offsets[i] - written);
+        std::size_t nbytes = rows * type_size(columns[i].type);
+        output.write(static_cast<const char*>(columns[i].data), nbytes);
+        written = offsets[i] + nbytes;
+    }
+    output.write(padding.data(), align_up(written) - written);
+
+    if (!output.good())
+    {
+        throw std::runtime_error("error writing binary frame " + filename);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  mapped_frame: construction, mapping, etc.
+//-----------------------------------------------------------------------------
+mapped_frame::mapped_frame(const std::string &filename)
+: m_rows(0), m_scaled(false)
+{
+    if (filename != "")
+    {
+        open(filename);
+    }
+}
+//----------------------------------------------------------------------------
+void mapped_frame::close()
+{
+    m_file.close();
+    m_rows = 0;
+    m_scaled = false;
+    m_names.clear();
+    m_types.clear();
+    m_offsets.clear();
+    m_mean.clear();
+    m_sd.clear();
+    m_index.clear();
+}
+//----------------------------------------------------------------------------
+void mapped_frame::open(const std::string &filename)
+{
+    close();
+    if (!little_endian())
+    {
+        throw std::runtime_error(
+            "binary frames are only supported on little endian hosts.");
+    }
+    m_file.open(filename);
+
+    auto base = reinterpret_cast<const unsigned char*>(m_file.data());
+    auto length = m_file.size();
+    try
+    {
+        if ((length < preamble_size) || (std::memcmp(base, 
+            binary_format::magic, sizeof(binary_format::magic)) != 0))
+        {
+            throw std::runtime_error(filename + " is not a binary frame.");
+        }
+        std::size_t pos = sizeof(binary_format::magic);
+        auto version = get<std::uint32_t>(base, length, pos);
+        if (version != binary_format::version)
+        {
+            throw std::runtime_error("unsupported binary frame version " +
+                std::to_string(version) + " in " + filename);
+        }
+        auto n_cols = get<std::uint32_t>(base, length, pos);
+        m_rows = get<std::uint64_t>(base, length, pos);
+        auto flags = get<std::uint32_t>(base, length, pos);
+        m_scaled = (flags & binary_format::has_scaling) != 0;
+        get<std::uint32_t>(base, length, pos); // data start
+
+        for (std::uint32_t i = 0; i < n_cols; ++i)
+        {
+            auto type = get<std::uint8_t>(base, length, pos);
+            pos += 3;
+            auto name_len = get<std::uint32_t>(base, length, pos);
+            auto offset = get<std::uint64_t>(base, length, pos);
+            m_mean.push_back(get<double>(base, length, pos));
+            m_sd.push_back(get<double>(base, length, pos));
+            if ((type > float64) || (pos + name_len > length))
+            {
+                throw std::runtime_error("corrupt column descriptor in " +
+                    filename);
+            }
+            std::string name(reinterpret_cast<const char*>(base + pos),
+                name_len);
+            pos += name_len;
+
+            m_types.push_back(static_cast<column_type>(type));
+            if ((offset % binary_format::alignment != 0) ||
+                (offset > length) || 
+                (m_rows > (length - offset) / type_size(m_types.back())))
+            {
+                throw std::runtime_error("column \'" + name +
+                    "\' lies outside of " + filename);
+            }
+            m_offsets.push_back(offset);
+            m_index[name] = m_names.size();
+            m_names.push_back(std::move(name));
+        }
+    }
+    catch(std::exception &e)
+    {
+        close();
+        throw;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  Information and access
+//-----------------------------------------------------------------------------
+std::size_t mapped_frame::get_column_idx(const std::string &name) const
+{
+    auto found = m_index.find(name);
+    if (found == m_index.end())
+    {
+        throw std::out_of_range("no variable named \'" + name + "\' present.");
+    }
+    return found->second;
+}
+//----------------------------------------------------------------------------
+column_type mapped_frame::get_column_type(std::size_t idx) const
+{
+    return m_types.at(idx);
+}
+//----------------------------------------------------------------------------
+std::map<std::string, double> mapped_frame::get_mean() const
+{
+    std::map<std::string, double> mean;
+    for (unsigned int i = 0; i < m_names.size(); ++i)
+    {
+        mean[m_names[i]] = m_mean[i];
+    }
+    return mean;
+}
+//----------------------------------------------------------------------------
+std::map<std::string, double> mapped_frame::get_sd() const
+{
+    std::map<std::string, double> sd;
+    for (unsigned int i = 0; i < m_names.size(); ++i)
+    {
+        sd[m_names[i]] = m_sd[i];
+    }
+    return sd;
+}
+//----------------------------------------------------------------------------
+const void* mapped_frame::column_data(std::size_t idx) const
+{
+    return m_file.data() + m_offsets.at(idx);
+}
+//----------------------------------------------------------------------------
+double mapped_frame::value(std::size_t row, std::size_t col) const
+{
+    const void *base = column_data(col);
+    switch(m_types[col])
+    {
+        case int8: return static_cast<const std::int8_t*>(base)[row];
+        case int16: return static_cast<const std::int16_t*>(base)[row];
+        case int32: return static_cast<const std::int32_t*>(base)[row];
+        case float32: return static_cast<const float*>(base)[row];
+        case float64: return static_cast<const double*>(base)[row];
+    }
+    throw std::domain_error("unrecognized column type.");
+}
+//----------------------------------------------------------------------------
+agile::dataframe mapped_frame::to_dataframe() const
+{
+    agile::dataframe D;
+    for (unsigned int col = 0; col < m_names.size(); ++col)
+    {
+        agile::column C(m_types[col]);
+        C.append(column_data(col), m_types[col], m_rows);
+        D.add_column(m_names[col], std::move(C));
+    }
+    return D;
+}
+
+}
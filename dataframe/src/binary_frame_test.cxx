@@ -0,0 +1,126 @@
+#include "include/dataframe.hh"
+#include "include/binary_frame.hh"
+#include "include/checks.hh"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using agile::checks::check;
+
+// whether opening filename as a binary frame throws
+bool refused(const std::string &filename)
+{
+    try
+    {
+        agile::mapped_frame M(filename);
+    }
+    catch (std::runtime_error &e)
+    {
+        return true;
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    // one column of each type
+    const std::size_t n = 1000;
+    agile::column i8(agile::int8), i16(agile::int16), i32(agile::int32),
+        f32(agile::float32), f64(agile::float64);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        i8.push_back(int(i % 200) - 100);
+        i16.push_back(int(i) * 30 - 15000);
+        i32.push_back(int(i) * 100000);
+        f32.push_back(0.25 * i);
+        f64.push_back(1.0 / (i + 1));
+    }
+    agile::dataframe D;
+    D.add_column("i8", i8);
+    D.add_column("i16", i16);
+    D.add_column("i32", i32);
+    D.add_column("f32", f32);
+    D.add_column("f64", f64);
+
+    const std::string file = "binary_frame_test.agf";
+    D.to_binary(file, {{"f64", 0.5}}, {{"f64", 2.0}});
+
+    {
+        agile::mapped_frame M(file);
+        check(M.rows() == n, "rows()");
+        check(M.get_column_names() == D.get_column_names(), "column names");
+        check(M.get_column_type(M.get_column_idx("i8")) == agile::int8,
+            "types are kept");
+        check(M.has_scaling(), "has_scaling()");
+        check((M.get_mean()["f64"] == 0.5) && (M.get_sd()["f64"] == 2.0),
+            "scaling stats");
+
+        // the views point into the mapping, aligned for Eigen
+        for (std::size_t c = 0; c < M.columns(); ++c)
+        {
+            check(reinterpret_cast<std::uintptr_t>(M.column_data(c)) %
+                agile::binary_format::alignment == 0,
+                "column " + std::to_string(c) + " is aligned");
+        }
+        check(M.column<std::int16_t>("i16").data() ==
+            M.column_data(M.get_column_idx("i16")), "column() is zero copy");
+
+        auto f64_view = M.column<double>("f64");
+        auto i32_view = M.column<std::int32_t>("i32");
+        bool same = true;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            same = same && (f64_view(i) == D.at(i, "f64")) &&
+                (i32_view(i) == D.at(i, "i32"));
+            for (std::size_t c = 0; c < D.columns(); ++c)
+            {
+                same = same && (M.value(i, c) == D.at(i)[c]);
+            }
+        }
+        check(same, "mapped values match");
+
+        bool threw = false;
+        try
+        {
+            M.column<float>("f64");
+        }
+        catch (std::domain_error &e)
+        {
+            threw = true;
+        }
+        check(threw, "column() of the wrong type throws");
+
+        agile::dataframe E = M.to_dataframe();
+        check(E.rows() == n, "to_dataframe() rows");
+        same = true;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            same = same && (E.at(i) == D.at(i));
+        }
+        check(same, "to_dataframe() values");
+        check(E.get_column(E.get_column_idx("f32")).type() == agile::float32,
+            "to_dataframe() keeps the types");
+    }
+
+    // truncating the file anywhere past the header must be noticed
+    std::ifstream in(file, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)),
+        std::istreambuf_iterator<char>());
+    in.close();
+    const std::string cut = "binary_frame_test_cut.agf";
+    for (std::size_t length : {std::size_t(0), std::size_t(12),
+        std::size_t(40), bytes.size() / 2, bytes.size() - 1})
+    {
+        std::ofstream(cut, std::ios::binary).write(bytes.data(), length);
+        check(refused(cut), "file cut to " + std::to_string(length) +
+            " bytes refused");
+    }
+    std::ofstream(cut, std::ios::binary) << "not a binary frame at all";
+    check(refused(cut), "wrong magic refused");
+
+    std::remove(file.c_str());
+    std::remove(cut.c_str());
+
+    return agile::checks::report("binary_frame_test");
+}
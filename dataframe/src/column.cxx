@@ -0,0 +1,365 @@
+//-----------------------------------------------------------------------------
+//  column.cxx:
+//  Implementation for typed, chunked column storage
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "include/column.hh"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace agile
+{
+
+namespace
+{
+//----------------------------------------------------------------------------
+template <typename From, typename To>
+void convert_block(const void *src, void *dst, std::size_t n)
+{
+    const From *in = static_cast<const From*>(src);
+    To *out = static_cast<To*>(dst);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        out[i] = static_cast<To>(in[i]);
+    }
+}
+//----------------------------------------------------------------------------
+template <typename From>
+void convert_from(const void *src, void *dst, column_type to, std::size_t n)
+{
+    switch(to)
+    {
+        case int8: convert_block<From, std::int8_t>(src, dst, n); break;
+        case int16: convert_block<From, std::int16_t>(src, dst, n); break;
+        case int32: convert_block<From, std::int32_t>(src, dst, n); break;
+        case float32: convert_block<From, float>(src, dst, n); break;
+        case float64: convert_block<From, double>(src, dst, n); break;
+    }
+}
+//----------------------------------------------------------------------------
+// copies n values of type `from` into n values of type `to`
+void convert_values(const void *src, column_type from, void *dst,
+    column_type to, std::size_t n)
+{
+    if (from == to)
+    {
+        std::memcpy(dst, src, n * type_size(from));
+        return;
+    }
+    switch(from)
+    {
+        case int8: convert_from<std::int8_t>(src, dst, to, n); break;
+        case int16: convert_from<std::int16_t>(src, dst, to, n); break;
+        case int32: convert_from<std::int32_t>(src, dst, to, n); break;
+        case float32: convert_from<float>(src, dst, to, n); break;
+        case float64: convert_from<double>(src, dst, to, n); break;
+    }
+}
+//----------------------------------------------------------------------------
+template <typename T>
+void int_range(const void *values, std::size_t n, long &lo, long &hi)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    const T *begin = static_cast<const T*>(values);
+    auto range = std::minmax_element(begin, begin + n);
+    lo = std::min<long>(lo, *range.first);
+    hi = std::max<long>(hi, *range.second);
+}
+//----------------------------------------------------------------------------
+column_type narrowest_int(long lo, long hi)
+{
+    if ((lo >= std::numeric_limits<std::int8_t>::min()) &&
+        (hi <= std::numeric_limits<std::int8_t>::max()))
+    {
+        return int8;
+    }
+    if ((lo >= std::numeric_limits<std::int16_t>::min()) &&
+        (hi <= std::numeric_limits<std::int16_t>::max()))
+    {
+        return int16;
+    }
+    return int32;
+}
+}
+
+//----------------------------------------------------------------------------
+std::size_t type_size(column_type type)
+{
+    switch(type)
+    {
+        case int8: return 1;
+        case int16: return 2;
+        case int32: return 4;
+        case float32: return 4;
+        case float64: return 8;
+    }
+    throw std::domain_error("unrecognized column type.");
+}
+//----------------------------------------------------------------------------
+std::string type_name(column_type type)
+{
+    switch(type)
+    {
+        case int8: return "int8";
+        case int16: return "int16";
+        case int32: return "int32";
+        case float32: return "float";
+        case float64: return "double";
+    }
+    throw std::domain_error("unrecognized column type.");
+}
+//----------------------------------------------------------------------------
+column_type common_type(column_type a, column_type b)
+{
+    if (a == b)
+    {
+        return a;
+    }
+    if ((a == float64) || (b == float64))
+    {
+        return float64;
+    }
+    if ((a == float32) || (b == float32))
+    {
+        // a float can't hold every int32 exactly
+        return ((a == int32) || (b == int32)) ? float64 : float32;
+    }
+    return std::max(a, b);
+}
+
+//-----------------------------------------------------------------------------
+//  column: construction and sizing
+//-----------------------------------------------------------------------------
+column::column(column_type type, std::size_t n)
+: m_type(type), m_size(0)
+{
+    resize(n);
+}
+//----------------------------------------------------------------------------
+void column::reserve(std::size_t n)
+{
+    if (n > m_size)
+    {
+        writable_tail(n - m_size);
+    }
+}
+//----------------------------------------------------------------------------
+void column::resize(std::size_t n)
+{
+    if (n <= m_size)
+    {
+        compact();
+        if (!m_chunks.empty())
+        {
+            m_chunks[0].rows = n;
+        }
+        m_size = n;
+        return;
+    }
+    chunk &tail = writable_tail(n - m_size);
+    const std::size_t size = type_size(m_type);
+    std::fill(tail.data->begin() + tail.rows * size,
+        tail.data->begin() + (tail.rows + n - m_size) * size, 0);
+    tail.rows += n - m_size;
+    m_size = n;
+}
+//----------------------------------------------------------------------------
+void column::clear()
+{
+    m_size = 0;
+    m_chunks.clear();
+    m_starts.clear();
+}
+
+//-----------------------------------------------------------------------------
+//  Chunk management
+//-----------------------------------------------------------------------------
+void column::detach(chunk &c)
+{
+    if (c.data.use_count() > 1)
+    {
+        auto first = c.data->begin();
+        c.data = std::make_shared<buffer>(first,
+            first + c.rows * type_size(m_type));
+    }
+}
+//----------------------------------------------------------------------------
+column::chunk& column::writable_tail(std::size_t n)
+{
+    const std::size_t size = type_size(m_type);
+    if (m_chunks.empty() || (m_chunks.back().data.use_count() > 1))
+    {
+        chunk c;
+        c.data = std::make_shared<buffer>(std::max<std::size_t>(n, 16) * size);
+        c.rows = 0;
+        m_starts.push_back(m_size);
+        m_chunks.push_back(std::move(c));
+        return m_chunks.back();
+    }
+    chunk &tail = m_chunks.back();
+    std::size_t needed = (tail.rows + n) * size;
+    if (tail.data->size() < needed)
+    {
+        tail.data->resize(std::max(needed, 2 * tail.data->size()));
+    }
+    return tail;
+}
+//----------------------------------------------------------------------------
+const void* column::chunk_data(std::size_t i) const
+{
+    return m_chunks.at(i).data->data();
+}
+//----------------------------------------------------------------------------
+void column::compact()
+{
+    if (m_chunks.size() <= 1)
+    {
+        return;
+    }
+    const std::size_t size = type_size(m_type);
+    chunk merged;
+    merged.data = std::make_shared<buffer>(m_size * size);
+    merged.rows = m_size;
+    for (std::size_t c = 0; c < m_chunks.size(); ++c)
+    {
+        std::memcpy(merged.data->data() + m_starts[c] * size,
+            m_chunks[c].data->data(), m_chunks[c].rows * size);
+    }
+    m_chunks.assign(1, std::move(merged));
+    m_starts.assign(1, 0);
+}
+
+//-----------------------------------------------------------------------------
+//  Bulk access
+//-----------------------------------------------------------------------------
+void* column::raw()
+{
+    compact();
+    if (m_chunks.empty())
+    {
+        return nullptr;
+    }
+    detach(m_chunks[0]);
+    return m_chunks[0].data->data();
+}
+//----------------------------------------------------------------------------
+const void* column::raw() const
+{
+    if (!contiguous())
+    {
+        throw std::logic_error("column is split into chunks, compact() it "
+            "before asking for contiguous memory.");
+    }
+    return m_chunks.empty() ? nullptr : m_chunks[0].data->data();
+}
+//----------------------------------------------------------------------------
+void column::copy_to(double *out, std::size_t first, std::size_t n) const
+{
+    if (first + n > m_size)
+    {
+        throw std::out_of_range("column range out of bounds.");
+    }
+    const std::size_t size = type_size(m_type), last = first + n;
+    for (std::size_t c = 0; c < m_chunks.size(); ++c)
+    {
+        std::size_t lo = std::max(first, m_starts[c]);
+        std::size_t hi = std::min(last, m_starts[c] + m_chunks[c].rows);
+        if (lo < hi)
+        {
+            convert_values(m_chunks[c].data->data() + (lo - m_starts[c]) * size,
+                m_type, out + (lo - first), float64, hi - lo);
+        }
+    }
+}
+//----------------------------------------------------------------------------
+void column::append(const void *values, column_type type, std::size_t n)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    chunk &tail = writable_tail(n);
+    convert_values(values, type, 
+        tail.data->data() + tail.rows * type_size(m_type), m_type, n);
+    tail.rows += n;
+    m_size += n;
+}
+//----------------------------------------------------------------------------
+void column::append(const column &C)
+{
+    if (C.m_type != m_type)
+    {
+        column converted(C);
+        converted.convert(m_type);
+        append(converted);
+        return;
+    }
+    // copy the list first, in case we're appending a column to itself
+    std::vector<chunk> spliced(C.m_chunks);
+    for (auto &c : spliced)
+    {
+        if (c.rows > 0)
+        {
+            m_starts.push_back(m_size);
+            m_size += c.rows;
+            m_chunks.push_back(std::move(c));
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  Type manipulation
+//-----------------------------------------------------------------------------
+void column::convert(column_type type)
+{
+    if (type == m_type)
+    {
+        return;
+    }
+    const std::size_t to = type_size(type);
+    chunk converted;
+    converted.data = std::make_shared<buffer>(m_size * to);
+    converted.rows = m_size;
+    for (std::size_t c = 0; c < m_chunks.size(); ++c)
+    {
+        convert_values(m_chunks[c].data->data(), m_type, 
+            converted.data->data() + m_starts[c] * to, type, 
+            m_chunks[c].rows);
+    }
+    m_chunks.clear();
+    m_starts.clear();
+    if (m_size > 0)
+    {
+        m_chunks.push_back(std::move(converted));
+        m_starts.push_back(0);
+    }
+    m_type = type;
+}
+//----------------------------------------------------------------------------
+column_type column::narrowest() const
+{
+    if ((m_type != int16) && (m_type != int32))
+    {
+        return m_type;
+    }
+    long lo = 0, hi = 0;
+    for (auto &c : m_chunks)
+    {
+        if (m_type == int16)
+        {
+            int_range<std::int16_t>(c.data->data(), c.rows, lo, hi);
+        }
+        else
+        {
+            int_range<std::int32_t>(c.data->data(), c.rows, lo, hi);
+        }
+    }
+    return narrowest_int(lo, hi);
+}
+
+}
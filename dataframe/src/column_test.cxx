@@ -0,0 +1,76 @@
+#include "include/dataframe.hh"
+#include "include/checks.hh"
+#include <iostream>
+
+using agile::checks::check;
+
+// n rows of 0, 1, 2, ... (mod period) in a column of the given type
+agile::column counting(agile::column_type type, std::size_t n,
+    std::size_t period = 0)
+{
+    agile::column C(type);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        C.push_back(period ? i % period : i);
+    }
+    return C;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    // copies and appends share chunks until one side writes
+    agile::column a = counting(agile::int32, 100), b(a);
+    check(b.chunk_data(0) == a.chunk_data(0), "copy shares its chunk");
+    b.set(3, -7);
+    check(b.chunk_data(0) != a.chunk_data(0), "writing a copy detaches it");
+    check(a.get(3) == 3, "writing a copy leaves the original alone");
+    check(b.get(3) == -7, "writing a copy changes the copy");
+
+    agile::column joined = counting(agile::int32, 10);
+    joined.append(a);
+    check(joined.chunks() == 2, "append splices chunks");
+    check(joined.chunk_data(1) == a.chunk_data(0), "append shares the chunk");
+    joined.set(15, 1000);
+    check(a.get(5) == 5, "writing after append leaves the source alone");
+    check(joined.get(15) == 1000, "writing after append");
+    joined.compact();
+    check((joined.chunks() == 1) && (joined.size() == 110), "compact()");
+    check((joined.get(9) == 9) && (joined.get(10) == 0) &&
+        (joined.get(15) == 1000), "compact() keeps the values");
+
+    // narrow() picks the smallest integer type that holds every value
+    agile::dataframe D;
+    D.add_column("small", counting(agile::int32, 1000, 100));
+    D.add_column("medium", counting(agile::int32, 1000));
+    D.add_column("fraction", counting(agile::float64, 1000));
+    D.set(1, "fraction", 0.5);
+    D.narrow();
+    check(D.get_column("small").type() == agile::int8, "narrow to int8");
+    check(D.get_column("medium").type() == agile::int16, "narrow to int16");
+    check(D.get_column("fraction").type() == agile::float64,
+        "fractions stay float64");
+    check(D.at(99, "small") == 99, "narrowed values");
+
+    // values the narrowed type can't hold widen the column again
+    D.set(5, "small", 1000);
+    check(D.get_column("small").type() == agile::float64,
+        "set() past int8 widens to float64");
+    check(D.at(5, "small") == 1000, "set() past int8 keeps the value");
+    check(D.at(99, "small") == 99, "widening keeps the other values");
+
+    D.set(5, "medium", 0.25);
+    check(D.at(5, "medium") == 0.25, "set() of a fraction on an int column");
+
+    agile::column pushed = counting(agile::int8, 3);
+    pushed.push_back(-129);
+    check((pushed.type() == agile::float64) && (pushed.get(3) == -129),
+        "push_back() past int8 widens to float64");
+
+    agile::column single = counting(agile::float32, 3);
+    single.set(0, 1e300);
+    check((single.type() == agile::float64) && (single.get(0) == 1e300),
+        "set() past float32 widens to float64");
+
+    return agile::checks::report("column_test");
+}
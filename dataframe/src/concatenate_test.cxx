@@ -0,0 +1,96 @@
+#include "include/dataframe.hh"
+#include "include/checks.hh"
+#include <iostream>
+
+using agile::checks::check;
+
+// n rows of x (int32) = first + i and y (float64) = (first + i) / 4
+agile::dataframe block(int first, std::size_t n)
+{
+    agile::column x(agile::int32), y(agile::float64);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        x.push_back(first + int(i));
+        y.push_back((first + int(i)) / 4.0);
+    }
+    agile::dataframe D;
+    D.add_column("x", x);
+    D.add_column("y", y);
+    return D;
+}
+//----------------------------------------------------------------------------
+// whether D holds x = first, first + 1, ... for every row
+bool counts_from(const agile::dataframe &D, int first)
+{
+    for (std::size_t i = 0; i < D.rows(); ++i)
+    {
+        if ((D.at(i, "x") != first + int(i)) ||
+            (D.at(i, "y") != (first + int(i)) / 4.0))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    // append() splices the chunks in, without copying
+    agile::dataframe A = block(0, 100), B = block(100, 50);
+    A.append(B);
+    check(A.rows() == 150, "append() rows");
+    check(counts_from(A, 0), "append() values");
+    const agile::column &x = A.get_column(A.get_column_idx("x"));
+    check((x.chunks() == 2) &&
+        (x.chunk_data(1) == B.get_column(B.get_column_idx("x")).chunk_data(0)),
+        "append() shares the appended chunks");
+
+    // and the two stay independent
+    A.set(120, "x", -1);
+    check(B.at(20, "x") == 120, "writing after append() leaves the source");
+    B.set(30, "y", -1);
+    check(A.at(130, "y") == 130 / 4.0, "writing the source leaves the append");
+    A.set(120, "x", 120);
+
+    // a wider column widens the one appended to
+    agile::dataframe wide = block(150, 10);
+    wide.set(0, "x", 150.5);
+    A.append(wide);
+    check(A.get_column(A.get_column_idx("x")).type() == agile::float64,
+        "append() widens to the common type");
+    check((A.at(150, "x") == 150.5) && (A.at(151, "x") == 151) &&
+        (A.at(10, "x") == 10), "values after widening");
+
+    A.compact();
+    check(A.get_column(A.get_column_idx("y")).chunks() == 1, "compact()");
+    check(A.at(159, "y") == 159 / 4.0, "compact() keeps the values");
+
+    // concatenate() in order, skipping empty frames
+    std::vector<agile::dataframe> parts;
+    for (int p = 0; p < 5; ++p)
+    {
+        parts.push_back(block(p * 37, (p == 2) ? 0 : 37));
+    }
+    agile::dataframe C = agile::concatenate(parts);
+    check(C.rows() == 4 * 37, "concatenate() rows");
+    check(C.get_column_names() == parts[0].get_column_names(),
+        "concatenate() names");
+    check(C.at(0, "x") == 0 && C.at(74, "x") == 111 && C.at(147, "x") == 184,
+        "concatenate() keeps the order");
+
+    agile::dataframe one_column;
+    one_column.add_column("x", agile::column(agile::float64, 3));
+    bool threw = false;
+    try
+    {
+        C.append(one_column);
+    }
+    catch (dimension_error &e)
+    {
+        threw = true;
+    }
+    check(threw, "append() with other columns throws");
+
+    return agile::checks::report("concatenate_test");
+}
@@ -5,9 +5,245 @@
 //-----------------------------------------------------------------------------
 
 #include "include/csv_reader.hh"
+#include "include/mapped_file.hh"
+#include "include/number_format.hh"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
 namespace agile
 {
 
+namespace
+{
+//----------------------------------------------------------------------------
+// below this many bytes it isn't worth spinning up threads
+const std::size_t min_chunk_bytes = 1 << 20;
+
+// rows per formatting block when writing
+const std::size_t write_block_rows = 1 << 14;
+//----------------------------------------------------------------------------
+inline const char* next_line(const char *p, const char *end)
+{
+    const void *nl = std::memchr(p, '\n', end - p);
+    return nl ? static_cast<const char*>(nl) + 1 : end;
+}
+//----------------------------------------------------------------------------
+// end of the actual content of the line [begin, next), dropping \n and \r
+inline const char* content_end(const char *begin, const char *next)
+{
+    while ((next > begin) && ((next[-1] == '\n') || (next[-1] == '\r')))
+    {
+        --next;
+    }
+    return next;
+}
+//----------------------------------------------------------------------------
+std::size_t count_rows(const char *begin, const char *end, std::size_t &lines)
+{
+    std::size_t n = 0;
+    lines = 0;
+    while (begin < end)
+    {
+        const char *next = next_line(begin, end);
+        if (content_end(begin, next) != begin)
+        {
+            ++n;
+        }
+        ++lines;
+        begin = next;
+    }
+    return n;
+}
+//----------------------------------------------------------------------------
+std::size_t count_fields(const char *begin, const char *end)
+{
+    return std::count(begin, end, ',') + 1;
+}
+//----------------------------------------------------------------------------
+inline double parse_field(const char *begin, const char *end)
+{
+    char buf[64];
+    std::size_t len = end - begin;
+    if (len < sizeof(buf))
+    {
+        std::memcpy(buf, begin, len);
+        buf[len] = '\0';
+        return std::strtod(buf, nullptr);
+    }
+    return std::strtod(std::string(begin, end).c_str(), nullptr);
+}
+//----------------------------------------------------------------------------
+// line is the number in the file of the first line in [begin, end), for
+// reporting rows with the wrong number of fields
+void parse_rows(const char *begin, const char *end, std::size_t row, 
+    std::size_t line, std::vector<std::vector<double>> &data, 
+    const std::string &filename)
+{
+    const std::size_t n_cols = data.size();
+    for (; begin < end; ++line)
+    {
+        const char *next = next_line(begin, end);
+        const char *stop = content_end(begin, next);
+        if (stop != begin)
+        {
+            const char *field = begin;
+            for (std::size_t col = 0; col < n_cols; ++col)
+            {
+                const void *comma = (field > stop) ? nullptr : 
+                    std::memchr(field, ',', stop - field);
+                const char *field_end = comma ? 
+                    static_cast<const char*>(comma) : stop;
+                if ((field > stop) || (comma && (col + 1 == n_cols)))
+                {
+                    throw std::runtime_error("line " + std::to_string(line) +
+                        " of " + filename + " has " + 
+                        std::to_string(count_fields(begin, stop)) + 
+                        " fields, expected " + std::to_string(n_cols) + ".");
+                }
+                data[col][row] = parse_field(field, field_end);
+                field = field_end + 1;
+            }
+            ++row;
+        }
+        begin = next;
+    }
+}
+}
+
+//----------------------------------------------------------------------------
+csv_columns read_csv(const std::string &filename, bool colnames, 
+    unsigned int n_threads)
+{
+    mapped_file file(filename);
+    csv_columns result;
+    result.rows = 0;
+
+    const char *begin = file.data(), *end = file.data() + file.size();
+
+    if (colnames && (begin < end))
+    {
+        const char *next = next_line(begin, end);
+        std::stringstream ss(std::string(begin, content_end(begin, next)));
+        std::string field;
+        while (getline( ss, field, ',' ))
+        {
+            result.names.push_back(agile::no_quotes(agile::trim(field)));
+        }
+        begin = next;
+    }
+
+    // skip leading blank lines to find the width of the table
+    const char *first = begin;
+    while ((first < end) && 
+        (content_end(first, next_line(first, end)) == first))
+    {
+        first = next_line(first, end);
+    }
+    if (first == end)
+    {
+        result.data.resize(result.names.size());
+        return result;
+    }
+    std::size_t n_cols = result.names.empty() ? 
+        count_fields(first, content_end(first, next_line(first, end))) : 
+        result.names.size();
+
+    // split the body into line aligned chunks
+    unsigned int n_chunks = default_threads(n_threads);
+    std::size_t bytes = end - begin;
+    if (bytes / n_chunks < min_chunk_bytes)
+    {
+        n_chunks = std::max<std::size_t>(1, bytes / min_chunk_bytes);
+    }
+    std::vector<const char*> bounds(n_chunks + 1, end);
+    bounds[0] = begin;
+    for (unsigned int i = 1; i < n_chunks; ++i)
+    {
+        const char *guess = begin + (bytes / n_chunks) * i;
+        guess = std::max(guess, bounds[i - 1]);
+        bounds[i] = (guess == begin) ? begin : next_line(guess - 1, end);
+    }
+
+    // first pass: count the rows (and lines) in each chunk so every chunk 
+    // knows where its rows start
+    std::vector<std::size_t> offsets(n_chunks + 1, 0), lines(n_chunks + 1, 0);
+    lines[0] = colnames ? 2 : 1;
+    run_parallel(n_chunks, [&](unsigned int i)
+    {
+        offsets[i + 1] = count_rows(bounds[i], bounds[i + 1], lines[i + 1]);
+    });
+    for (unsigned int i = 0; i < n_chunks; ++i)
+    {
+        offsets[i + 1] += offsets[i];
+        lines[i + 1] += lines[i];
+    }
+    result.rows = offsets.back();
+    result.data.assign(n_cols, std::vector<double>(result.rows));
+
+    // second pass: parse directly into the columns, refusing ragged rows
+    run_parallel(n_chunks, [&](unsigned int i)
+    {
+        parse_rows(bounds[i], bounds[i + 1], offsets[i], lines[i], 
+            result.data, filename);
+    });
+    return result;
+}
+//----------------------------------------------------------------------------
+void write_csv(const std::string &filename, 
+    const std::vector<std::string> &names, 
+    const std::vector<const double*> &columns, std::size_t rows, 
+    unsigned int n_threads)
+{
+    std::FILE *output = std::fopen(filename.c_str(), "wb");
+    if (!output)
+    {
+        throw std::runtime_error("can't open " + filename + " for writing.");
+    }
+    if (!names.empty())
+    {
+        std::string header = knit(names) + "\n";
+        std::fwrite(header.data(), 1, header.size(), output);
+    }
+
+    unsigned int n = default_threads(n_threads);
+    std::vector<std::string> blocks(n);
+    std::size_t n_blocks = (rows + write_block_rows - 1) / write_block_rows;
+
+    for (std::size_t first = 0; first < n_blocks; first += n)
+    {
+        unsigned int active = std::min<std::size_t>(n, n_blocks - first);
+        run_parallel(active, [&](unsigned int i)
+        {
+            std::string &out = blocks[i];
+            out.clear();
+            std::size_t start = (first + i) * write_block_rows;
+            std::size_t stop = std::min(rows, start + write_block_rows);
+            for (std::size_t row = start; row < stop; ++row)
+            {
+                for (std::size_t col = 0; col < columns.size(); ++col)
+                {
+                    if (col > 0)
+                    {
+                        out.push_back(',');
+                    }
+                    append_double(out, columns[col][row]);
+                }
+                out.push_back('\n');
+            }
+        });
+        for (unsigned int i = 0; i < active; ++i)
+        {
+            std::fwrite(blocks[i].data(), 1, blocks[i].size(), output);
+        }
+    }
+    bool failed = std::ferror(output);
+    if ((std::fclose(output) != 0) || failed)
+    {
+        throw std::runtime_error("error writing " + filename);
+    }
+}
+
 //----------------------------------------------------------------------------
 std::istream& operator >> ( std::istream& ins, record_t& record )
 {   
@@ -0,0 +1,80 @@
+#include "include/csv_reader.hh"
+#include "include/checks.hh"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using agile::checks::check;
+
+void write_file(const std::string &filename, const std::string &text)
+{
+    std::ofstream out(filename, std::ios::binary);
+    out << text;
+}
+
+// the message read_csv() throws for text, or "" if it reads fine
+std::string read_error(const std::string &text, bool colnames,
+    unsigned int n_threads = 1)
+{
+    const std::string filename = "csv_reader_test.csv";
+    write_file(filename, text);
+    std::string what;
+    try
+    {
+        agile::read_csv(filename, colnames, n_threads);
+    }
+    catch (std::runtime_error &e)
+    {
+        what = e.what();
+    }
+    std::remove(filename.c_str());
+    return what;
+}
+
+bool contains(const std::string &s, const std::string &part)
+{
+    return s.find(part) != std::string::npos;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    const std::string filename = "csv_reader_test.csv";
+
+    // well formed, with blank lines and CRLF endings
+    write_file(filename, "a,b,c\r\n1,2,3\r\n\r\n4,5.5,-6e-1\r\n");
+    agile::csv_columns csv = agile::read_csv(filename, true, 1);
+    check(csv.names == std::vector<std::string>({"a", "b", "c"}), "names");
+    check(csv.rows == 2, "rows");
+    check((csv.data.size() == 3) && (csv.data[2][1] == -0.6), "values");
+    std::remove(filename.c_str());
+
+    // ragged rows are refused, giving the line they're on
+    std::string e = read_error("a,b,c\n1,2,3\n4,5\n", true);
+    check(contains(e, "line 3 of"), "short row line: " + e);
+    check(contains(e, "has 2 fields, expected 3"), "short row fields: " + e);
+
+    e = read_error("a,b\n1,2\n\n3,4,5\n", true);
+    check(contains(e, "line 4 of"), "long row line: " + e);
+    check(contains(e, "has 3 fields, expected 2"), "long row fields: " + e);
+
+    e = read_error("1,2\n3,4,\n", false);
+    check(contains(e, "line 2 of"), "trailing comma: " + e);
+
+    e = read_error("1,2\n3,4\n", false);
+    check(e.empty(), "no header: " + e);
+
+    // in a file big enough to be split over threads, the line is still
+    // counted from the top of the file
+    std::string big("x,y\n");
+    const std::size_t bad = 150000;
+    for (std::size_t i = 0; i < 300000; ++i)
+    {
+        big += (i == bad) ? "1\n" : "1.25,2.5\n";
+    }
+    e = read_error(big, true, 4);
+    check(contains(e, "line " + std::to_string(bad + 2) + " of"),
+        "line in a threaded read: " + e);
+
+    return agile::checks::report("csv_reader_test");
+}
@@ -5,6 +5,8 @@
 //-----------------------------------------------------------------------------
 
 #include "include/dataframe.hh"
+#include "include/binary_frame.hh"
+#include <cmath>
 #include <iostream>
 
 namespace agile
@@ -13,48 +15,23 @@ namespace agile
 //  Constructors, assignment, etc.
 //-----------------------------------------------------------------------------
 dataframe::dataframe(std::string filename, bool colnames)
-: m_scaled(false), m_cols(0), m_rows(0)
+: m_columns_set(false), m_scaled(false), m_cols(0), m_rows(0)
 {
     if (filename != "")
     {
-        std::ifstream input;
-        input.open(filename);
-        if (colnames)
-        {
-            m_columns_set = true;
-            std::string line;
-            std::getline( input, line );
-
-            std::stringstream ss( line );
-            std::string field;
-            std::size_t ctr = 0;
-            while (getline( ss, field, ',' ))
-            {
-                std::stringstream fs( field );
-
-                column_names[agile::no_quotes(agile::trim(fs.str()))] = ctr;
-                ++ctr;
-            }
-        }
-        input >> data;
-        m_rows = data.size();
-        m_cols = data[0].size();
-        input.close();
-    }
-    else
-    {
-        m_columns_set = false;
+        from_csv(filename, colnames);
     }
 }
-dataframe::dataframe(const dataframe &D) 
-: column_names(D.column_names), data(D.data), m_columns_set(D.m_columns_set), 
-m_scaled(false), m_cols(D.m_cols), m_rows(D.m_rows)
+dataframe::dataframe(const dataframe &D)
+: column_names(D.column_names), m_columns(D.m_columns),
+m_columns_set(D.m_columns_set), m_scaled(false), m_cols(D.m_cols),
+m_rows(D.m_rows)
 {
 }
 //----------------------------------------------------------------------------
 dataframe::dataframe(dataframe &&D)
-: column_names(std::move(D.column_names)), data(std::move(D.data)),
- m_columns_set(std::move(D.m_columns_set)), m_scaled(false), 
+: column_names(std::move(D.column_names)), m_columns(std::move(D.m_columns)),
+ m_columns_set(std::move(D.m_columns_set)), m_scaled(false),
  m_cols(std::move(D.m_cols)), m_rows(std::move(D.m_rows))
 {
 }
@@ -62,7 +39,7 @@ dataframe::dataframe(dataframe &&D)
 dataframe& dataframe::operator=(const dataframe &D)
 {
     column_names = (D.column_names);
-    data = (D.data);
+    m_columns = (D.m_columns);
     m_columns_set = (D.m_columns_set);
     m_cols = (D.m_cols);
     m_rows = (D.m_rows);
@@ -73,7 +50,7 @@ dataframe& dataframe::operator=(const dataframe &D)
 dataframe& dataframe::operator=(dataframe &&D)
 {
     column_names = std::move(D.column_names);
-    data = std::move(D.data);
+    m_columns = std::move(D.m_columns);
     m_columns_set = std::move(D.m_columns_set);
     m_cols = std::move(D.m_cols);
     m_rows = std::move(D.m_rows);
@@ -91,45 +68,103 @@ dataframe::~dataframe()
 //-----------------------------------------------------------------------------
 void dataframe::from_csv(std::string filename, bool colnames)
 {
-    std::ifstream input(filename);
-    data.clear();
-    if (colnames)
+    csv_columns csv = read_csv(filename, colnames);
+
+    column_names.clear();
+    m_columns_set = colnames;
+    std::size_t ctr = 0;
+    for (auto &name : csv.names)
     {
-        m_columns_set = true;
-        std::string line;
-        std::getline( input, line );
+        column_names[name] = ctr;
+        ++ctr;
+    }
+    m_rows = csv.rows;
+    m_cols = csv.data.size();
 
-        std::stringstream ss( line );
-        std::string field;
-        std::size_t ctr = 0;
-        while (getline( ss, field, ',' ))
+    m_columns.clear();
+    for (auto &values : csv.data)
+    {
+        m_columns.emplace_back(float64);
+        m_columns.back().append(values.data(), float64, m_rows);
+        std::vector<double>().swap(values);
+    }
+}
+//----------------------------------------------------------------------------
+void dataframe::to_csv(std::string filename, bool write_colnames)
+{
+    // contiguous float64 columns are written in place, anything else is 
+    // widened into a temporary first
+    std::vector<std::vector<double>> widened;
+    std::vector<const double*> columns;
+    for (const auto &C : m_columns)
+    {
+        if ((C.type() == float64) && C.contiguous())
+        {
+            columns.push_back(C.data<double>());
+        }
+        else
         {
-            std::stringstream fs( field );
-            column_names[agile::no_quotes(agile::trim(fs.str()))] = ctr;
-            ++ctr;
+            widened.emplace_back(m_rows);
+            C.copy_to(widened.back().data());
+            columns.push_back(widened.back().data());
         }
     }
-    else
+    std::vector<std::string> names;
+    if (write_colnames && m_columns_set)
     {
-        m_columns_set = false;
+        names = get_column_names();
     }
-    input >> data;
-    m_rows = data.size();
-    m_cols = data[0].size();
-    input.close();
+    write_csv(filename, names, columns, m_rows);
 }
 //----------------------------------------------------------------------------
-void dataframe::to_csv(std::string filename, bool write_colnames)
+void dataframe::from_binary(std::string filename)
 {
-    std::ofstream output(filename);
-    if (write_colnames && m_columns_set)
+    *this = mapped_frame(filename).to_dataframe();
+}
+//----------------------------------------------------------------------------
+void dataframe::to_binary(std::string filename)
+{
+    to_binary(filename, std::map<std::string, double>(),
+        std::map<std::string, double>());
+}
+//----------------------------------------------------------------------------
+void dataframe::to_binary(std::string filename,
+    const std::map<std::string, double> &mean,
+    const std::map<std::string, double> &sd)
+{
+    std::vector<std::string> names;
+    if (m_columns_set)
     {
-        output << knit(get_column_names()) << "\n";
+        names = get_column_names();
     }
-    for (auto &row : data)
+    else
     {
-        output << knit(row) << "\n";
+        for (std::size_t i = 0; i < m_cols; ++i)
+        {
+            names.push_back("V" + std::to_string(i));
+        }
     }
+    bool scaled = !mean.empty();
+
+    // once compacted, the columns already have the on-disk layout
+    compact();
+    std::vector<binary_column> columns;
+    for (std::size_t col = 0; col < m_cols; ++col)
+    {
+        binary_column c;
+        c.name = names[col];
+        c.type = m_columns[col].type();
+        c.data = m_columns[col].raw();
+        c.mean = 0.0;
+        c.sd = 1.0;
+        if (scaled && mean.count(c.name) && sd.count(c.name))
+        {
+            c.mean = mean.at(c.name);
+            c.sd = sd.at(c.name);
+        }
+        columns.push_back(c);
+    }
+    write_binary_frame(filename, m_rows, columns, scaled);
 }
 //----------------------------------------------------------------------------
 std::ostream& operator << ( std::ostream& os, dataframe &data )
@@ -138,34 +173,37 @@ std::ostream& operator << ( std::ostream& os, dataframe &data )
     {
         os << knit(data.get_column_names()) << "\n";
     }
-    for (auto &row : data.data)
+    for (std::size_t row = 0; row < data.m_rows; ++row)
     {
-        os << knit(row) << "\n";
+        os << knit(data.at(row)) << "\n";
     }
     return os;
 }
-//----------------------------------------------------------------------------
-data_t& dataframe::raw()
-{
-    return data;
-}
-
-
 
 //-----------------------------------------------------------------------------
 //  Size / other Information
 //-----------------------------------------------------------------------------
-std::size_t dataframe::rows()
+std::size_t dataframe::rows() const
 {
     return m_rows;
 }
 //----------------------------------------------------------------------------
-std::size_t dataframe::columns()
+std::size_t dataframe::columns() const
 {
     return m_cols;
 }
 //----------------------------------------------------------------------------
-std::vector<std::string> dataframe::get_column_names()
+std::size_t dataframe::bytes() const
+{
+    std::size_t total = 0;
+    for (auto &C : m_columns)
+    {
+        total += C.bytes();
+    }
+    return total;
+}
+//----------------------------------------------------------------------------
+std::vector<std::string> dataframe::get_column_names() const
 {
     if (!m_columns_set)
     {
@@ -179,25 +217,29 @@ std::vector<std::string> dataframe::get_column_names()
     return std::move(v);
 }
 
-std::size_t dataframe::get_column_idx(const std::string &name)
+std::size_t dataframe::get_column_idx(const std::string &name) const
 {
     try
     {
-        return column_names.at(name);    
+        return column_names.at(name);
     }
     catch(std::out_of_range &e)
     {
         throw std::out_of_range("no variable named \'" + name + "\' present.");
-    }   
+    }
 }
 //----------------------------------------------------------------------------
 void dataframe::set_column_names(std::vector<std::string> v)
 {
-    // std::cout << "callingit \n";
     if (m_columns_set)
     {
         throw std::runtime_error("column names already set.");
     }
+    if ((m_cols > 0) && (v.size() != m_cols))
+    {
+        throw dimension_error("number of column names doesn't match the "
+            "number of columns.");
+    }
     std::size_t ctr = 0;
     for (auto &e : v)
     {
@@ -206,22 +248,64 @@ void dataframe::set_column_names(std::vector<std::string> v)
     }
     m_columns_set = true;
     m_cols = v.size();
+    m_columns.resize(m_cols, agile::column(float64, m_rows));
+}
+//----------------------------------------------------------------------------
+column_type dataframe::get_column_type(std::size_t idx) const
+{
+    return m_columns.at(idx).type();
+}
+//----------------------------------------------------------------------------
+void dataframe::set_column_type(std::size_t idx, column_type type)
+{
+    m_columns.at(idx).convert(type);
+}
+//----------------------------------------------------------------------------
+void dataframe::set_column_type(const std::string &name, column_type type)
+{
+    set_column_type(get_column_idx(name), type);
+}
+//----------------------------------------------------------------------------
+void dataframe::compact()
+{
+    for (auto &C : m_columns)
+    {
+        C.compact();
+    }
+}
+//----------------------------------------------------------------------------
+void dataframe::narrow()
+{
+    for (auto &C : m_columns)
+    {
+        C.convert(C.narrowest());
+    }
 }
 
 //-----------------------------------------------------------------------------
 //  Element Access
 //-----------------------------------------------------------------------------
-
-record_t& dataframe::at(const std::size_t &idx)
+void dataframe::check_row(std::size_t idx) const
+{
+    if (idx >= m_rows)
+    {
+        throw std::out_of_range("row " + std::to_string(idx) +
+            " is out of range.");
+    }
+}
+//----------------------------------------------------------------------------
+record_t dataframe::at(const std::size_t &idx) const
 {
-    return data.at(idx);
+    check_row(idx);
+    return (*this)[idx];
 }
 //----------------------------------------------------------------------------
-double& dataframe::at(const std::size_t &idx, const std::string &colname)
+double dataframe::at(const std::size_t &idx, const std::string &colname) const
 {
+    check_row(idx);
     try
     {
-        return data.at(idx).at(column_names.at(colname));
+        return m_columns[column_names.at(colname)].get(idx);
     }
     catch(std::out_of_range &e)
     {
@@ -229,66 +313,162 @@ double& dataframe::at(const std::size_t &idx, const std::string &colname)
             "tried to access non-existent column \'" + colname + "\'.");
         throw std::out_of_range(wha);
     }
-    
+
 }
-std::map<std::string, double> dataframe::at(const std::size_t &idx, const std::vector<std::string> cols)
+std::map<std::string, double> dataframe::at(const std::size_t &idx, const std::vector<std::string> cols) const
 {
     std::map<std::string, double> retval;
     for (auto &colname : cols)
     {
-        try
-        {
-            retval[colname] = data.at(idx).at(column_names.at(colname));
-        }
-        catch(std::out_of_range &e)
-        {
-            std::string wha(
-                "tried to access non-existent column \'" + colname + "\'.");
-            throw std::out_of_range(wha);
-        }
+        retval[colname] = at(idx, colname);
     }
     return retval;
 }
 //----------------------------------------------------------------------------
-record_t& dataframe::operator[](const std::size_t &idx)
+record_t dataframe::operator[](const std::size_t &idx) const
 {
-    return data[idx];
+    record_t r(m_cols);
+    for (std::size_t col = 0; col < m_cols; ++col)
+    {
+        r[col] = m_columns[col].get(idx);
+    }
+    return r;
+}
+//----------------------------------------------------------------------------
+void dataframe::set(const std::size_t &idx, const std::string &colname,
+    double val)
+{
+    check_row(idx);
+    m_columns[get_column_idx(colname)].set(idx, val);
 }
 
 //-----------------------------------------------------------------------------
-//  Additions
+//  Handle based access
 //-----------------------------------------------------------------------------
+column_handle dataframe::handle(const std::string &name) const
+{
+    column_handle h;
+    h.idx = get_column_idx(name);
+    h.type = m_columns[h.idx].type();
+    return h;
+}
+//----------------------------------------------------------------------------
+std::vector<column_handle> dataframe::handles(
+    const std::vector<std::string> &names) const
+{
+    std::vector<column_handle> v;
+    v.reserve(names.size());
+    for (auto &name : names)
+    {
+        v.push_back(handle(name));
+    }
+    return v;
+}
+//----------------------------------------------------------------------------
+double dataframe::at(const std::size_t &idx, const column_handle &h) const
+{
+    check_row(idx);
+    return m_columns.at(h.idx).get(idx);
+}
+//----------------------------------------------------------------------------
+void dataframe::at(const std::size_t &idx, 
+    const std::vector<column_handle> &h, double *out) const
+{
+    check_row(idx);
+    for (std::size_t i = 0; i < h.size(); ++i)
+    {
+        out[i] = m_columns[h[i].idx].get(idx);
+    }
+}
+//----------------------------------------------------------------------------
+dataframe::row_view dataframe::row(const std::size_t &idx) const
+{
+    check_row(idx);
+    return row_view(*this, idx);
+}
 
-void dataframe::push_back(const record_t &r)
+//-----------------------------------------------------------------------------
+//  Column Access
+//-----------------------------------------------------------------------------
+agile::column& dataframe::get_column(std::size_t idx)
+{
+    return m_columns.at(idx);
+}
+//----------------------------------------------------------------------------
+const agile::column& dataframe::get_column(std::size_t idx) const
+{
+    return m_columns.at(idx);
+}
+//----------------------------------------------------------------------------
+const agile::column& dataframe::get_column(const std::string &name) const
+{
+    return m_columns[get_column_idx(name)];
+}
+//----------------------------------------------------------------------------
+void dataframe::copy_column(std::size_t idx, double *out) const
 {
-    if ((r.size() != m_cols) && (m_cols > 0))
+    m_columns.at(idx).copy_to(out);
+}
+//----------------------------------------------------------------------------
+void dataframe::add_column(const std::string &name, agile::column C)
+{
+    if ((m_cols > 0) && (C.size() != m_rows))
+    {
+        throw dimension_error("column \'" + name + "\' has " +
+            std::to_string(C.size()) + " rows, dataframe has " +
+            std::to_string(m_rows));
+    }
+    if ((m_cols > 0) && !m_columns_set)
+    {
+        throw std::runtime_error("can't add a named column to a dataframe "
+            "without column names.");
+    }
+    if (column_names.count(agile::trim(name)))
+    {
+        throw std::runtime_error("column \'" + name + "\' already present.");
+    }
+    m_rows = C.size();
+    column_names[agile::trim(name)] = m_cols;
+    m_columns.push_back(std::move(C));
+    m_columns_set = true;
+    ++m_cols;
+}
+
+//-----------------------------------------------------------------------------
+//  Additions
+//-----------------------------------------------------------------------------
+void dataframe::check_dimension(std::size_t n) const
+{
+    if ((n != m_cols) && (m_cols > 0))
     {
         std::string wha("vectors to be push_back()'d must be the same size");
         throw dimension_error(wha);
     }
-    data.push_back(r);
-    ++m_rows;
 }
 //----------------------------------------------------------------------------
-void dataframe::push_back(record_t &&r)
+void dataframe::push_back(const record_t &r)
 {
-    if ((r.size() != m_cols) && (m_cols > 0))
+    check_dimension(r.size());
+    if (m_cols == 0)
     {
-        std::string wha("vectors to be push_back()'d must be the same size");
-        throw dimension_error(wha);
+        m_cols = r.size();
+        m_columns.assign(m_cols, agile::column(float64, m_rows));
+    }
+    for (std::size_t col = 0; col < m_cols; ++col)
+    {
+        m_columns[col].push_back(r[col]);
     }
-    // for (auto &entry : r)
-    // {
-    //     std::cout << entry << "   ";
-    // }
-    // std::cout << std::endl;
-    data.push_back(std::move(r));
     ++m_rows;
 }
 //----------------------------------------------------------------------------
+void dataframe::push_back(record_t &&r)
+{
+    push_back(static_cast<const record_t&>(r));
+}
+//----------------------------------------------------------------------------
 void dataframe::push_back(std::initializer_list<double> il)
 {
-    data.emplace_back(il);
+    push_back(record_t(il));
 }
     // void pop_back();
 //----------------------------------------------------------------------------
@@ -298,17 +478,25 @@ void dataframe::append(const dataframe &D)
     {
         std::string wha(
             "cannot append dataframes with differing numbers of columns.");
-        
+
         throw dimension_error(wha);
     }
     if (m_cols == 0)
     {
         m_cols = D.m_cols;
+        for (auto &C : D.m_columns)
+        {
+            m_columns.emplace_back(C.type());
+        }
     }
-    for (auto &row : D.data)
+    for (std::size_t col = 0; col < m_cols; ++col)
     {
-        push_back(row);
+        // widen if the incoming column doesn't fit in our storage type
+        m_columns[col].convert(common_type(m_columns[col].type(),
+            D.m_columns[col].type()));
+        m_columns[col].append(D.m_columns[col]);
     }
+    m_rows += D.m_rows;
     if ((!m_columns_set) && D.m_columns_set)
     {
         m_columns_set = true;
@@ -318,26 +506,58 @@ void dataframe::append(const dataframe &D)
 //----------------------------------------------------------------------------
 void dataframe::append(dataframe &&D)
 {
-    if ((D.m_cols != m_cols) && (m_cols != 0))
-    {
-        std::string wha(
-            "cannot append dataframes with differing numbers of columns.");
-        
-        throw dimension_error(wha);
-    }
     if (m_cols == 0)
     {
-        m_cols = std::move(D.m_cols);
+        *this = std::move(D);
+        return;
     }
-    for (auto &row : D.data)
+    append(static_cast<const dataframe&>(D));
+}
+
+//-----------------------------------------------------------------------------
+//  Scaling
+//-----------------------------------------------------------------------------
+std::vector<column_stats> dataframe::scale(unsigned int n_threads)
+{
+    if (m_scaled)
     {
-        push_back(std::move(row));
+        throw std::runtime_error("dataframe is already scaled.");
     }
-    if ((!m_columns_set) && D.m_columns_set)
+    std::vector<column_stats> stats = column_statistics(*this, {}, "",
+        n_threads);
+
+    unsigned int n = std::min<std::size_t>(default_threads(n_threads),
+        std::max<std::size_t>(m_cols, 1));
+    run_parallel(n, [&](unsigned int t)
+    {
+        for (std::size_t col = t; col < m_cols; col += n)
+        {
+            agile::column &C = m_columns[col];
+            C.convert(float64);
+            double *x = C.data<double>();
+            double mean = stats[col].mean, sd = stats[col].sd();
+            double scale = ((sd > 0.0) && std::isfinite(sd)) ? 1.0 / sd : 1.0;
+            for (std::size_t row = 0; row < m_rows; ++row)
+            {
+                x[row] = (x[row] - mean) * scale;
+            }
+        }
+    });
+    m_scaled = true;
+    return stats;
+}
+
+//-----------------------------------------------------------------------------
+//  Concatenation
+//-----------------------------------------------------------------------------
+dataframe concatenate(const std::vector<dataframe> &frames)
+{
+    dataframe D;
+    for (auto &frame : frames)
     {
-        m_columns_set = std::move(D.m_columns_set);
-        column_names = std::move(D.column_names);
+        D.append(frame);
     }
+    return D;
 }
 
 }
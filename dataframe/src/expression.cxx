@@ -0,0 +1,457 @@
+//-----------------------------------------------------------------------------
+//  expression.cxx:
+//  Implementation for compiled arithmetic expressions over columns
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "include/expression.hh"
+#include "include/dataframe.hh"
+#include "include/parallel.hh"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace agile
+{
+
+namespace
+{
+//----------------------------------------------------------------------------
+// rows evaluated per pass through the bytecode, and the deepest stack a 
+// single row evaluation supports
+const std::size_t block_rows = 1024;
+const std::size_t max_stack = 64;
+
+//----------------------------------------------------------------------------
+bool name_start(char c)
+{
+    return std::isalpha(static_cast<unsigned char>(c)) || (c == '_');
+}
+//----------------------------------------------------------------------------
+bool name_char(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || (c == '_') ||
+        (c == '.');
+}
+}
+
+//-----------------------------------------------------------------------------
+//  Compilation
+//-----------------------------------------------------------------------------
+expression::expression()
+: m_depth(0), m_max_depth(0)
+{
+}
+//----------------------------------------------------------------------------
+expression::expression(const std::string &source)
+: m_source(source), m_depth(0), m_max_depth(0)
+{
+    std::size_t pos = 0;
+    parse_sum(pos);
+    skip_spaces(pos);
+    if (pos != m_source.size())
+    {
+        fail("unexpected \'" + m_source.substr(pos, 1) + "\'", pos);
+    }
+    if (m_max_depth > max_stack)
+    {
+        throw std::invalid_argument("expression \'" + m_source +
+            "\' is nested too deeply.");
+    }
+    m_slots.resize(m_variables.size());
+    for (std::size_t v = 0; v < m_slots.size(); ++v)
+    {
+        m_slots[v] = v;
+    }
+}
+//----------------------------------------------------------------------------
+bool expression::is_variable() const
+{
+    return (m_code.size() == 1) && (m_code[0].op == load);
+}
+//----------------------------------------------------------------------------
+void expression::bind(const std::vector<std::string> &names)
+{
+    for (std::size_t v = 0; v < m_variables.size(); ++v)
+    {
+        auto found = std::find(names.begin(), names.end(), m_variables[v]);
+        if (found == names.end())
+        {
+            throw std::out_of_range("no variable named \'" + m_variables[v] +
+                "\' to bind expression \'" + m_source + "\' to.");
+        }
+        m_slots[v] = found - names.begin();
+    }
+}
+//----------------------------------------------------------------------------
+// sum := product (('+' | '-') product)*
+void expression::parse_sum(std::size_t &pos)
+{
+    parse_product(pos);
+    skip_spaces(pos);
+    while ((pos < m_source.size()) &&
+        ((m_source[pos] == '+') || (m_source[pos] == '-')))
+    {
+        opcode op = (m_source[pos] == '+') ? add : subtract;
+        parse_product(++pos);
+        emit(op);
+        skip_spaces(pos);
+    }
+}
+//----------------------------------------------------------------------------
+// product := unary (('*' | '/') unary)*
+void expression::parse_product(std::size_t &pos)
+{
+    parse_unary(pos);
+    skip_spaces(pos);
+    while ((pos < m_source.size()) &&
+        ((m_source[pos] == '*') || (m_source[pos] == '/')))
+    {
+        opcode op = (m_source[pos] == '*') ? multiply : divide;
+        parse_unary(++pos);
+        emit(op);
+        skip_spaces(pos);
+    }
+}
+//----------------------------------------------------------------------------
+// unary := '-' unary | primary
+void expression::parse_unary(std::size_t &pos)
+{
+    skip_spaces(pos);
+    if ((pos < m_source.size()) && (m_source[pos] == '-'))
+    {
+        parse_unary(++pos);
+        emit(negate);
+        return;
+    }
+    parse_primary(pos);
+}
+//----------------------------------------------------------------------------
+// primary := number | name | function '(' sum ')' | '(' sum ')'
+void expression::parse_primary(std::size_t &pos)
+{
+    skip_spaces(pos);
+    if (pos == m_source.size())
+    {
+        fail("unexpected end", pos);
+    }
+    char c = m_source[pos];
+    if (c == '(')
+    {
+        parse_sum(++pos);
+        skip_spaces(pos);
+        if ((pos == m_source.size()) || (m_source[pos] != ')'))
+        {
+            fail("missing \')\'", pos);
+        }
+        ++pos;
+        return;
+    }
+    if (std::isdigit(static_cast<unsigned char>(c)) || (c == '.'))
+    {
+        const char *begin = m_source.c_str() + pos;
+        char *end = nullptr;
+        double value = std::strtod(begin, &end);
+        if (end == begin)
+        {
+            fail("bad number", pos);
+        }
+        pos += end - begin;
+        emit(constant, 0, value);
+        return;
+    }
+    if (!name_start(c))
+    {
+        fail("unexpected \'" + m_source.substr(pos, 1) + "\'", pos);
+    }
+    std::size_t start = pos;
+    while ((pos < m_source.size()) && name_char(m_source[pos]))
+    {
+        ++pos;
+    }
+    std::string name = m_source.substr(start, pos - start);
+
+    std::size_t after = pos;
+    skip_spaces(after);
+    if ((after < m_source.size()) && (m_source[after] == '('))
+    {
+        opcode op = negate;
+        bool identity = false;
+        if (name == "abs") op = absolute;
+        else if (name == "log") op = logarithm;
+        else if (name == "exp") op = exponential;
+        else if (name == "sqrt") op = square_root;
+        else if (name == "I") identity = true;
+        else fail("unknown function \'" + name + "\'", start);
+
+        pos = after;
+        parse_primary(pos);
+        if (!identity)
+        {
+            emit(op);
+        }
+        return;
+    }
+
+    auto found = std::find(m_variables.begin(), m_variables.end(), name);
+    std::size_t var = found - m_variables.begin();
+    if (found == m_variables.end())
+    {
+        m_variables.push_back(name);
+    }
+    emit(load, var);
+}
+//----------------------------------------------------------------------------
+void expression::emit(opcode op, std::size_t var, double value)
+{
+    instruction ins;
+    ins.op = op;
+    ins.var = var;
+    ins.value = value;
+    m_code.push_back(ins);
+
+    if ((op == load) || (op == constant))
+    {
+        m_max_depth = std::max(m_max_depth, ++m_depth);
+    }
+    else if (op <= divide)
+    {
+        --m_depth;
+    }
+}
+//----------------------------------------------------------------------------
+void expression::skip_spaces(std::size_t &pos) const
+{
+    while ((pos < m_source.size()) &&
+        std::isspace(static_cast<unsigned char>(m_source[pos])))
+    {
+        ++pos;
+    }
+}
+//----------------------------------------------------------------------------
+void expression::fail(const std::string &what, std::size_t pos) const
+{
+    throw std::invalid_argument(what + " at position " + std::to_string(pos)
+        + " of expression \'" + m_source + "\'.");
+}
+
+//-----------------------------------------------------------------------------
+//  Evaluation
+//-----------------------------------------------------------------------------
+inline double expression::apply(opcode op, double x)
+{
+    switch(op)
+    {
+        case negate: return -x;
+        case absolute: return std::fabs(x);
+        case logarithm: return std::log(x);
+        case exponential: return std::exp(x);
+        case square_root: return std::sqrt(x);
+        default: return x;
+    }
+}
+//----------------------------------------------------------------------------
+inline double expression::apply(opcode op, double a, double b)
+{
+    switch(op)
+    {
+        case add: return a + b;
+        case subtract: return a - b;
+        case multiply: return a * b;
+        case divide: return a / b;
+        default: return a;
+    }
+}
+//----------------------------------------------------------------------------
+// The bytecode is postfix, so running it on a stack of strings gives back
+// the infix source, with every operation in parentheses.
+std::string expression::to_code(const std::string &array) const
+{
+    if (m_code.empty())
+    {
+        throw std::logic_error("can't generate code for an empty expression.");
+    }
+    std::vector<std::string> stack;
+    for (auto &ins : m_code)
+    {
+        std::stringstream ss;
+        ss << std::setprecision(17);
+        switch(ins.op)
+        {
+            case load: 
+                ss << array << "[" << m_slots[ins.var] << "]"; 
+                break;
+            case constant: 
+                ss << ins.value; 
+                break;
+            case add: case subtract: case multiply: case divide:
+            {
+                const char *sym[] = {"+", "-", "*", "/"};
+                std::string b = stack.back();
+                stack.pop_back();
+                ss << "(" << stack.back() << " " << sym[ins.op - add] << " "
+                   << b << ")";
+                stack.pop_back();
+                break;
+            }
+            default:
+            {
+                const char *fn = (ins.op == negate) ? "-" :
+                    (ins.op == absolute) ? "std::fabs" :
+                    (ins.op == logarithm) ? "std::log" :
+                    (ins.op == exponential) ? "std::exp" : "std::sqrt";
+                ss << fn << "(" << stack.back() << ")";
+                stack.pop_back();
+            }
+        }
+        stack.push_back(ss.str());
+    }
+    return stack.back();
+}
+//----------------------------------------------------------------------------
+double expression::operator()(const double *values) const
+{
+    if (m_code.empty())
+    {
+        throw std::logic_error("can't evaluate an empty expression.");
+    }
+    double stack[max_stack];
+    std::size_t top = 0;
+    for (auto &ins : m_code)
+    {
+        switch(ins.op)
+        {
+            case load: stack[top++] = values[m_slots[ins.var]]; break;
+            case constant: stack[top++] = ins.value; break;
+            case add: case subtract: case multiply: case divide:
+                --top;
+                stack[top - 1] = apply(ins.op, stack[top - 1], stack[top]);
+                break;
+            default:
+                stack[top - 1] = apply(ins.op, stack[top - 1]);
+        }
+    }
+    return stack[0];
+}
+//----------------------------------------------------------------------------
+void expression::evaluate(const double * const *columns, std::size_t n,
+    double *out) const
+{
+    scratch work;
+    evaluate(columns, n, out, work);
+}
+//----------------------------------------------------------------------------
+// Runs the bytecode once per block of rows. Loads just push a pointer to
+// the input; everything else writes into the register for its stack depth.
+void expression::evaluate(const double * const *columns, std::size_t n,
+    double *out, scratch &work) const
+{
+    if (m_code.empty())
+    {
+        throw std::logic_error("can't evaluate an empty expression.");
+    }
+    // only ever grown, so a scratch passed in again allocates nothing
+    if (work.registers.size() < m_max_depth * block_rows)
+    {
+        work.registers.resize(m_max_depth * block_rows);
+    }
+    if (work.stack.size() < m_max_depth)
+    {
+        work.stack.resize(m_max_depth);
+    }
+    double *registers = work.registers.data();
+    const double **stack = work.stack.data();
+
+    for (std::size_t first = 0; first < n; first += block_rows)
+    {
+        const std::size_t len = std::min(block_rows, n - first);
+        std::size_t top = 0;
+        for (auto &ins : m_code)
+        {
+            if (ins.op == load)
+            {
+                stack[top++] = columns[m_slots[ins.var]] + first;
+                continue;
+            }
+            if (ins.op == constant)
+            {
+                double *r = &registers[top * block_rows];
+                std::fill(r, r + len, ins.value);
+                stack[top++] = r;
+                continue;
+            }
+            if (ins.op <= divide)
+            {
+                --top;
+            }
+            double *r = &registers[(top - 1) * block_rows];
+            const double *a = stack[top - 1];
+            switch(ins.op)
+            {
+                case add:
+                    for (std::size_t i = 0; i < len; ++i)
+                        r[i] = a[i] + stack[top][i];
+                    break;
+                case subtract:
+                    for (std::size_t i = 0; i < len; ++i)
+                        r[i] = a[i] - stack[top][i];
+                    break;
+                case multiply:
+                    for (std::size_t i = 0; i < len; ++i)
+                        r[i] = a[i] * stack[top][i];
+                    break;
+                case divide:
+                    for (std::size_t i = 0; i < len; ++i)
+                        r[i] = a[i] / stack[top][i];
+                    break;
+                default:
+                    for (std::size_t i = 0; i < len; ++i)
+                        r[i] = apply(ins.op, a[i]);
+            }
+            stack[top - 1] = r;
+        }
+        std::memcpy(out + first, stack[0], len * sizeof(double));
+    }
+}
+//----------------------------------------------------------------------------
+void expression::evaluate(const dataframe &D, double *out,
+    unsigned int n_threads) const
+{
+    std::vector<const agile::column*> columns;
+    for (auto &name : m_variables)
+    {
+        columns.push_back(&D.get_column(name));
+    }
+    // the values are copied out in the order of m_variables, so evaluate
+    // with the default layout regardless of any bind()
+    expression unbound(*this);
+    for (std::size_t v = 0; v < m_slots.size(); ++v)
+    {
+        unbound.m_slots[v] = v;
+    }
+
+    const std::size_t rows = D.rows();
+    for_row_ranges(rows, row_threads(rows, n_threads), [&](unsigned int,
+        std::size_t first, std::size_t last)
+    {
+        std::vector<double> buf(columns.size() * block_rows);
+        std::vector<const double*> ptrs(columns.size());
+        scratch work;
+        for (std::size_t row = first; row < last; row += block_rows)
+        {
+            std::size_t len = std::min(block_rows, last - row);
+            for (std::size_t c = 0; c < columns.size(); ++c)
+            {
+                columns[c]->copy_to(&buf[c * block_rows], row, len);
+                ptrs[c] = &buf[c * block_rows];
+            }
+            unbound.evaluate(ptrs.data(), len, out + row, work);
+        }
+    });
+}
+
+}
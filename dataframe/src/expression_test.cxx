@@ -0,0 +1,114 @@
+#include "include/expression.hh"
+#include "include/formula.hh"
+#include "include/dataframe.hh"
+#include "include/checks.hh"
+#include <cmath>
+#include <functional>
+#include <iostream>
+
+using agile::checks::check;
+
+// an expression over m, eta and x, and the same thing written in C++
+struct case_t
+{
+    std::string source;
+    std::function<double(double, double, double)> reference;
+};
+
+//----------------------------------------------------------------------------
+int main()
+{
+    const case_t cases[] = {
+        {"log(m) / abs(eta) - -2*x + I(3)", [](double m, double eta,
+            double x) { return std::log(m) / std::fabs(eta) + 2 * x + 3; }},
+        {"sqrt(exp(x)) * (m - eta) / 1e-2", [](double m, double eta,
+            double x) { return std::sqrt(std::exp(x)) * (m - eta) / 1e-2; }},
+        {"-(m + eta) * -x - m/eta/x", [](double m, double eta, double x)
+            { return -(m + eta) * -x - m / eta / x; }},
+        {"log(abs(m*eta)+1)", [](double m, double eta, double)
+            { return std::log(std::fabs(m * eta) + 1); }},
+        {"x", [](double, double, double x) { return x; }}};
+
+    // enough rows for several blocks and threads, and a ragged last block
+    const std::size_t n = 150001;
+    agile::dataframe D;
+    D.set_column_names({"m", "eta", "x"});
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        D.push_back(std::vector<double>{1.0 + i % 17, std::sin(i) + 2.0,
+            0.5 + i * 1e-5});
+    }
+    std::vector<double> m(n), eta(n), x(n);
+    D.get_column(0).copy_to(m.data());
+    D.get_column(1).copy_to(eta.data());
+    D.get_column(2).copy_to(x.data());
+
+    // one scratch for every case, grown by the deeper ones
+    agile::expression::scratch work;
+    for (auto &c : cases)
+    {
+        agile::expression e(c.source);
+        std::vector<double> block(n), threaded(n), single(n), reused(n);
+        e.bind({"m", "eta", "x"});
+        const double *columns[] = {m.data(), eta.data(), x.data()};
+        e.evaluate(columns, n, block.data());
+        e.evaluate(columns, n, reused.data(), work);
+        e.evaluate(D, threaded.data(), 1);
+        std::vector<double> parallel(n);
+        e.evaluate(D, parallel.data(), 4);
+
+        bool exact = true, close = true;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            double values[] = {m[i], eta[i], x[i]};
+            double want = c.reference(m[i], eta[i], x[i]);
+            exact = exact && (e(values) == block[i]) &&
+                (block[i] == threaded[i]) && (block[i] == parallel[i]) &&
+                (block[i] == reused[i]);
+            close = close && (std::fabs(block[i] - want) <=
+                1e-12 * std::max(1.0, std::fabs(want)));
+        }
+        check(exact, c.source + ": every evaluator agrees exactly");
+        check(close, c.source + ": matches the C++ reference");
+    }
+
+    // derived formula terms are the same expressions
+    agile::formula f("y ~ log(abs(m*eta)+1) + x");
+    auto term = f.derived().find("log(abs(m*eta)+1)");
+    check(term != f.derived().end(), "formula has the derived term");
+    if (term != f.derived().end())
+    {
+        agile::expression e("log(abs(m*eta)+1)");
+        bool same = true;
+        for (std::size_t i = 0; i < n; i += 101)
+        {
+            double values[] = {m[i], eta[i]};
+            same = same && (term->second(values) == e(values));
+        }
+        check(same, "formula term evaluates like the expression");
+    }
+
+    // bind() reads the variables from any layout
+    agile::expression e("x*eta");
+    e.bind({"q", "eta", "unused", "x"});
+    double wide[] = {0, 2, -1, 3};
+    check(e(wide) == 6, "bind()");
+    check(agile::expression("x").is_variable() &&
+        !agile::expression("x + 1").is_variable(), "is_variable()");
+
+    for (auto bad : {"a+", "log(", "foo(x)", "a b", "(a", ")", ""})
+    {
+        bool threw = false;
+        try
+        {
+            agile::expression broken(bad);
+        }
+        catch (std::invalid_argument &e)
+        {
+            threw = true;
+        }
+        check(threw, std::string("'") + bad + "' is refused");
+    }
+
+    return agile::checks::report("expression_test");
+}
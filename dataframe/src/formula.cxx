@@ -0,0 +1,246 @@
+//-----------------------------------------------------------------------------
+//  formula.cxx:
+//  Implementation for parsing model formulae
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "include/formula.hh"
+#include <algorithm>
+#include <cctype>
+#include <set>
+
+namespace agile
+{
+
+namespace
+{
+//----------------------------------------------------------------------------
+std::string no_spaces(std::string s)
+{
+    s.erase(std::remove_if(s.begin(), s.end(),
+        [](char c) { return std::isspace(static_cast<unsigned char>(c)); }),
+        s.end());
+    return s;
+}
+//----------------------------------------------------------------------------
+// whether s[i] is the sign of an exponent, as in "1e-3" or "2.5E+4", rather
+// than an operator after a name like "x1e"
+bool exponent_sign(const std::string &s, std::size_t i)
+{
+    if ((i < 2) || ((s[i - 1] != 'e') && (s[i - 1] != 'E')))
+    {
+        return false;
+    }
+    std::size_t j = i - 1;
+    bool digits = false;
+    while ((j > 0) && (std::isdigit(static_cast<unsigned char>(s[j - 1])) ||
+        (s[j - 1] == '.')))
+    {
+        digits |= (s[j - 1] != '.');
+        --j;
+    }
+    return digits && ((j == 0) || 
+        !(std::isalnum(static_cast<unsigned char>(s[j - 1])) || 
+            (s[j - 1] == '_')));
+}
+//----------------------------------------------------------------------------
+// splits s at each of ops that's outside of any parentheses, and doesn't
+// directly follow another operator (so "a*-b" stays one term, while the
+// wildcard in "*-eta" doesn't count as an operator) or sit in the exponent
+// of a number (so "pt*1e-3" does too). Each piece comes with the operator
+// in front of it, or '\0' for the first one.
+std::vector<std::pair<char, std::string>> split_terms(const std::string &s,
+    const std::string &ops)
+{
+    std::vector<std::pair<char, std::string>> terms;
+    int depth = 0;
+    char sign = '\0';
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < s.size(); ++i)
+    {
+        if (s[i] == '(') ++depth;
+        else if (s[i] == ')') --depth;
+        else if ((depth == 0) && (ops.find(s[i]) != std::string::npos) &&
+            ((i == 0) || (s.compare(start, i - start, "*") == 0) ||
+                (std::string("*/+-(").find(s[i - 1]) == std::string::npos)) &&
+            !exponent_sign(s, i))
+        {
+            terms.emplace_back(sign, s.substr(start, i - start));
+            sign = s[i];
+            start = i + 1;
+        }
+    }
+    terms.emplace_back(sign, s.substr(start));
+    return terms;
+}
+//----------------------------------------------------------------------------
+void add_unique(std::vector<std::string> &v, const std::string &name)
+{
+    if (std::find(v.begin(), v.end(), name) == v.end())
+    {
+        v.push_back(name);
+    }
+}
+}
+
+//----------------------------------------------------------------------------
+formula::formula()
+: m_wildcard(false)
+{
+}
+//----------------------------------------------------------------------------
+formula::formula(const std::string &text)
+: m_text(text), m_wildcard(false)
+{
+    std::string f(text);
+    auto pipe = f.find_first_of("|");
+
+    if (pipe != std::string::npos)
+    {
+        m_weight = no_spaces(f.substr(pipe + 1));
+        f = f.substr(0, pipe);
+        add_term(m_weight);
+    }
+
+    f = no_spaces(f);
+    auto tilde = f.find_first_of("~");
+    if (tilde != f.find_last_of("~"))
+    {
+        std::string e("can't specify multiple \'is a function of\'");
+        e.append(" operators (uses of \'~\') in one formula.");
+        throw agile::parsing_error(e);
+    }
+
+    auto lhs = f.substr(0, tilde);
+    auto rhs = f.substr(tilde + 1);
+
+    for (auto &term : split_terms(lhs, "+"))
+    {
+        if (!term.second.empty())
+        {
+            add_term(term.second);
+            m_outputs.push_back(term.second);
+        }
+    }
+
+    // '*' on its own is the wildcard, anywhere else it's a product
+    for (auto &term : split_terms(rhs, "+-"))
+    {
+        if (term.second.empty())
+        {
+            continue;
+        }
+        if (term.second == "*")
+        {
+            if (m_wildcard)
+            {
+                std::string e("can't specify multiple \'include all defined");
+                e.append(" variables\' operators (uses of \'*\') in one formula.");
+                throw agile::parsing_error(e);
+            }
+            m_wildcard = true;
+        }
+        else if (term.first == '-')
+        {
+            m_exclusions.push_back(term.second);
+        }
+        else
+        {
+            add_term(term.second);
+            m_inputs.push_back(term.second);
+        }
+    }
+}
+//----------------------------------------------------------------------------
+void formula::add_term(const std::string &term)
+{
+    if (term.empty() || (m_derived.count(term) != 0))
+    {
+        return;
+    }
+    agile::expression expr;
+    try
+    {
+        expr = agile::expression(term);
+    }
+    catch (std::invalid_argument &e)
+    {
+        throw agile::parsing_error(e.what());
+    }
+    if (!expr.is_variable() || (expr.variables().front() != term))
+    {
+        m_derived[term] = std::move(expr);
+    }
+}
+//----------------------------------------------------------------------------
+std::vector<std::string> formula::term_variables(const std::string &term) const
+{
+    auto derived = m_derived.find(term);
+    if (derived != m_derived.end())
+    {
+        return derived->second.variables();
+    }
+    return std::vector<std::string>(1, term);
+}
+//----------------------------------------------------------------------------
+std::vector<std::string> formula::expand_inputs(
+    const std::vector<std::string> &available) const
+{
+    std::vector<std::string> inputs(m_inputs);
+    if (!m_wildcard)
+    {
+        return inputs;
+    }
+    std::set<std::string> excluded(m_exclusions.begin(), m_exclusions.end());
+
+    // don't let the wildcard hand the network what it predicts
+    std::vector<std::string> held_out(m_outputs);
+    if (!m_weight.empty())
+    {
+        held_out.push_back(m_weight);
+    }
+    for (auto &term : held_out)
+    {
+        excluded.insert(term);
+        for (auto &var : term_variables(term))
+        {
+            excluded.insert(var);
+        }
+    }
+    for (auto &name : available)
+    {
+        if (excluded.count(name) == 0)
+        {
+            add_unique(inputs, name);
+        }
+    }
+    return inputs;
+}
+//----------------------------------------------------------------------------
+std::vector<std::string> formula::columns(
+    const std::vector<std::string> &available) const
+{
+    std::vector<std::string> terms(m_outputs), cols;
+    for (auto &term : expand_inputs(available))
+    {
+        terms.push_back(term);
+    }
+    if (!m_weight.empty())
+    {
+        terms.push_back(m_weight);
+    }
+    for (auto &term : terms)
+    {
+        for (auto &var : term_variables(term))
+        {
+            add_unique(cols, var);
+        }
+    }
+    return cols;
+}
+//----------------------------------------------------------------------------
+parsing_error::parsing_error(const std::string &what)
+: std::runtime_error(what)
+{}
+
+}
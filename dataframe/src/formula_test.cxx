@@ -0,0 +1,62 @@
+#include "include/formula.hh"
+#include "include/checks.hh"
+#include <cmath>
+#include <iostream>
+
+using agile::checks::check;
+
+bool same(const std::vector<std::string> &a, const std::vector<std::string> &b)
+{
+    return a == b;
+}
+
+// value of derived term `term` of f, with its variables set to values
+double derived_value(const agile::formula &f, const std::string &term,
+    const std::vector<double> &values)
+{
+    auto found = f.derived().find(term);
+    if (found == f.derived().end())
+    {
+        check(false, term + " is derived");
+        return std::nan("");
+    }
+    return found->second(values.data());
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    // plain names, exclusions, wildcard and weight
+    agile::formula f("y1 + y2 ~ * - eta + pt | w");
+    check(same(f.outputs(), {"y1", "y2"}), "outputs");
+    check(same(f.inputs(), {"pt"}), "inputs");
+    check(same(f.exclusions(), {"eta"}), "exclusions");
+    check(f.weight() == "w", "weight");
+    check(f.wildcard(), "wildcard");
+    check(f.derived().empty(), "no derived terms");
+
+    // an operator straight after another one belongs to the term
+    agile::formula g("y ~ a*-b + log(m+1) - c");
+    check(same(g.inputs(), {"a*-b", "log(m+1)"}), "signed factor");
+    check(same(g.exclusions(), {"c"}), "exclusion after a derived term");
+
+    // the sign of an exponent doesn't split a term
+    agile::formula h("y ~ pt*1e-3 + 1e+3*m + 2.5E-1*eta - x1e + q");
+    check(same(h.inputs(), {"pt*1e-3", "1e+3*m", "2.5E-1*eta", "q"}),
+        "scientific notation inputs");
+    check(same(h.exclusions(), {"x1e"}),
+        "a name ending in e is still followed by an operator");
+    check(derived_value(h, "pt*1e-3", {2000.0}) == 2.0, "pt*1e-3");
+    check(derived_value(h, "1e+3*m", {0.5}) == 500.0, "1e+3*m");
+    check(derived_value(h, "2.5E-1*eta", {4.0}) == 1.0, "2.5E-1*eta");
+
+    agile::formula k("y ~ exp(-1e-2*pt) + eta");
+    check(same(k.inputs(), {"exp(-1e-2*pt)", "eta"}), "exponent in a call");
+    check(std::fabs(derived_value(k, "exp(-1e-2*pt)", {100.0}) -
+        std::exp(-1.0)) < 1e-15, "exp(-1e-2*pt)");
+
+    std::vector<std::string> cols = h.columns({"pt", "m", "eta", "q", "y"});
+    check(same(cols, {"y", "pt", "m", "eta", "q"}), "columns");
+
+    return agile::checks::report("formula_test");
+}
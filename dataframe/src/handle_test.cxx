@@ -0,0 +1,71 @@
+#include "include/dataframe.hh"
+#include "include/checks.hh"
+#include <iostream>
+
+using agile::checks::check;
+
+//----------------------------------------------------------------------------
+int main()
+{
+    const std::size_t n = 500;
+    agile::column a(agile::int16), b(agile::float32), c(agile::float64);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        a.push_back(int(i) - 250);
+        b.push_back(0.5 * i);
+        c.push_back(1.0 / (i + 1));
+    }
+    agile::dataframe D;
+    D.add_column("a", a);
+    D.add_column("b", b);
+    D.add_column("c", c);
+
+    auto hc = D.handle("c");
+    check((hc.idx == 2) && (hc.type == agile::float64), "handle()");
+    auto hs = D.handles({"c", "a"});
+    check((hs.size() == 2) && (hs[0].idx == 2) && (hs[1].idx == 0) &&
+        (hs[1].type == agile::int16), "handles() keeps the order asked for");
+
+    // every way through a handle agrees with the lookup by name
+    bool same = true;
+    double out[2];
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        D.at(i, hs, out);
+        auto row = D.row(i);
+        same = same && (D.at(i, hc) == D.at(i, "c")) &&
+            (out[0] == D.at(i, "c")) && (out[1] == D.at(i, "a")) &&
+            (row[hs[1]] == D.at(i, "a")) && (row.index() == i);
+    }
+    check(same, "handle access matches access by name");
+
+    // a column widened after the handle was made still reads right
+    auto ha = D.handle("a");
+    D.set(3, "a", 0.75);
+    check((D.at(3, ha) == 0.75) && (D.row(4)[ha] == -246),
+        "handles follow a widened column");
+
+    bool threw = false;
+    try
+    {
+        D.handle("missing");
+    }
+    catch (std::out_of_range &e)
+    {
+        threw = true;
+    }
+    check(threw, "handle() of a missing column throws");
+
+    threw = false;
+    try
+    {
+        D.at(n, hc);
+    }
+    catch (std::out_of_range &e)
+    {
+        threw = true;
+    }
+    check(threw, "at() past the last row throws");
+
+    return agile::checks::report("handle_test");
+}
@@ -0,0 +1,97 @@
+//-----------------------------------------------------------------------------
+//  mapped_file.cxx:
+//  Implementation for a small RAII wrapper around a read-only mmap() of a file
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "include/mapped_file.hh"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace agile
+{
+
+//----------------------------------------------------------------------------
+mapped_file::mapped_file(const std::string &filename)
+: m_base(nullptr), m_length(0), m_empty(false)
+{
+    if (filename != "")
+    {
+        open(filename);
+    }
+}
+//----------------------------------------------------------------------------
+mapped_file::mapped_file(mapped_file &&M)
+: m_base(M.m_base), m_length(M.m_length), m_empty(M.m_empty)
+{
+    M.m_base = nullptr;
+    M.m_length = 0;
+    M.m_empty = false;
+}
+//----------------------------------------------------------------------------
+mapped_file& mapped_file::operator=(mapped_file &&M)
+{
+    if (this != &M)
+    {
+        close();
+        m_base = M.m_base;
+        m_length = M.m_length;
+        m_empty = M.m_empty;
+        M.m_base = nullptr;
+        M.m_length = 0;
+        M.m_empty = false;
+    }
+    return *this;
+}
+//----------------------------------------------------------------------------
+mapped_file::~mapped_file()
+{
+    close();
+}
+//----------------------------------------------------------------------------
+void mapped_file::open(const std::string &filename)
+{
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("can't open " + filename);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("can't stat " + filename);
+    }
+    if (info.st_size == 0)
+    {
+        // mmap() refuses zero length mappings
+        ::close(fd);
+        m_empty = true;
+        return;
+    }
+    void *addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+    {
+        throw std::runtime_error("can't memory map " + filename);
+    }
+    madvise(addr, info.st_size, MADV_SEQUENTIAL);
+    m_base = static_cast<char*>(addr);
+    m_length = info.st_size;
+}
+//----------------------------------------------------------------------------
+void mapped_file::close()
+{
+    if (m_base)
+    {
+        munmap(m_base, m_length);
+    }
+    m_base = nullptr;
+    m_length = 0;
+    m_empty = false;
+}
+
+}
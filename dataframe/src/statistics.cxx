@@ -0,0 +1,278 @@
+//-----------------------------------------------------------------------------
+//  statistics.cxx:
+//  Implementation for one pass, mergeable column statistics
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "include/statistics.hh"
+#include "include/dataframe.hh"
+#include "include/parallel.hh"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace agile
+{
+
+namespace
+{
+//----------------------------------------------------------------------------
+// rows handed to column_stats::push() at a time
+const std::size_t block_rows = 4096;
+
+//----------------------------------------------------------------------------
+// Splits [0, rows) into one range per thread. get(c, first, n, buf) must
+// return a pointer to n values of column c starting at row first (buf has
+// room for block_rows values if a copy is needed), and weight(first, n, buf)
+// the same for the weights, or nullptr for unit weights.
+template <class Getter, class WeightGetter>
+std::vector<column_stats> accumulate(std::size_t n_columns, std::size_t rows,
+    Getter get, WeightGetter weight, unsigned int n_threads)
+{
+    const unsigned int n = row_threads(rows, n_threads);
+
+    std::vector<std::vector<column_stats>> partial(n,
+        std::vector<column_stats>(n_columns));
+
+    for_row_ranges(rows, n, [&](unsigned int t, std::size_t first,
+        std::size_t last)
+    {
+        std::vector<double> buf(block_rows), wbuf(block_rows);
+        for (std::size_t row = first; row < last; row += block_rows)
+        {
+            std::size_t len = std::min(block_rows, last - row);
+            const double *w = weight(row, len, wbuf.data());
+            for (std::size_t c = 0; c < n_columns; ++c)
+            {
+                const double *x = get(c, row, len, buf.data());
+                if (w)
+                {
+                    partial[t][c].push(x, w, len);
+                }
+                else
+                {
+                    partial[t][c].push(x, len);
+                }
+            }
+        }
+    });
+
+    // merge in thread order, so the result doesn't depend on timing
+    for (unsigned int t = 1; t < n; ++t)
+    {
+        for (std::size_t c = 0; c < n_columns; ++c)
+        {
+            partial[0][c].merge(partial[t][c]);
+        }
+    }
+    return std::move(partial[0]);
+}
+}
+
+//-----------------------------------------------------------------------------
+//  column_stats
+//-----------------------------------------------------------------------------
+column_stats::column_stats()
+: count(0), mean(0.0), m2(0.0),
+min(std::numeric_limits<double>::infinity()),
+max(-std::numeric_limits<double>::infinity()),
+sum_w(0.0), weighted_mean(0.0), weighted_m2(0.0)
+{
+}
+//----------------------------------------------------------------------------
+void column_stats::push(double x)
+{
+    push(x, 1.0);
+}
+//----------------------------------------------------------------------------
+void column_stats::push(double x, double w)
+{
+    ++count;
+    double delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+    min = std::min(min, x);
+    max = std::max(max, x);
+
+    if (w != 0.0)
+    {
+        sum_w += w;
+        double wdelta = x - weighted_mean;
+        weighted_mean += (w / sum_w) * wdelta;
+        weighted_m2 += w * wdelta * (x - weighted_mean);
+    }
+}
+//----------------------------------------------------------------------------
+void column_stats::push(const double *x, std::size_t n)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    column_stats block;
+    double sum = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        sum += x[i];
+    }
+    block.count = n;
+    block.mean = sum / n;
+    double lo = x[0], hi = x[0];
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        double d = x[i] - block.mean;
+        block.m2 += d * d;
+        lo = std::min(lo, x[i]);
+        hi = std::max(hi, x[i]);
+    }
+    block.min = lo;
+    block.max = hi;
+    block.sum_w = n;
+    block.weighted_mean = block.mean;
+    block.weighted_m2 = block.m2;
+    merge(block);
+}
+//----------------------------------------------------------------------------
+void column_stats::push(const double *x, const double *w, std::size_t n)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    column_stats block;
+    double sum = 0.0, wsum = 0.0, wxsum = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        sum += x[i];
+        wsum += w[i];
+        wxsum += w[i] * x[i];
+    }
+    block.count = n;
+    block.mean = sum / n;
+    block.sum_w = wsum;
+    block.weighted_mean = (wsum != 0.0) ? wxsum / wsum : 0.0;
+    double lo = x[0], hi = x[0];
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        double d = x[i] - block.mean, wd = x[i] - block.weighted_mean;
+        block.m2 += d * d;
+        block.weighted_m2 += w[i] * wd * wd;
+        lo = std::min(lo, x[i]);
+        hi = std::max(hi, x[i]);
+    }
+    block.min = lo;
+    block.max = hi;
+    merge(block);
+}
+//----------------------------------------------------------------------------
+void column_stats::merge(const column_stats &other)
+{
+    if (other.count == 0)
+    {
+        return;
+    }
+    if (count == 0)
+    {
+        *this = other;
+        return;
+    }
+    double n_a = count, n_b = other.count, n = n_a + n_b;
+    double delta = other.mean - mean;
+    mean += delta * n_b / n;
+    m2 += other.m2 + delta * delta * n_a * n_b / n;
+    count += other.count;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+
+    if (other.sum_w == 0.0)
+    {
+        return;
+    }
+    if (sum_w == 0.0)
+    {
+        sum_w = other.sum_w;
+        weighted_mean = other.weighted_mean;
+        weighted_m2 = other.weighted_m2;
+        return;
+    }
+    double w = sum_w + other.sum_w;
+    double wdelta = other.weighted_mean - weighted_mean;
+    weighted_mean += wdelta * other.sum_w / w;
+    weighted_m2 += other.weighted_m2 + wdelta * wdelta * sum_w * other.sum_w / w;
+    sum_w = w;
+}
+//----------------------------------------------------------------------------
+double column_stats::variance() const
+{
+    return m2 / (static_cast<double>(count) - 1.0);
+}
+//----------------------------------------------------------------------------
+double column_stats::sd() const
+{
+    return std::sqrt(variance());
+}
+//----------------------------------------------------------------------------
+double column_stats::weighted_variance() const
+{
+    return weighted_m2 / sum_w;
+}
+//----------------------------------------------------------------------------
+double column_stats::weighted_sd() const
+{
+    return std::sqrt(weighted_variance());
+}
+
+//-----------------------------------------------------------------------------
+//  Whole column passes
+//-----------------------------------------------------------------------------
+std::vector<column_stats> column_statistics(const dataframe &D,
+    const std::vector<std::string> &names, const std::string &weight,
+    unsigned int n_threads)
+{
+    std::vector<const agile::column*> columns;
+    if (names.empty())
+    {
+        for (std::size_t i = 0; i < D.columns(); ++i)
+        {
+            columns.push_back(&D.get_column(i));
+        }
+    }
+    for (auto &name : names)
+    {
+        columns.push_back(&D.get_column(name));
+    }
+    const agile::column *w = (weight != "") ? &D.get_column(weight) : nullptr;
+
+    return accumulate(columns.size(), D.rows(),
+        [&](std::size_t c, std::size_t first, std::size_t n, double *buf)
+        {
+            columns[c]->copy_to(buf, first, n);
+            return static_cast<const double*>(buf);
+        },
+        [&](std::size_t first, std::size_t n, double *buf)
+        {
+            if (!w)
+            {
+                return static_cast<const double*>(nullptr);
+            }
+            w->copy_to(buf, first, n);
+            return static_cast<const double*>(buf);
+        }, n_threads);
+}
+//----------------------------------------------------------------------------
+std::vector<column_stats> column_statistics(
+    const std::vector<const double*> &columns, std::size_t rows,
+    const double *weights, unsigned int n_threads)
+{
+    return accumulate(columns.size(), rows,
+        [&](std::size_t c, std::size_t first, std::size_t, double*)
+        {
+            return columns[c] + first;
+        },
+        [&](std::size_t first, std::size_t, double*)
+        {
+            return weights ? weights + first : nullptr;
+        }, n_threads);
+}
+
+}
@@ -0,0 +1,136 @@
+#include "include/statistics.hh"
+#include "include/dataframe.hh"
+#include "include/checks.hh"
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+using agile::checks::check;
+using agile::checks::check_close;
+
+// the textbook two pass answer, in long double
+struct reference
+{
+    reference(const std::vector<double> &x, const std::vector<double> &w)
+    {
+        long double sum = 0, sum_w = 0, wsum = 0;
+        for (std::size_t i = 0; i < x.size(); ++i)
+        {
+            sum += x[i];
+            sum_w += w[i];
+            wsum += w[i] * x[i];
+        }
+        long double m = sum / x.size(), wm = wsum / sum_w, ss = 0, wss = 0;
+        for (std::size_t i = 0; i < x.size(); ++i)
+        {
+            ss += (x[i] - m) * (x[i] - m);
+            wss += w[i] * (x[i] - wm) * (x[i] - wm);
+        }
+        mean = m;
+        variance = ss / (x.size() - 1);
+        weighted_mean = wm;
+        weighted_variance = wss / sum_w;
+        min = *std::min_element(x.begin(), x.end());
+        max = *std::max_element(x.begin(), x.end());
+    }
+    double mean, variance, weighted_mean, weighted_variance, min, max;
+};
+//----------------------------------------------------------------------------
+void check_against(const agile::column_stats &s, const reference &r,
+    std::size_t n, bool weighted, const std::string &where)
+{
+    check(s.count == n, where + ": count");
+    check_close(s.mean, r.mean, 1e-12 * std::fabs(r.mean), where + ": mean");
+    check_close(s.variance(), r.variance, 1e-10 * r.variance,
+        where + ": variance");
+    check((s.min == r.min) && (s.max == r.max), where + ": min and max");
+    if (weighted)
+    {
+        check_close(s.weighted_mean, r.weighted_mean,
+            1e-12 * std::fabs(r.weighted_mean), where + ": weighted mean");
+        check_close(s.weighted_variance(), r.weighted_variance,
+            1e-10 * r.weighted_variance, where + ": weighted variance");
+    }
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    // a large offset makes the naive sum of squares lose everything
+    const std::size_t n = 300000;
+    std::mt19937 gen(7);
+    std::normal_distribution<double> normal(1e6, 3.0);
+    std::uniform_real_distribution<double> uniform(0.5, 2.0);
+    std::vector<double> x(n), w(n), ones(n, 1.0);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        x[i] = normal(gen);
+        w[i] = uniform(gen);
+    }
+    const reference r(x, w), unit(x, ones);
+
+    agile::column_stats single;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        single.push(x[i], w[i]);
+    }
+    check_against(single, r, n, true, "push() one at a time");
+
+    agile::column_stats block;
+    block.push(x.data(), w.data(), n);
+    check_against(block, r, n, true, "push() of a block");
+
+    // merging uneven pieces, in and out of order, gives the single pass
+    const std::size_t cuts[] = {0, 1, 17, 4096, 100000, 100001, n};
+    std::vector<agile::column_stats> pieces;
+    for (std::size_t p = 0; p + 1 < sizeof(cuts) / sizeof(cuts[0]); ++p)
+    {
+        pieces.emplace_back();
+        pieces.back().push(x.data() + cuts[p], w.data() + cuts[p],
+            cuts[p + 1] - cuts[p]);
+    }
+    agile::column_stats forward, backward;
+    for (auto &piece : pieces)
+    {
+        forward.merge(piece);
+    }
+    for (auto it = pieces.rbegin(); it != pieces.rend(); ++it)
+    {
+        backward.merge(*it);
+    }
+    check_against(forward, r, n, true, "merged in order");
+    check_against(backward, r, n, true, "merged in reverse");
+
+    agile::column_stats empty, merged_empty(single);
+    merged_empty.merge(empty);
+    empty.merge(single);
+    check_against(merged_empty, r, n, true, "merging in an empty one");
+    check_against(empty, r, n, true, "merging into an empty one");
+
+    // the threaded passes, with and without weights
+    agile::column xc(agile::float64), wc(agile::float64);
+    xc.append(x.data(), agile::float64, n);
+    wc.append(w.data(), agile::float64, n);
+    agile::dataframe D;
+    D.add_column("x", xc);
+    D.add_column("w", wc);
+    for (unsigned int threads : {1u, 2u, 4u})
+    {
+        std::string where = std::to_string(threads) + " thread(s)";
+        auto weighted = agile::column_statistics(D, {"x"}, "w", threads);
+        check(weighted.size() == 1, where + ": one column");
+        check_against(weighted[0], r, n, true, where + ", weighted");
+
+        auto all = agile::column_statistics(D, {}, "", threads);
+        check(all.size() == 2, where + ": every column");
+        check_against(all[0], unit, n, true, where + ", unweighted");
+
+        const double *columns[] = {x.data()};
+        auto raw = agile::column_statistics(
+            std::vector<const double*>(columns, columns + 1), n, w.data(),
+            threads);
+        check_against(raw[0], r, n, true, where + ", from arrays");
+    }
+
+    return agile::checks::report("statistics_test");
+}
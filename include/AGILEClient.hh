@@ -16,38 +16,67 @@ public:
 	void load(std::stringstream &s);
 	std::map<std::string, double> predict(const std::map<std::string, double> &x);
 
+	// the fast path: in holds one value per inputs() name, in that order,
+	// and out gets one per outputs() name. Nothing is allocated per call.
+	void predict(const double *in, double *out);
+
 	std::vector<std::string> inputs();
+	std::vector<std::string> outputs();
+
+	// the compiled network, which any number of threads can share by each
+	// calling engine().predict(in, out, w) with its own make_workspace()
+	const agile::inference_plan& engine() const;
 
 private:
 	agile::neural_net net;
+	agile::inference_plan plan;
 };
 
 network_client::network_client() {}
 
 network_client::network_client(const std::string &filename) 
 {
-	net.from_yaml(filename);
+	load(filename);
 }
 
+// the network is compiled into an inference_plan once, right here
 inline void network_client::load(const std::string &filename)
 {
-	net.from_yaml(filename);
+	net.from_file(filename);
+	plan.compile(net);
 }
 
 inline void network_client::load(std::stringstream &s)
 {
 	net.from_yaml(s);
+	plan.compile(net);
 }
 
 
 inline std::map<std::string, double> network_client::predict(const std::map<std::string, double> &x)
 {
-	return std::move(net.predict_map(x));
+	return plan.predict(x);
+}
+
+inline void network_client::predict(const double *in, double *out)
+{
+	plan.predict(in, out);
 }
 
+// the variables predict() needs -- derived inputs are computed from these
 inline std::vector<std::string> network_client::inputs()
 {
-	return net.get_inputs();
+	return plan.inputs();
+}
+
+inline std::vector<std::string> network_client::outputs()
+{
+	return plan.outputs();
+}
+
+inline const agile::inference_plan& network_client::engine() const
+{
+	return plan;
 }
 
 
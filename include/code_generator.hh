@@ -0,0 +1,48 @@
+//-----------------------------------------------------------------------------
+//  code_generator.hh:
+//  Header for turning a trained neural_net into a standalone C++ header,
+//  with the shapes and weights fixed at compile time
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef CODE__GENERATOR__HH
+#define CODE__GENERATOR__HH
+
+#include "inference_plan.hh"
+#include <ostream>
+
+namespace agile
+{
+//----------------------------------------------------------------------------
+//  code_generator -- writes a header depending on nothing but <cmath>, in
+//  which namespace <name> holds n_inputs, n_outputs, input_names,
+//  output_names and
+//
+//      inline void predict(const double *in, double *out);
+//
+//  doing what inference_plan::predict() does for the same network. Layers
+//  with at most unroll() weights are written out as straight-line code
+//  with the weights as literals; bigger ones loop over constexpr arrays.
+//----------------------------------------------------------------------------
+class code_generator
+{
+public:
+    explicit code_generator(neural_net &net, bool scale = true);
+
+    code_generator& set_name(const std::string &name);
+    code_generator& set_unroll(std::size_t max_weights);
+
+    std::size_t unroll() const { return m_unroll; }
+
+    void write(std::ostream &out) const;
+    void write(const std::string &filename) const;
+
+private:
+    inference_plan m_plan;
+    std::string m_name;
+    std::size_t m_unroll;
+};
+
+}
+
+#endif
@@ -0,0 +1,115 @@
+//-----------------------------------------------------------------------------
+//  inference_client.hh:
+//  Header-only client for an inference_server, with the same predict()
+//  calls as network_client. It needs nothing from AGILEPack to build.
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef INFERENCE__CLIENT__HH
+#define INFERENCE__CLIENT__HH
+
+#include "local_socket.hh"
+#include <map>
+
+namespace agile
+{
+//----------------------------------------------------------------------------
+//  inference_client -- one connection to the server. Calls block until the
+//  server answers, so each thread should have its own client.
+//----------------------------------------------------------------------------
+class inference_client
+{
+public:
+    inference_client() : m_fd(-1) {}
+    explicit inference_client(const std::string &socket_path) : m_fd(-1)
+    {
+        connect(socket_path);
+    }
+    ~inference_client() { disconnect(); }
+
+    inference_client(const inference_client &) = delete;
+    inference_client& operator =(const inference_client &) = delete;
+
+    void connect(const std::string &socket_path);
+    void disconnect();
+
+    std::map<std::string, double> predict(
+        const std::map<std::string, double> &x);
+
+    // in holds one value per inputs() name, in that order, and out gets one
+    // per outputs() name
+    void predict(const double *in, double *out);
+
+    const std::vector<std::string>& inputs() const { return m_inputs; }
+    const std::vector<std::string>& outputs() const { return m_outputs; }
+
+private:
+    int m_fd;
+    std::vector<std::string> m_inputs, m_outputs;
+    std::vector<double> m_in, m_out;
+};
+
+//----------------------------------------------------------------------------
+inline void inference_client::connect(const std::string &socket_path)
+{
+    disconnect();
+    m_fd = local_socket::connect_to(socket_path);
+    if (!local_socket::read_names(m_fd, m_inputs) ||
+        !local_socket::read_names(m_fd, m_outputs))
+    {
+        disconnect();
+        throw std::runtime_error("server at " + socket_path +
+            " closed the connection.");
+    }
+    m_in.resize(m_inputs.size());
+    m_out.resize(m_outputs.size());
+}
+//----------------------------------------------------------------------------
+inline void inference_client::disconnect()
+{
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+//----------------------------------------------------------------------------
+inline void inference_client::predict(const double *in, double *out)
+{
+    if (m_fd < 0)
+    {
+        throw std::logic_error("inference_client isn't connected.");
+    }
+    if (!local_socket::write_all(m_fd, in, m_inputs.size() * sizeof(double))
+        || !local_socket::read_all(m_fd, out,
+            m_outputs.size() * sizeof(double)))
+    {
+        disconnect();
+        throw std::runtime_error("inference server went away.");
+    }
+}
+//----------------------------------------------------------------------------
+inline std::map<std::string, double> inference_client::predict(
+    const std::map<std::string, double> &x)
+{
+    for (std::size_t i = 0; i < m_inputs.size(); ++i)
+    {
+        auto it = x.find(m_inputs[i]);
+        if (it == x.end())
+        {
+            throw std::out_of_range("missing input " + m_inputs[i]);
+        }
+        m_in[i] = it->second;
+    }
+    predict(m_in.data(), m_out.data());
+    std::map<std::string, double> y;
+    for (std::size_t i = 0; i < m_outputs.size(); ++i)
+    {
+        y[m_outputs[i]] = m_out[i];
+    }
+    return y;
+}
+
+}
+
+#endif
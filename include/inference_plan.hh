@@ -0,0 +1,100 @@
+//-----------------------------------------------------------------------------
+//  inference_plan.hh:
+//  Header for a trained neural_net compiled down to flat arrays, so that
+//  predicting one sample needs no name lookups and no allocations
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef INFERENCE__PLAN__HH
+#define INFERENCE__PLAN__HH
+
+#include "neural_net.hh"
+
+namespace agile
+{
+//----------------------------------------------------------------------------
+//  inference_plan -- everything neural_net::predict_map() looks up per call
+//  is resolved once here: the inputs become numbered slots, the derived
+//  inputs compiled expressions reading those slots, the scaling a multiply
+//  and add per input.
+//
+//  A compiled plan is never written to by the const methods, so one plan
+//  can be shared by any number of threads. The scratch space for a call
+//  lives in a workspace, which each thread keeps its own of.
+//----------------------------------------------------------------------------
+class inference_plan
+{
+public:
+    // scratch space for predict(), sized and laid out by the plan that 
+    // made it. Its buffers start on a cache line and fill whole lines, so
+    // workspaces of different threads never share one.
+    class workspace
+    {
+    public:
+        workspace() = default;
+    private:
+        friend class inference_plan;
+        std::vector<double> m_storage;
+    };
+
+    inference_plan();
+    explicit inference_plan(neural_net &net, bool scale = true);
+
+    // not thread safe -- compile before handing the plan out
+    void compile(neural_net &net, bool scale = true);
+
+    workspace make_workspace() const;
+
+    // in holds one value per inputs() name, in that order, and out gets
+    // one per outputs() name. Allocates nothing, and is safe to call from
+    // many threads at once as long as each passes its own workspace.
+    void predict(const double *in, double *out, workspace &w) const;
+
+    // the same, using a workspace owned by the plan (one thread only)
+    void predict(const double *in, double *out);
+
+    // the slow but friendly way, for when the inputs come as a map
+    std::map<std::string, double> predict(
+        const std::map<std::string, double> &x) const;
+
+    const std::vector<std::string>& inputs() const { return m_inputs; }
+    const std::vector<std::string>& outputs() const { return m_outputs; }
+
+private:
+    friend class code_generator;
+    friend class quantized_net;
+    friend class model_set;
+
+    // fills x with the scaled network inputs for the values in
+    void load_inputs(const double *in, double *x) const;
+
+    struct stage
+    {
+        agile::matrix W;
+        agile::vector b;
+        layer_type type;
+    };
+
+    std::vector<std::string> m_inputs, m_outputs;
+
+    // network input i is in[m_slot[i]], or m_expr[i](in) if m_slot[i] < 0
+    std::vector<long> m_slot;
+    std::vector<agile::expression> m_expr;
+
+    // scaled input = raw * m_mul + m_add, with m_mul = 1 / sd and
+    // m_add = -mean / sd (or 1 and 0 if unscaled)
+    agile::vector m_mul, m_add;
+
+    std::vector<stage> m_stages;
+
+    // where buffer 0 (the network input) and buffer i + 1 (stage i's 
+    // output) start in a workspace, and how many doubles that needs
+    std::vector<std::size_t> m_offset, m_length;
+    std::size_t m_workspace_size;
+
+    workspace m_own;
+};
+
+}
+
+#endif
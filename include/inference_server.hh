@@ -0,0 +1,106 @@
+//-----------------------------------------------------------------------------
+//  inference_server.hh:
+//  Header for a local inference service, which holds one copy of a network
+//  and scores the requests of many clients in micro-batches
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef INFERENCE__SERVER__HH
+#define INFERENCE__SERVER__HH
+
+#include "neural_net.hh"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+
+namespace agile
+{
+//----------------------------------------------------------------------------
+//  inference_server -- listens on a Unix domain socket. On connecting, a
+//  client is sent the input and output names, and from then on every
+//  request is the inputs as raw doubles (in that order), answered with the
+//  outputs the same way.
+//
+//  Requests from all connections go into one queue. A batch is run through
+//  neural_net::predict_batch() as soon as max_batch requests are waiting,
+//  or when the oldest has waited for the deadline, whichever comes first
+//  (and straight away if every open connection has a request waiting).
+//----------------------------------------------------------------------------
+class inference_server
+{
+public:
+    explicit inference_server(const std::string &yaml_file);
+    explicit inference_server(const neural_net &net);
+    ~inference_server();
+
+    inference_server(const inference_server &) = delete;
+    inference_server& operator =(const inference_server &) = delete;
+
+    // defaults are 64 requests and 200 microseconds
+    inference_server& set_max_batch(std::size_t n);
+    inference_server& set_deadline(std::chrono::microseconds deadline);
+
+    // starts serving on socket_path in the background
+    void start(const std::string &socket_path);
+
+    // stops taking connections, answers what's queued, and closes up
+    void stop();
+
+    const std::vector<std::string>& inputs() const { return m_inputs; }
+    const std::vector<std::string>& outputs() const { return m_outputs; }
+
+    unsigned long long requests() const { return m_requests; }
+    unsigned long long batches() const { return m_batches; }
+
+private:
+    // one per connection, reused for each of its requests
+    struct request
+    {
+        std::vector<double> in, out;
+        std::chrono::steady_clock::time_point arrived;
+        bool done;
+        std::mutex m;
+        std::condition_variable cv;
+    };
+
+    // a connection's thread, and whether serve() is done with it
+    struct connection
+    {
+        std::thread thread;
+        std::atomic<bool> finished;
+    };
+
+    void setup();
+    void accept_loop();
+    void serve(int fd, std::atomic<bool> *finished);
+    void batch_loop();
+
+    neural_net m_net;
+    std::vector<std::string> m_inputs, m_outputs;
+    std::size_t m_max_batch;
+    std::chrono::microseconds m_deadline;
+
+    std::string m_path;
+    int m_listen;
+    std::atomic<bool> m_running;
+    std::thread m_acceptor, m_batcher;
+
+    std::mutex m_connection_mutex;
+    std::list<connection> m_connections; // finished ones joined on accept
+    std::vector<int> m_fds;
+    std::atomic<std::size_t> m_open; // connections, for batching early
+
+    std::mutex m_queue_mutex;
+    std::condition_variable m_queue_cv;
+    std::deque<request*> m_queue;
+
+    std::atomic<unsigned long long> m_requests, m_batches;
+};
+
+}
+
+#endif
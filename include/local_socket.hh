@@ -0,0 +1,183 @@
+//-----------------------------------------------------------------------------
+//  local_socket.hh:
+//  Header for the few Unix domain socket calls the inference service needs
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef LOCAL__SOCKET__HH
+#define LOCAL__SOCKET__HH
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace agile
+{
+namespace local_socket
+{
+//----------------------------------------------------------------------------
+inline sockaddr_un address(const std::string &path)
+{
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        throw std::invalid_argument("socket path too long: " + path);
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+    return addr;
+}
+//----------------------------------------------------------------------------
+//  a socket listening on path, replacing whatever was there
+//----------------------------------------------------------------------------
+inline int listen_on(const std::string &path, int backlog = 128)
+{
+    sockaddr_un addr = address(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        throw std::runtime_error("can't create socket: " +
+            std::string(std::strerror(errno)));
+    }
+    unlink(path.c_str());
+    if ((bind(fd, (sockaddr*) &addr, sizeof(addr)) < 0) ||
+        (listen(fd, backlog) < 0))
+    {
+        int err = errno;
+        close(fd);
+        throw std::runtime_error("can't listen on " + path + ": " +
+            std::string(std::strerror(err)));
+    }
+    return fd;
+}
+//----------------------------------------------------------------------------
+inline int connect_to(const std::string &path)
+{
+    sockaddr_un addr = address(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        throw std::runtime_error("can't create socket: " +
+            std::string(std::strerror(errno)));
+    }
+    if (connect(fd, (sockaddr*) &addr, sizeof(addr)) < 0)
+    {
+        int err = errno;
+        close(fd);
+        throw std::runtime_error("can't connect to " + path + ": " +
+            std::string(std::strerror(err)));
+    }
+    return fd;
+}
+//----------------------------------------------------------------------------
+//  reads or writes exactly n bytes. Returns false if the other end closed
+//  the connection first, and throws on any other error.
+//----------------------------------------------------------------------------
+inline bool read_all(int fd, void *buf, std::size_t n)
+{
+    char *p = static_cast<char*>(buf);
+    while (n > 0)
+    {
+        ssize_t got = read(fd, p, n);
+        if (got == 0)
+        {
+            return false;
+        }
+        if (got < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if ((errno == ECONNRESET) || (errno == EBADF))
+            {
+                return false;
+            }
+            throw std::runtime_error("socket read failed: " +
+                std::string(std::strerror(errno)));
+        }
+        p += got;
+        n -= got;
+    }
+    return true;
+}
+//----------------------------------------------------------------------------
+inline bool write_all(int fd, const void *buf, std::size_t n)
+{
+    const char *p = static_cast<const char*>(buf);
+    while (n > 0)
+    {
+        ssize_t put = send(fd, p, n, MSG_NOSIGNAL);
+        if (put < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if ((errno == EPIPE) || (errno == ECONNRESET) || (errno == EBADF))
+            {
+                return false;
+            }
+            throw std::runtime_error("socket write failed: " +
+                std::string(std::strerror(errno)));
+        }
+        p += put;
+        n -= put;
+    }
+    return true;
+}
+//----------------------------------------------------------------------------
+//  names go over the wire as a count, then a length and the bytes of each
+//----------------------------------------------------------------------------
+inline void append_names(std::vector<char> &buf,
+    const std::vector<std::string> &names)
+{
+    auto put = [&buf](std::uint32_t v)
+    {
+        const char *p = reinterpret_cast<const char*>(&v);
+        buf.insert(buf.end(), p, p + sizeof(v));
+    };
+    put(names.size());
+    for (auto &name : names)
+    {
+        put(name.size());
+        buf.insert(buf.end(), name.begin(), name.end());
+    }
+}
+//----------------------------------------------------------------------------
+inline bool read_names(int fd, std::vector<std::string> &names)
+{
+    std::uint32_t n;
+    if (!read_all(fd, &n, sizeof(n)))
+    {
+        return false;
+    }
+    names.resize(n);
+    for (auto &name : names)
+    {
+        std::uint32_t len;
+        if (!read_all(fd, &len, sizeof(len)))
+        {
+            return false;
+        }
+        name.resize(len);
+        if ((len > 0) && !read_all(fd, &name[0], len))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+}
+
+#endif
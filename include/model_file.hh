@@ -0,0 +1,94 @@
+//-----------------------------------------------------------------------------
+//  model_file.hh:
+//  Header for the binary model format: the YAML a network is saved as, with
+//  the matrices taken out into aligned blocks that can be used in place
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef MODEL__FILE__HH
+#define MODEL__FILE__HH
+
+#include "agile/agile_base.hh"
+#include "dataframe/include/mapped_file.hh"
+#include <cstdint>
+
+namespace agile
+{
+//-----------------------------------------------------------------------------
+//  Layout of a model file (all integers little endian):
+//
+//      char[8]   magic ("AGILENN" + NUL)
+//      uint32    format version
+//      uint32    number of blocks
+//      uint64    length of the metadata
+//      uint64    offset of the metadata from the start of the file
+//
+//  followed by one descriptor per block
+//
+//      uint64    rows, uint64 columns
+//      uint64    offset of the block data from the start of the file
+//
+//  The metadata is the YAML document the model would be saved as, except
+//  that every stringified matrix ("#EM|...") is replaced by a reference
+//  ("#EB|<block>") to a block. A block is the matrix's float64 values in
+//  column major order (Eigen's, so agile::matrix can map it), and starts on
+//  a 64 byte boundary.
+//-----------------------------------------------------------------------------
+namespace model_format
+{
+    const char magic[8] = {'A', 'G', 'I', 'L', 'E', 'N', 'N', '\0'};
+    const std::uint32_t version = 1;
+    const std::size_t alignment = 64;
+}
+
+// writes metadata (with "#EB|i" referring to blocks[i]) and the blocks
+void write_model_file(const std::string &filename, const std::string &metadata,
+    const std::vector<agile::matrix> &blocks);
+
+// true if filename starts like a model file (rather than YAML)
+bool is_model_file(const std::string &filename);
+
+// lossless conversions between the YAML and binary forms of a saved model,
+// including anything saved alongside the network (branches, binning, ...)
+void yaml_to_model_file(const std::string &yaml_file,
+    const std::string &model_file);
+void model_file_to_yaml(const std::string &model_file,
+    const std::string &yaml_file);
+
+//-----------------------------------------------------------------------------
+//  mapped_model -- read-only memory mapped view of a model file. The blocks
+//  are Eigen maps straight into the file, so nothing is parsed or copied.
+//-----------------------------------------------------------------------------
+class mapped_model
+{
+public:
+    typedef Eigen::Map<const agile::matrix, Eigen::Aligned> matrix_map;
+
+    explicit mapped_model(const std::string &filename = "");
+
+    void open(const std::string &filename);
+    void close();
+    bool is_open() const { return m_file.data() != nullptr; }
+
+    // the metadata, with the matrices left as "#EB|<block>" references
+    const YAML::Node& document() const { return m_document; }
+
+    std::size_t blocks() const { return m_rows.size(); }
+    matrix_map block(std::size_t idx) const;
+
+    // the block a "#EB|<block>" reference refers to
+    matrix_map block(const std::string &reference) const;
+
+    // the document as it would be saved in YAML, matrices and all
+    YAML::Node to_yaml() const;
+
+private:
+    mapped_file m_file;
+    std::string m_metadata;
+    YAML::Node m_document;
+    std::vector<std::size_t> m_rows, m_cols, m_offsets;
+};
+
+}
+
+#endif
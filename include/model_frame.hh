@@ -8,6 +8,7 @@
 #define MODEL__FRAME__HH 
 #include "dataframe/dataframe_core.hh"
 #include "agile/agile_base.hh"
+#include "dataframe/include/number_format.hh"
 #include <unordered_set>
 
 //----------------------------------------------------------------------------
@@ -23,19 +24,24 @@ struct scaling
 inline void calc_normalization(const agile::vector &input, 
     const std::string col_name, agile::scaling &scale)
 {
-    unsigned int count = input.rows();
-    double M = input(0);
-    double Q = 0.0;
-    for (unsigned int k = 1 ; k < count ; k++) 
+    agile::column_stats stats;
+    stats.push(input.data(), input.rows());
+    scale.sd[col_name] = stats.sd();
+    scale.mean[col_name] = stats.mean;
+}
+
+//----------------------------------------------------------------------------
+// builds the scaling from (possibly merged) column statistics
+inline agile::scaling make_scaling(const std::vector<std::string> &names,
+    const std::vector<agile::column_stats> &stats)
+{
+    agile::scaling scale;
+    for (unsigned int i = 0; i < names.size(); ++i)
     {
-        double del = input(k) - M;
-        unsigned int j = k + 1;
-        Q += k * (del * del) / j;
-        M += del / j;
+        scale.mean[names[i]] = stats.at(i).mean;
+        scale.sd[names[i]] = stats.at(i).sd();
     }
-    double sd = std::sqrt(Q / (count - 1));
-    scale.sd[col_name] = sd;
-    scale.mean[col_name] = M;
+    return scale;
 }
 
 //-----------------------------------------------------------------------------
@@ -82,6 +88,10 @@ public:
     std::vector<std::string> get_inputs();
     std::vector<std::string> get_outputs();
 
+    // the derived terms of the formula (like "log(m)" or "I(tau2/tau1)"),
+    // mapping the name of each term to its expression
+    std::map<std::string, std::string> get_derived();
+
     bool is_weighted()
     {
         return weights_set;
@@ -94,6 +104,9 @@ private:
 //-----------------------------------------------------------------------------
 
     void parse_formula(std::string formula);
+
+    // fills out with the column or derived variable called name
+    void extract(const std::string &name, double *out);
     // void parse_constraint(std::string formula);
 
     agile::dataframe DF;
@@ -108,7 +121,7 @@ private:
 
     std::vector<std::string> inputs, outputs;
 
-    std::unordered_set<std::string> exclusions;
+    std::map<std::string, agile::expression> m_derived;
 
     bool x_set, y_set, weights_set;
 
@@ -116,14 +129,6 @@ private:
 
 };
 
-//-----------------------------------------------------------------------------
-//  Error for bd formula parsing
-//-----------------------------------------------------------------------------
-class parsing_error : public std::runtime_error
-{
-public:
-    parsing_error(const std::string &what);
-};
 }
 
 
@@ -135,11 +140,16 @@ struct convert<agile::scaling>
 {
     static Node encode(const agile::scaling &scale)
     {
+        // written out by hand, as YAML would round them to 16 digits
         Node node;
-
-        node["mean"] = scale.mean;
-        node["sd"] = scale.sd;
-
+        for (auto &entry : scale.mean)
+        {
+            node["mean"][entry.first] = agile::format_double(entry.second);
+        }
+        for (auto &entry : scale.sd)
+        {
+            node["sd"][entry.first] = agile::format_double(entry.second);
+        }
         return node;
     }
 
@@ -151,6 +161,49 @@ struct convert<agile::scaling>
     }
 };
 
+//----------------------------------------------------------------------------
+// so partial statistics can be written out by one job and merged by another
+template<>
+struct convert<agile::column_stats> 
+{
+    static Node encode(const agile::column_stats &stats)
+    {
+        Node node;
+
+        using agile::format_double;
+        node["count"] = static_cast<unsigned long long>(stats.count);
+        node["mean"] = format_double(stats.mean);
+        node["m2"] = format_double(stats.m2);
+        if (stats.count > 0)
+        {
+            node["min"] = format_double(stats.min);
+            node["max"] = format_double(stats.max);
+        }
+        node["sum_w"] = format_double(stats.sum_w);
+        node["weighted_mean"] = format_double(stats.weighted_mean);
+        node["weighted_m2"] = format_double(stats.weighted_m2);
+
+        return node;
+    }
+
+    static bool decode(const Node& node, agile::column_stats &stats) 
+    {
+        stats = agile::column_stats();
+        stats.count = node["count"].as<unsigned long long>();
+        stats.mean = node["mean"].as<double>();
+        stats.m2 = node["m2"].as<double>();
+        if (stats.count > 0)
+        {
+            stats.min = node["min"].as<double>();
+            stats.max = node["max"].as<double>();
+        }
+        stats.sum_w = node["sum_w"].as<double>();
+        stats.weighted_mean = node["weighted_mean"].as<double>();
+        stats.weighted_m2 = node["weighted_m2"].as<double>();
+        return true;
+    }
+};
+
 } // end namespace yaml
 
 
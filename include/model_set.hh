@@ -0,0 +1,87 @@
+//-----------------------------------------------------------------------------
+//  model_set.hh:
+//  Header for scoring the same samples with several trained networks at
+//  once, sharing the work their inputs have in common
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef MODEL__SET__HH
+#define MODEL__SET__HH
+
+#include "inference_plan.hh"
+
+namespace agile
+{
+//----------------------------------------------------------------------------
+//  model_set -- the networks are compiled together. Their base inputs are
+//  merged into one list, each distinct derived input is computed once, and
+//  so is each distinct scaled input (the same variable with the same mean
+//  and sd), however many of the networks use it. Every network's layers
+//  then run off those shared columns.
+//
+//  Each network gets one output column per output, named after the model:
+//  "<name>" for a network with one output, "<name>_<output>" otherwise, or
+//  just "<output>" if the name is empty.
+//----------------------------------------------------------------------------
+class model_set
+{
+public:
+    model_set();
+
+    // the name defaults to the file name, without its directory or extension
+    model_set& add(const std::string &yaml_file);
+    model_set& add(const std::string &yaml_file, const std::string &name);
+    model_set& add(neural_net &net, const std::string &name,
+        bool scale = true);
+
+    std::size_t size() const { return m_models.size(); }
+
+    // every base input any of the networks needs, in the order first seen
+    const std::vector<std::string>& inputs() const { return m_inputs; }
+    const std::vector<std::string>& outputs() const { return m_outputs; }
+
+    // scaled inputs computed per sample, and how many the networks take
+    // between them (the difference is what sharing saves)
+    std::size_t shared_inputs() const { return m_features.size(); }
+    std::size_t total_inputs() const;
+
+    // one row per sample with the columns in inputs() order, giving one row
+    // per sample with the columns in outputs() order. Done a tile of
+    // tile_rows rows at a time, spread over n_threads (0 for all cores).
+    agile::matrix predict_batch(const agile::matrix &X,
+        std::size_t tile_rows = 1024, unsigned int n_threads = 1) const;
+
+    // every row of D, which needs a column for each inputs() name. Gives a
+    // dataframe with the outputs() columns.
+    agile::dataframe predict(const agile::dataframe &D,
+        std::size_t tile_rows = 1024, unsigned int n_threads = 0) const;
+
+private:
+    // a scaled input: column slot of the batch (or derived input expr if
+    // slot < 0), times mul plus add
+    struct feature
+    {
+        long slot, expr;
+        double mul, add;
+    };
+
+    struct model
+    {
+        std::string name;
+        std::vector<std::size_t> features; // network input i is features[i]
+        std::vector<inference_plan::stage> stages;
+        std::size_t first_output, n_outputs;
+    };
+
+    // index of name in m_inputs, adding it if it's new
+    std::size_t input_slot(const std::string &name);
+
+    std::vector<std::string> m_inputs, m_outputs;
+    std::vector<agile::expression> m_exprs;
+    std::vector<feature> m_features;
+    std::vector<model> m_models;
+};
+
+}
+
+#endif
@@ -8,6 +8,7 @@
 namespace agile
 {
     class neural_net;
+    class inference_plan;
 }
 namespace YAML
 {
@@ -49,6 +50,12 @@ public:
         const std::map<std::string, std::vector<double>> &binning,
         const std::map<std::string, std::vector<double>> &constraints);
 
+    // the binary model format (see model_file.hh), which loads in a small
+    // fraction of the time YAML takes. from_file() reads either kind.
+    void from_binary(const std::string &filename);
+    void to_binary(const std::string &filename);
+    void from_file(const std::string &filename);
+
     // void load_config(const std::string &config);
 
     // template <class T>
@@ -65,13 +72,40 @@ public:
     std::map<std::string, double> predict_map(std::map<std::string, double> v, 
         bool scale = true);
 
+    // in holds the inputs in get_base_inputs() order, and out gets the 
+    // outputs in get_outputs() order -- no name lookups or maps per call.
+    void predict_ordered(const double *in, double *out, bool scale = true);
+
+    // a block of samples at once, one per row of X with the columns in 
+    // get_base_inputs() order. Gives one row of outputs per sample, in 
+    // get_outputs() order. The derived inputs and scaling are done a tile of
+    // tile_rows rows at a time along with the layers, so memory stays 
+    // bounded, and tiles are spread over n_threads threads (0 for all cores).
+    agile::matrix predict_batch(const agile::matrix &X, bool scale = true,
+        std::size_t tile_rows = 1024, unsigned int n_threads = 1);
+
     std::vector<std::string> get_inputs();
     std::vector<std::string> get_outputs();
 
+    // the variables a caller has to supply: the plain inputs, followed by
+    // whatever else the derived inputs (like "log(m)") are computed from.
+    // This is get_inputs() if the formula had no derived terms.
+    std::vector<std::string> get_base_inputs();
+
     void load_scaling(const agile::scaling &scale);
     void load_scaling(agile::scaling &&scale);
     agile::scaling get_scaling();
 
+    // folds the input scaling into the first layer (W / sd, and 
+    // b - W * mean / sd), so the network takes raw inputs and predicting 
+    // skips the scaling step whatever scale is. The folded network is
+    // checked against the original on random inputs, and if any output
+    // moves by more than tol the weights are put back and this throws.
+    // Returns the largest deviation seen. Do this after training, as the 
+    // fold is saved with the network.
+    double fold_scaling(double tol = 1e-6);
+    bool scaling_folded();
+
     void load_model_frame_config(agile::model_frame &m);
 
 // Overrides
@@ -97,7 +131,15 @@ private:
         int freq = 0, const std::string &filename = "tempnet.yaml");
 
 
+    // resolves the base inputs, derived expressions and scaling into 
+    // vectors in predictor_order
+    void prepare_inputs();
+
+    // fills m_tmp_input from values in m_base_inputs order
+    void load_inputs(const double *base, bool scale);
+
     friend struct YAML::convert<neural_net>;
+    friend class inference_plan;
     std::vector<std::string> predictor_order, target_order;
 
     agile::matrix X, Y, pattern_weights;
@@ -107,6 +149,14 @@ private:
     bool m_checked, m_weighted;
     agile::vector m_tmp_input, m_tmp_output;
     agile::scaling m_scaling;
+    std::map<std::string, std::string> m_derived;
+
+    std::vector<std::string> m_base_inputs;
+    std::vector<long> m_input_base; // index into the base inputs, or -1
+    std::vector<agile::expression> m_input_expr;
+    std::vector<double> m_tmp_base;
+    agile::vector m_input_shift, m_input_scale;
+    bool m_ordered_ready, m_scaling_folded;
 };
 
 }
@@ -142,6 +192,15 @@ struct convert<agile::neural_net>
         node["target_order"] = arch.target_order;
 
         node["scaling"] = arch.m_scaling;
+        if (arch.m_scaling_folded)
+        {
+            node["scaling_folded"] = true;
+        }
+
+        if (!arch.m_derived.empty())
+        {
+            node["derived"] = arch.m_derived;
+        }
 
         // if(arch.m_weighted())
         // {
@@ -184,10 +243,19 @@ struct convert<agile::neural_net>
         arch.predictor_order = node["input_order"].as<std::vector<std::string>>();
         arch.target_order = node["target_order"].as<std::vector<std::string>>();
 
+        arch.m_derived.clear();
+        if (node["derived"])
+        {
+            arch.m_derived = 
+                node["derived"].as<std::map<std::string, std::string>>();
+        }
+
         agile::scaling s = node["scaling"].as<agile::scaling>();
 
 
         arch.load_scaling(s);
+        arch.m_scaling_folded = node["scaling_folded"] && 
+            node["scaling_folded"].as<bool>();
 
         return true;
     }
@@ -0,0 +1,104 @@
+//-----------------------------------------------------------------------------
+//  quantized_net.hh:
+//  Header for a trained neural_net with its weights quantized to 8 or 16
+//  bit integers, for cheap per-sample predictions
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef QUANTIZED__NET__HH
+#define QUANTIZED__NET__HH
+
+#include "inference_plan.hh"
+#include <cstdint>
+
+namespace agile
+{
+//----------------------------------------------------------------------------
+//  quantized_net -- each row of every weight matrix is stored as integers
+//  times one scale for the row, max|row| / (2^(bits - 1) - 1). The input of
+//  every layer is quantized the same way before the integer dot products,
+//  and the biases and activations stay floating point (with a table based
+//  sigmoid).
+//
+//  The activation scales are worked out per call from the largest input,
+//  until calibrate() fixes them from a sample of data, which also saves
+//  finding the largest value every call.
+//----------------------------------------------------------------------------
+class quantized_net
+{
+public:
+    // scratch space for predict(), as for an inference_plan
+    class workspace
+    {
+    public:
+        workspace() = default;
+    private:
+        friend class quantized_net;
+        std::vector<double> m_a, m_b;
+        std::vector<std::int8_t> m_q8;
+        std::vector<std::int16_t> m_q16;
+    };
+
+    // bits is 8 or 16
+    explicit quantized_net(neural_net &net, int bits = 8,
+        bool scale = true);
+
+    // fixes the activation scales from (up to max_rows of) D, which needs a
+    // column for every inputs() name. Returns max_deviation(D, max_rows).
+    double calibrate(const agile::dataframe &D,
+        std::size_t max_rows = 100000);
+
+    // largest difference between any output of this and of the floating
+    // point network, over (up to max_rows of) D
+    double max_deviation(const agile::dataframe &D,
+        std::size_t max_rows = 100000) const;
+
+    workspace make_workspace() const;
+
+    // same layout as inference_plan::predict(), and just as thread safe
+    void predict(const double *in, double *out, workspace &w) const;
+    void predict(const double *in, double *out);
+
+    const std::vector<std::string>& inputs() const { return m_plan.inputs(); }
+    const std::vector<std::string>& outputs() const
+    {
+        return m_plan.outputs();
+    }
+    int bits() const { return m_bits; }
+    bool calibrated() const { return !m_input_scale.empty(); }
+
+private:
+    struct stage
+    {
+        long rows, cols;
+        std::vector<std::int8_t> W8;    // row major, used if m_bits == 8
+        std::vector<std::int16_t> W16;  // row major, used if m_bits == 16
+        std::vector<double> row_scale;
+        agile::vector b;
+        layer_type type;
+    };
+
+    // runs layer l (s, with weights W) on x into y, quantizing x into q
+    template <class Q>
+    void run(const stage &s, std::size_t l, const Q *W, const double *x,
+        double *y, Q *q) const;
+
+    // copies (up to max_rows of) the inputs() columns of D out row by row
+    std::vector<double> gather(const agile::dataframe &D,
+        std::size_t max_rows) const;
+
+    inference_plan m_plan;
+    int m_bits;
+    double m_qmax;
+    std::size_t m_width; // widest layer, for the workspace buffers
+    std::vector<stage> m_stages;
+
+    // fixed scale of each layer's input, empty until calibrate()
+    std::vector<double> m_input_scale;
+
+    workspace m_own;
+};
+
+}
+
+#endif
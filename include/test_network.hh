@@ -0,0 +1,61 @@
+//-----------------------------------------------------------------------------
+//  test_network.hh:
+//  Header for the small network and data the *_test programs check the
+//  different ways of running a network against
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef TEST__NETWORK__HH
+#define TEST__NETWORK__HH
+
+#include "neural_net.hh"
+#include <map>
+#include <random>
+
+namespace agile
+{
+namespace checks
+{
+
+// n rows of the inputs a, b, c and the targets y0, y1, the same every time
+// for the same seed
+inline agile::dataframe test_frame(std::size_t n, unsigned int seed = 1)
+{
+    std::mt19937 gen(seed);
+    std::normal_distribution<double> normal(0.5, 2.0);
+    agile::dataframe D;
+    D.set_column_names({"a", "b", "c", "y0", "y1"});
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        double a = normal(gen), b = normal(gen), c = normal(gen);
+        D.push_back(std::vector<double>{a, b, c, (a * b > 0) ? 1.0 : 0.0,
+            (c > 1.0) ? 1.0 : 0.0});
+    }
+    return D;
+}
+//----------------------------------------------------------------------------
+// an untrained (randomly initialized) network on D, with a derived input
+// and the inputs scaled: y0 + y1 ~ a + b + log(abs(a*c)+1), through
+// rectified layers of 32 and 16 to sigmoid outputs
+inline void build_test_network(agile::neural_net &net,
+    const agile::dataframe &D)
+{
+    net.add_data(D);
+    net.model_formula("y0 + y1 ~ a + b + log(abs(a*c)+1)");
+    net.emplace_back(new layer(3, 32, rectified));
+    net.emplace_back(new layer(32, 16, rectified));
+    net.emplace_back(new layer(16, 2, sigmoid));
+    net.check(false);
+}
+//----------------------------------------------------------------------------
+// row r of D's a, b and c, as predict_map() takes them
+inline std::map<std::string, double> test_inputs(const agile::dataframe &D,
+    std::size_t r)
+{
+    return {{"a", D.at(r, "a")}, {"b", D.at(r, "b")}, {"c", D.at(r, "c")}};
+}
+
+}
+}
+
+#endif
@@ -42,6 +42,7 @@ public:
     inline binner& set_bins(const std::initializer_list<double> &il);
     inline binner& set_bins(const std::vector<double> &v);
 
+    inline std::string get_name() const {return m_name;}
     inline std::vector<double> get_bins();
 
     inline bool is_absolute() {return m_abs;} 
@@ -59,6 +60,10 @@ public:
     template <typename T>
     inline bool in_range(const T& var);
 
+    // bin of val (after taking its absolute value if set), or -1 if it's 
+    // outside the bins. The top edge belongs to the last bin.
+    inline int lookup(double val) const;
+
     inline ~binner();
 //----------------------------------------------------------------------------
 private:
@@ -203,18 +208,36 @@ inline binner::~binner()
 //----------------------------------------------------------------------------
 
 
+inline int binner::lookup(double val) const
+{
+    val = m_abs ? fabs(val) : val;
+    const std::size_t n_edges = m_bins.size();
+    if ((n_edges < 2) || !((val >= m_bins.front()) && (val <= m_bins.back())))
+    {
+        return -1;
+    }
+    // binary search without branches on the data: base ends up on the last
+    // edge that's <= val
+    const double *base = m_bins.data();
+    std::size_t n = n_edges - 1;
+    while (n > 1)
+    {
+        std::size_t half = n / 2;
+        base = (base[half] <= val) ? base + half : base;
+        n -= half;
+    }
+    return static_cast<int>(base - m_bins.data());
+}
+//----------------------------------------------------------------------------
 inline int binner::find_bin(const double &val)
 {
-    double lower_bound = m_bins.front();
-    for (unsigned int i = 1; i < m_bins.size(); ++i)
+    int bin = lookup(val);
+    if (bin < 0)
     {
-        if((val >= lower_bound) && (val < m_bins[i]))
-        {
-            return static_cast<int>(i - 1);
-        }
+        throw std::out_of_range("value = " + std::to_string(val) + 
+            " outside of binning range.");
     }
-    throw std::out_of_range("value = " + std::to_string(val) + 
-        " outside of binning range.");
+    return bin;
 }
 //----------------------------------------------------------------------------
 
@@ -0,0 +1,55 @@
+//-----------------------------------------------------------------------------
+//  dataset_cache.hh:
+//  Header for an on-disk cache of extracted datasets, keyed by a hash of
+//  everything that went into extracting them
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef ROOT__dataset_cache_HH
+#define ROOT__dataset_cache_HH
+
+#include "dataframe/dataframe_core.hh"
+#include <cstdint>
+#include <string>
+
+namespace agile
+{
+namespace root
+{
+
+//----------------------------------------------------------------------------
+//  64 bit FNV-1a hash of s, continuing from h
+//----------------------------------------------------------------------------
+std::uint64_t fnv1a(const std::string &s,
+    std::uint64_t h = 14695981039346656037ULL);
+
+//-----------------------------------------------------------------------------
+//  dataset_cache -- a directory of binary frames, one per description of
+//  how a dataset was made. The file name is the hash of the description,
+//  and the description itself is kept next to it (as <hash>.key) so a
+//  hash collision can't hand back the wrong data.
+//-----------------------------------------------------------------------------
+class dataset_cache
+{
+public:
+    explicit dataset_cache(const std::string &directory = "");
+
+    bool enabled() const { return !m_directory.empty(); }
+
+    // where the frame for description lives (it may not exist yet)
+    std::string path(const std::string &description) const;
+
+    // fills D from the cache, if the description has been stored
+    bool load(const std::string &description, agile::dataframe &D) const;
+
+    // writes D under description, replacing anything there
+    void store(const std::string &description, agile::dataframe &D) const;
+
+private:
+    std::string m_directory;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,69 @@
+//-----------------------------------------------------------------------------
+//  file_index.hh:
+//  Header for a local cache of how many entries each ROOT file holds
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef ROOT__file_index_HH
+#define ROOT__file_index_HH
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace agile
+{
+namespace root
+{
+
+//-----------------------------------------------------------------------------
+//  One file as it was when it was counted. A file whose size or
+//  modification time no longer match gets counted again.
+//-----------------------------------------------------------------------------
+struct file_record
+{
+    file_record()
+    : mtime(0), size(0), entries(0) {}
+
+    long long mtime, size, entries;
+};
+
+//-----------------------------------------------------------------------------
+//  The absolute path of a file (or path itself if it can't be resolved), and
+//  its size and modification time (false for anything that isn't local)
+//-----------------------------------------------------------------------------
+std::string canonical_path(const std::string &path);
+bool stat_file(const std::string &path, file_record &record);
+
+//-----------------------------------------------------------------------------
+//  file_index -- the number of entries in a tree for a list of files,
+//  without opening the ones that have been counted before. With a path, the
+//  index is kept in a plain text file there between jobs.
+//-----------------------------------------------------------------------------
+class file_index
+{
+public:
+    explicit file_index(const std::string &path = "");
+
+    // entries of tree_name in each file (0 if it has no such tree). The
+    // files the index doesn't know are opened on up to n_threads threads
+    // (0 means one per core), and throw on any that can't be opened.
+    std::vector<long long> entries(const std::vector<std::string> &files,
+        const std::string &tree_name, unsigned int n_threads = 1);
+
+    // writes the index back out if anything was counted
+    void save();
+
+private:
+    typedef std::pair<std::string, std::string> key;   // (path, tree)
+
+    std::string m_path;
+    std::map<key, file_record> m_records;
+    bool m_changed;
+};
+
+}
+}
+
+#endif
@@ -51,6 +51,17 @@ public:
         throw std::runtime_error(
             "something weird happened in the numeric_handler.");
     }
+    // where the branch is read into, for copying the raw value out
+    const void* address() const
+    {
+        switch(contains)
+        {
+            case has_double: return &_double;
+            case has_int: return &_int;
+            case has_float: return &_float;
+        }
+        return nullptr;
+    }
 private:    
     double _double = 0;
     int _int = 0;
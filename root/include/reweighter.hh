@@ -0,0 +1,123 @@
+//-----------------------------------------------------------------------------
+//  reweighter.hh:
+//  Header for flattening the kinematics of each class of entry onto those
+//  of a reference class, with histograms over any number of binned columns
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef ROOT__reweighter_HH
+#define ROOT__reweighter_HH
+
+#include "binner.hh"
+#include "selection.hh"
+#include "dataframe/dataframe_core.hh"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace agile
+{
+namespace root
+{
+
+//-----------------------------------------------------------------------------
+//  reweighter -- entries are binned in every dimension at once, and the
+//  entries of class c in a bin get the weight
+//
+//      min(max(n_ref, 1) / ((f_ref / f_c) * max(n_c, 1)), cap)
+//
+//  where n_ref and n_c are the reference class and class c counts in that
+//  bin, and f_ref and f_c their target fractions. The reference class gets
+//  a weight of one, and entries outside the binning or of a class that
+//  wasn't seen in fill() get a weight of zero.
+//
+//  The class either comes straight from one integer column, or is the
+//  index of the first of a set of one-hot columns that's set.
+//-----------------------------------------------------------------------------
+class reweighter
+{
+public:
+    reweighter();
+
+    // bins the column named after b (by its absolute value if b says so)
+    reweighter& add_dimension(binner b);
+
+    reweighter& set_label(const std::string &column);
+    reweighter& set_label(const std::vector<std::string> &one_hot);
+
+    // class the others are weighted to look like (default 0), the fraction
+    // of the total each class should make up (default 1), and the largest
+    // weight handed out (default 20)
+    reweighter& set_reference(int cls);
+    reweighter& set_fraction(int cls, double fraction);
+    reweighter& set_cap(double cap);
+
+    // histograms the entries of D in one pass, on n_threads threads (0
+    // means one per core), and works out the weights from them
+    reweighter& fill(const agile::dataframe &D, unsigned int n_threads = 0);
+
+    // the weight of each entry of D
+    std::vector<double> weights(const agile::dataframe &D,
+        unsigned int n_threads = 0) const;
+
+    // appends weights(D) to D as a column
+    void add_weights(agile::dataframe &D,
+        const std::string &name = "JET_WEIGHT",
+        unsigned int n_threads = 0) const;
+
+    // the weight of one entry, with the columns looked up by name. This
+    // lets a reweighter be handed to tree_reader::get_dataframe().
+    double get_weight(const std::map<std::string, double> &vars) const;
+
+    // counts and weights per class, flattened over the bins (the last
+    // dimension added varies fastest)
+    const std::vector<std::vector<double>>& counts() const
+    {
+        return m_counts;
+    }
+    const std::vector<std::vector<double>>& corrections() const
+    {
+        return m_corrections;
+    }
+
+private:
+    struct dimension
+    {
+        std::string column;
+        bin_table table;
+    };
+
+    // the columns fill() and weights() read: the dimensions, then labels
+    std::vector<std::string> columns() const;
+
+    // flattened bin of the values (in columns() order), or -1 if out of range
+    long bin(const double *values, std::size_t stride) const;
+
+    // class of the values (in columns() order), or -1 if there isn't one
+    int label(const double *values, std::size_t stride) const;
+
+    // calls f(thread, first_row, rows, values) over blocks of D's columns()
+    // on n threads (see agile::row_threads), values holding one block of
+    // each column after another
+    template <class Function>
+    void for_blocks(const agile::dataframe &D, unsigned int n,
+        Function f) const;
+
+    double correction(int cls, long b) const;
+
+    std::vector<dimension> m_dimensions;
+    std::vector<std::string> m_labels;
+    bool m_one_hot;
+
+    int m_reference;
+    std::map<int, double> m_fractions;
+    double m_cap;
+
+    std::size_t m_bins;
+    std::vector<std::vector<double>> m_counts, m_corrections;
+};
+
+}
+}
+
+#endif
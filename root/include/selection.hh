@@ -0,0 +1,89 @@
+//-----------------------------------------------------------------------------
+//  selection.hh:
+//  Header for binnings and cuts compiled into one kernel that selects and
+//  bins a block of entries at a time
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef ROOT__selection_HH
+#define ROOT__selection_HH
+
+#include "binner.hh"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace agile
+{
+namespace root
+{
+
+//-----------------------------------------------------------------------------
+//  bin_table -- a binner compiled for lookups. Evenly spaced edges are found
+//  arithmetically, anything else with a binary search. Like
+//  binner::lookup(), values outside the edges give -1 and the top edge
+//  belongs to the last bin.
+//-----------------------------------------------------------------------------
+class bin_table
+{
+public:
+    bin_table();
+    explicit bin_table(binner b);
+
+    int operator()(double val) const;
+
+    bool contains(double val) const
+    {
+        val = m_abs ? std::fabs(val) : val;
+        return (val >= m_lo) && (val <= m_hi);
+    }
+    std::size_t bins() const { return m_edges.empty() ? 0 : m_edges.size() - 1; }
+    bool uniform() const { return m_uniform; }
+
+private:
+    binner m_binner;
+    std::vector<double> m_edges;
+    double m_lo, m_hi, m_scale;
+    bool m_abs, m_uniform;
+};
+
+//-----------------------------------------------------------------------------
+//  selection -- cuts and binnings on a set of numbered inputs. An entry
+//  passes if every input that's cut on or binned lies within its edges.
+//-----------------------------------------------------------------------------
+class selection
+{
+public:
+    selection& add_cut(std::size_t input, const binner &b);
+
+    // entries outside b fail, and the bin of the rest is written to the
+    // binning's output (outputs are numbered in the order they're added)
+    selection& add_binning(std::size_t input, const binner &b);
+
+    std::size_t inputs() const;
+    std::size_t binnings() const { return m_binnings.size(); }
+    bool empty() const { return m_cuts.empty() && m_binnings.empty(); }
+
+    // evaluates n entries, with inputs[k] pointing at the n values of input
+    // k. Sets mask[i] to 1 if entry i passes and 0 if not, bins[j][i] to its
+    // bin in binning j (-1 if it's outside), and returns how many passed.
+    std::size_t evaluate(const double * const *inputs, std::size_t n,
+        std::uint8_t *mask, std::int32_t * const *bins) const;
+
+    // whether one entry passes, values[k] holding input k
+    bool pass(const double *values) const;
+
+private:
+    struct step
+    {
+        std::size_t input;
+        bin_table table;
+    };
+    std::vector<step> m_cuts, m_binnings;
+};
+
+}
+}
+
+#endif
@@ -29,10 +29,25 @@ class smart_chain: public TChain
 public: 
     using TChain::Add; 
     smart_chain(std::string tree_name); 
+
+    // with nentries > 0 the file is taken to hold that many entries and
+    // isn't opened until it's read; 0 skips it as empty
     virtual int add(std::string file_name, long long nentries = -1); 
     template<typename T, typename Z>
     void set_branch(T name, Z branch); 
     std::vector<std::string> get_all_branch_names() const; 
+
+    // TTreeCache of the given size in bytes (0 switches it off). With
+    // learn_entries at 0 the set branches are registered with the cache up
+    // front and the learning phase is skipped; otherwise the cache learns
+    // which branches are read over the first learn_entries entries.
+    void set_cache(long long bytes, int learn_entries = 0); 
+    long long get_cache_size() const { return m_cache_size; }
+    int get_learn_entries() const { return m_learn_entries; }
+
+    // asynchronous prefetching of the baskets the cache will want next. It
+    // is read by ROOT when a file is opened, so set it before add().
+    static void set_prefetch(bool on); 
 private: 
     typedef std::vector<std::string> Strings; 
     void SetBranchAddressPrivate(std::string name, void* branch);
@@ -43,8 +58,15 @@ private:
     Strings m_set_branches; 
     std::set<std::string> m_set_branch_set; 
     Strings m_files; 
+    long long m_cache_size; 
+    int m_learn_entries; 
 }; 
 
+//----------------------------------------------------------------------------
+//  ROOT has to be told that it's going to be used from several threads
+//----------------------------------------------------------------------------
+void enable_root_threads(); 
+
 //----------------------------------------------------------------------------
 class MissingBranchError: public std::runtime_error 
 {
@@ -8,9 +8,12 @@
 #define ROOT__tree_reader_HH 
 
 #include <cstddef> //std::size_t
+#include <functional>
+#include <ostream>
 #include "smart_chain.hh"
 #include "numeric_handler.hh"
 #include "binner.hh"
+#include "selection.hh"
 #include "dataframe/dataframe_core.hh"
 #include "agile/agile_base.hh"
 #include "yaml-cpp/yaml_core.hh"
@@ -38,6 +41,85 @@ struct var_traits
     numeric_type type;
 };
 
+//-----------------------------------------------------------------------------
+//  A branch resolved once from its name. For the categ_<var> variables made
+//  by a binning, bins points to the binner and the bin index is reported.
+//-----------------------------------------------------------------------------
+struct branch_handle
+{
+    std::size_t pos;
+    numeric_type type;
+    agile::root::binner *bins;
+};
+
+//-----------------------------------------------------------------------------
+//  I/O for one branch over a get_dataframe() with branch stats switched on. 
+//  seconds is the time spent in the branch's GetEntry(): fetching baskets
+//  the cache didn't have, unzipping them and copying the value out. zip_bytes
+//  and tot_bytes are the branch's compressed and uncompressed sizes summed
+//  over the trees that were read.
+//-----------------------------------------------------------------------------
+struct branch_io
+{
+    branch_io(const std::string &name = "")
+    : name(name), bytes_read(0), baskets_read(0), zip_bytes(0), tot_bytes(0),
+      seconds(0.0) {}
+
+    std::string name;
+    long long bytes_read, baskets_read, zip_bytes, tot_bytes;
+    double seconds;
+
+    double compression() const
+    {
+        return (zip_bytes > 0) ? (double) tot_bytes / zip_bytes : 0.0;
+    }
+};
+
+//-----------------------------------------------------------------------------
+//  What the last get_dataframe() did, and how fast. bytes_read counts the
+//  uncompressed bytes GetEntry() returned, file_bytes_read and read_calls 
+//  what actually came off the disk (or network).
+//-----------------------------------------------------------------------------
+struct extraction_report
+{
+    extraction_report()
+    : entries_read(0), entries_kept(0), bytes_read(0), file_bytes_read(0), 
+      read_calls(0), seconds(0.0) {}
+
+    long long entries_read, entries_kept, bytes_read, file_bytes_read, 
+        read_calls;
+    double seconds;
+
+    // filled in when set_branch_stats() is on, in branch order
+    std::vector<branch_io> branches;
+
+    double events_per_second() const
+    {
+        return (seconds > 0.0) ? entries_read / seconds : 0.0;
+    }
+    double megabytes_per_second() const
+    {
+        return (seconds > 0.0) ? bytes_read / (1e6 * seconds) : 0.0;
+    }
+};
+
+inline std::ostream& operator << (std::ostream &os, 
+    const extraction_report &r)
+{
+    os << "read " << r.entries_read << " entries (" << r.entries_kept 
+       << " kept, " << r.bytes_read / 1e6 << " MB) in " << r.seconds 
+       << " s: " << r.events_per_second() << " events/s, " 
+       << r.megabytes_per_second() << " MB/s; " << r.file_bytes_read / 1e6 
+       << " MB from file in " << r.read_calls << " reads";
+    for (auto &b : r.branches)
+    {
+        os << "\n  " << b.name << ": " << b.bytes_read / 1e6 << " MB in " 
+           << b.baskets_read << " baskets, " << b.seconds << " s, "
+           << "compression " << b.compression();
+    }
+    return os;
+}
+
 //-----------------------------------------------------------------------------
 //  Tree reader class
 //-----------------------------------------------------------------------------
@@ -49,8 +131,37 @@ public:
     tree_reader(const std::vector<std::string>& files, 
         std::string tree_name = "");
 
+    // files are only opened (to count their entries) when first needed, 
+    // all together and on set_threads() threads
     void add_file(std::string filename, std::string tree_name = "");
 
+    // keeps the entry count of every file in a local index at path, so jobs
+    // over the same files don't have to open them to start up
+    void set_index(const std::string &path);
+
+    // keeps what get_dataframe() (without weights) extracts in a directory 
+    // of binary frames, keyed by the files (and their modification times), 
+    // branches, binning, constraints and entry range. A later call with the
+    // same inputs loads the frame and doesn't touch ROOT.
+    void set_dataset_cache(const std::string &directory);
+
+    // threads get_dataframe() reads with: 1 (the default) reads on this 
+    // thread, 0 means one per core. With more than one, the entries are 
+    // split into contiguous ranges, each read by its own chain over just 
+    // the files the range covers. Files are counted on as many threads.
+    void set_threads(unsigned int n);
+
+    // I/O tuning, see smart_chain::set_cache() and smart_chain::set_prefetch()
+    // (which needs calling before the files are added). The cache is set up 
+    // on every thread's chain.
+    void set_cache(long long bytes, int learn_entries = 0);
+    static void set_prefetch(bool on);
+
+    // reads each branch on its own in get_dataframe() so its bytes, baskets 
+    // and time can be reported in last_extraction().branches. This costs a 
+    // clock read per branch per entry, so it's off by default.
+    void set_branch_stats(bool on);
+
     void set_branch(std::string branch_name, numeric_type type);
 
     void create_binning(const std::string &branch_name, 
@@ -65,7 +176,11 @@ public:
     void create_constraint(const std::string &branch_name, 
         const std::vector<double> &v, bool absolute = false);
 
-    void set_branches(const std::string &yamlfile);
+    // sets the branches in a YAML config. Given a model formula, only the
+    // branches it reads (plus those needed for binning and constraints) are
+    // set, and everything else in the tree is left switched off.
+    void set_branches(const std::string &yamlfile, 
+        const std::string &formula = "");
 
     bool entry_in_range();
 
@@ -83,6 +198,9 @@ public:
     agile::dataframe get_dataframe(T &weights, int entries = 1000, int start = -1, 
         bool verbose = false);
 
+    // timing and byte counts for the last get_dataframe()
+    const extraction_report& last_extraction() const { return m_report; }
+
     std::map<std::string, std::string> get_var_types();
 
     std::map<std::string, std::vector<double>> get_binning();
@@ -103,6 +221,19 @@ public:
     std::map<std::string, double> operator()(const unsigned int &idx, 
         const std::vector<std::string> &names);
 
+//-----------------------------------------------------------------------------
+//  Handle based access (no name lookups or allocations per entry)
+//-----------------------------------------------------------------------------
+    branch_handle handle(const std::string &name);
+    std::vector<branch_handle> handles(const std::vector<std::string> &names);
+
+    // value in the currently loaded entry (see get_entry())
+    double value(const branch_handle &h);
+
+    // loads entry idx, and writes the handled values to out
+    void operator()(const unsigned int &idx, 
+        const std::vector<branch_handle> &h, double *out);
+
 //-----------------------------------------------------------------------------
 //  Information
 //-----------------------------------------------------------------------------
@@ -111,8 +242,52 @@ public:
     ~tree_reader();
 
 private:
+    // the columns get_dataframe() makes: the branches, then categ_<var>
+    // for each binned variable
+    std::vector<std::string> extracted_names();
+
+    typedef std::function<double(const double*)> weight_function;
+
+    // reads each entry once, copying the branch values straight into typed
+    // column blocks. If weight is set, it's handed the entry's values (in
+    // extracted_names() order) and its result goes into JET_WEIGHT.
+    agile::dataframe extract(int entries, int start, bool verbose, 
+        const weight_function &weight);
+
+    // fills in the defaults (start < 0 is 0, entries < 0 is everything from
+    // start on), and throws if the range runs past the end of the chain
+    void resolve_range(int &entries, int &start);
+
+    // extract(), split over threads when set_threads() asks for it. Every
+    // thread gets its own weight_function from make_weight (if set).
+    agile::dataframe dispatch(int entries, int start, bool verbose, 
+        const std::function<weight_function()> &make_weight);
+
+    // builds m_selection from the binnings and constraints
+    void compile_selection();
+
+    // everything the dataset cache key covers, as text
+    std::string describe_extraction(int entries, int start);
+
+    // counts the entries of the files added since the last call, and adds
+    // them to the chain
+    void resolve_files();
+
+    // a reader with the same branches and binning over the files holding 
+    // entries [first, last), for one extraction thread. offset is set to 
+    // the index of its first entry in this reader.
+    std::unique_ptr<tree_reader> clone_for_thread(long long first, 
+        long long last, long long &offset);
 
     smart_chain *m_smart_chain;
+    std::vector<std::string> m_files;
+    std::vector<long long> m_file_entries;
+    std::size_t m_files_resolved;
+    std::string m_index_path, m_dataset_cache;
+    unsigned int m_threads;
+    long long m_cache_size;
+    int m_learn_entries;
+    bool m_branch_stats;
     unsigned int m_size, m_num_cols;
     bool m_in_memory;
     std::string m_tree_name;
@@ -131,6 +306,14 @@ private:
     std::map<std::string, agile::root::binner> m_constraint_vars;
     std::map<std::string, std::vector<double>> m_constraint_strategy;
 
+    // the binnings and constraints compiled into one kernel, whose inputs
+    // are the storage positions of the binned then constrained branches
+    agile::root::selection m_selection;
+    std::vector<std::size_t> m_selection_inputs;
+    std::vector<double> m_selection_values;
+    bool m_selection_ready;
+
+    extraction_report m_report;
 };
 
 // template function implementation
@@ -141,69 +324,28 @@ template <class T>
 agile::dataframe tree_reader::get_dataframe(T &weights, int entries, int start, 
     bool verbose)
 {
-    if ((entries > (int)m_size) || ((start + entries) > (int)m_size))
-    {
-        throw dimension_error(
-            "tried to access element in TTree beyond range.");
-    }
-
-    if (verbose)
-    {
-        std::cout << "\nPulling agile::dataframe from tree_reader..." << std::endl;
-    }
-    entries = (entries < 0) ? m_size : entries;
-    start = (start < 0) ? 0 : start;
-    auto stop = start + entries;
-
-    int curr_entry = 0;
-    double pct;
-    agile::dataframe D;
-
-    auto all_names = feature_names;
-    auto temp_names = feature_names;
-    if (m_binned_present)
+    // the weights look variables up by name, so give each thread one map 
+    // that's filled in place for every entry rather than built from scratch
+    auto names = extracted_names();
+    return dispatch(entries, start, verbose, [&weights, names]()
     {
-        for (auto &entry : binned_names)
+        auto vars = std::make_shared<std::map<std::string, double>>();
+        auto values = std::make_shared<std::vector<double*>>();
+        for (auto &name : names)
         {
-            all_names.push_back("categ_" + entry);
+            values->push_back(&(*vars)[name]);
         }
-        temp_names = all_names;
-    }
-    all_names.push_back("JET_WEIGHT");
-    D.set_column_names(all_names);
-    for (curr_entry = start; curr_entry < stop; ++curr_entry)
-    {
-        if (verbose)
+        return weight_function([&weights, vars, values](const double *row)
         {
-            pct = (double)(curr_entry - start) / (double)(entries);
-            agile::progress_bar(pct * 100);
-        }
-
-        m_smart_chain->GetEntry(curr_entry);
-
-        if (entry_in_range())
-        {
-            auto tmp_vec = std::move(at((unsigned int)curr_entry));
-
-            auto categ_map = at((unsigned int)curr_entry, temp_names);
-            
-            tmp_vec.push_back(weights.get_weight(categ_map));
-            D.push_back(tmp_vec);
-
-        }
-        
-    }
-    return std::move(D);
+            for (std::size_t i = 0; i < values->size(); ++i)
+            {
+                *(*values)[i] = row[i];
+            }
+            return weights.get_weight(*vars);
+        });
+    });
 }
 
-
-
-
-
-
-
-
-
 } // end ns root
 } // end ns agile
 
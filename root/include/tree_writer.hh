@@ -0,0 +1,29 @@
+//-----------------------------------------------------------------------------
+//  tree_writer.hh:
+//  Header for writing a dataframe out as a flat TTree, such as a friend
+//  tree of scores for the tree the dataframe was read from
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef ROOT__TREE__WRITER__HH
+#define ROOT__TREE__WRITER__HH
+
+#include "dataframe/dataframe_core.hh"
+#include <string>
+
+namespace agile
+{
+namespace root
+{
+//----------------------------------------------------------------------------
+//  one branch per column, keeping its stored type (int8, int16 and int32 go
+//  in as B, S and I leaves, float32 and float64 as F and D). mode is passed
+//  to TFile, so "UPDATE" adds the tree to a file that's already there.
+//----------------------------------------------------------------------------
+void write_tree(const agile::dataframe &D, const std::string &filename,
+    const std::string &tree_name, const std::string &mode = "RECREATE");
+
+} // end ns root
+} // end ns agile
+
+#endif
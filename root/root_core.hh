@@ -2,5 +2,6 @@
 #define ROOT__CORE__HH 
 
 #include "include/tree_reader.hh"
+#include "include/tree_writer.hh"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,106 @@
+//-----------------------------------------------------------------------------
+//  dataset_cache.cxx:
+//  Implementation for the on-disk cache of extracted datasets
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "include/dataset_cache.hh"
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace agile
+{
+namespace root
+{
+
+//----------------------------------------------------------------------------
+std::uint64_t fnv1a(const std::string &s, std::uint64_t h)
+{
+    for (unsigned char c : s)
+    {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+//----------------------------------------------------------------------------
+dataset_cache::dataset_cache(const std::string &directory)
+: m_directory(directory)
+{
+    if (!m_directory.empty() && (mkdir(m_directory.c_str(), 0755) != 0) &&
+        (errno != EEXIST))
+    {
+        throw std::runtime_error("can't create dataset cache " + m_directory);
+    }
+}
+//----------------------------------------------------------------------------
+std::string dataset_cache::path(const std::string &description) const
+{
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx",
+        (unsigned long long) fnv1a(description));
+    return m_directory + "/" + hash + ".adf";
+}
+//----------------------------------------------------------------------------
+bool dataset_cache::load(const std::string &description,
+    agile::dataframe &D) const
+{
+    if (!enabled())
+    {
+        return false;
+    }
+    std::string frame = path(description);
+    std::ifstream key(frame + ".key");
+    if (!key)
+    {
+        return false;
+    }
+    std::stringstream stored;
+    stored << key.rdbuf();
+    if (stored.str() != description)
+    {
+        return false;
+    }
+    D.from_binary(frame);
+    return true;
+}
+//----------------------------------------------------------------------------
+void dataset_cache::store(const std::string &description,
+    agile::dataframe &D) const
+{
+    if (!enabled())
+    {
+        return;
+    }
+    // the frame goes in first and the key last, so a job that's killed
+    // half way never leaves a key pointing at a partial frame
+    std::string frame = path(description);
+    std::string tmp = frame + "." + std::to_string(getpid()) + ".tmp";
+    std::remove((frame + ".key").c_str());
+
+    D.to_binary(tmp);
+    if (std::rename(tmp.c_str(), frame.c_str()) != 0)
+    {
+        throw std::runtime_error("can't write dataset cache " + frame);
+    }
+    {
+        std::ofstream key(tmp);
+        key << description;
+        if (!key)
+        {
+            throw std::runtime_error("can't write dataset cache " + frame);
+        }
+    }
+    if (std::rename(tmp.c_str(), (frame + ".key").c_str()) != 0)
+    {
+        throw std::runtime_error("can't write dataset cache " + frame);
+    }
+}
+
+}
+}
@@ -0,0 +1,188 @@
+//-----------------------------------------------------------------------------
+//  file_index.cxx:
+//  Implementation for a local cache of how many entries each ROOT file holds
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "include/file_index.hh"
+#include "include/smart_chain.hh"
+#include "dataframe/include/parallel.hh"
+#include "TFile.h"
+#include "TTree.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace agile
+{
+namespace root
+{
+
+namespace
+{
+//----------------------------------------------------------------------------
+long long count_entries(const std::string &path, const std::string &tree_name)
+{
+    std::unique_ptr<TFile> file(TFile::Open(path.c_str()));
+    if (!file || !file->IsOpen() || file->IsZombie())
+    {
+        throw std::runtime_error("bad file: " + path);
+    }
+    TTree* tree = static_cast<TTree*>(file->Get(tree_name.c_str()));
+    return tree ? tree->GetEntries() : 0;
+}
+}
+
+//----------------------------------------------------------------------------
+bool stat_file(const std::string &path, file_record &record)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+    {
+        return false;
+    }
+    record.mtime = info.st_mtime;
+    record.size = info.st_size;
+    return true;
+}
+//----------------------------------------------------------------------------
+std::string canonical_path(const std::string &path)
+{
+    char resolved[PATH_MAX];
+    if (realpath(path.c_str(), resolved) == nullptr)
+    {
+        return path;
+    }
+    return std::string(resolved);
+}
+//----------------------------------------------------------------------------
+file_index::file_index(const std::string &path)
+: m_path(path), m_changed(false)
+{
+    if (m_path.empty())
+    {
+        return;
+    }
+    std::ifstream in(m_path);
+    std::string line;
+
+    // entries, mtime, size, tree and path, tab separated
+    while (std::getline(in, line))
+    {
+        if (line.empty() || (line[0] == '#'))
+        {
+            continue;
+        }
+        std::istringstream fields(line);
+        file_record record;
+        std::string tree, file;
+        fields >> record.entries >> record.mtime >> record.size;
+        fields.ignore(1);
+        if (!fields || !std::getline(fields, tree, '\t') ||
+            !std::getline(fields, file))
+        {
+            continue;
+        }
+        m_records[key(file, tree)] = record;
+    }
+}
+//----------------------------------------------------------------------------
+std::vector<long long> file_index::entries(
+    const std::vector<std::string> &files, const std::string &tree_name,
+    unsigned int n_threads)
+{
+    std::vector<long long> counts(files.size(), -1);
+    std::vector<std::string> paths(files.size());
+    std::vector<file_record> found(files.size());
+    std::vector<bool> local(files.size(), false);
+    std::vector<std::size_t> missing;
+
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        paths[i] = canonical_path(files[i]);
+        local[i] = stat_file(paths[i], found[i]);
+        auto known = m_records.find(key(paths[i], tree_name));
+        if (local[i] && (known != m_records.end()) &&
+            (known->second.mtime == found[i].mtime) &&
+            (known->second.size == found[i].size))
+        {
+            counts[i] = known->second.entries;
+        }
+        else
+        {
+            missing.push_back(i);
+        }
+    }
+    if (missing.empty())
+    {
+        return counts;
+    }
+
+    unsigned int n = agile::default_threads(n_threads);
+    n = std::max<std::size_t>(1, std::min<std::size_t>(n, missing.size()));
+    if (n > 1)
+    {
+        enable_root_threads();
+    }
+    std::atomic<std::size_t> next(0);
+    agile::run_parallel(n, [&](unsigned int)
+    {
+        for (std::size_t m = next++; m < missing.size(); m = next++)
+        {
+            std::size_t i = missing[m];
+            counts[i] = count_entries(files[i], tree_name);
+        }
+    });
+
+    for (auto i : missing)
+    {
+        if (local[i])
+        {
+            found[i].entries = counts[i];
+            m_records[key(paths[i], tree_name)] = found[i];
+            m_changed = true;
+        }
+    }
+    return counts;
+}
+//----------------------------------------------------------------------------
+void file_index::save()
+{
+    if (m_path.empty() || !m_changed)
+    {
+        return;
+    }
+    // written to the side and moved into place, so a job reading the index
+    // never sees half of it
+    std::string tmp = m_path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream out(tmp);
+        if (!out)
+        {
+            throw std::runtime_error("can't write file index " + tmp);
+        }
+        out << "# entries\tmtime\tsize\ttree\tpath\n";
+        for (auto &entry : m_records)
+        {
+            const file_record &r = entry.second;
+            out << r.entries << '\t' << r.mtime << '\t' << r.size << '\t'
+                << entry.first.second << '\t' << entry.first.first << '\n';
+        }
+    }
+    if (std::rename(tmp.c_str(), m_path.c_str()) != 0)
+    {
+        throw std::runtime_error("can't write file index " + m_path);
+    }
+    m_changed = false;
+}
+
+}
+}
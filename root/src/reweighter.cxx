@@ -0,0 +1,283 @@
+//-----------------------------------------------------------------------------
+//  reweighter.cxx:
+//  Implementation for flattening the kinematics of each class of entry
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "include/reweighter.hh"
+#include "dataframe/include/parallel.hh"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace agile
+{
+namespace root
+{
+
+namespace
+{
+//----------------------------------------------------------------------------
+// rows copied out of the columns at a time
+const std::size_t block_rows = 4096;
+}
+
+//----------------------------------------------------------------------------
+reweighter::reweighter()
+: m_one_hot(false), m_reference(0), m_cap(20.0), m_bins(1)
+{
+}
+//----------------------------------------------------------------------------
+reweighter& reweighter::add_dimension(binner b)
+{
+    dimension d;
+    d.column = b.get_name();
+    d.table = bin_table(b);
+    if (d.table.bins() == 0)
+    {
+        throw std::invalid_argument("need at least two bin edges to bin \'" +
+            d.column + "\' on.");
+    }
+    m_bins *= d.table.bins();
+    m_dimensions.push_back(d);
+    return *this;
+}
+//----------------------------------------------------------------------------
+reweighter& reweighter::set_label(const std::string &column)
+{
+    m_labels = std::vector<std::string>(1, column);
+    m_one_hot = false;
+    return *this;
+}
+//----------------------------------------------------------------------------
+reweighter& reweighter::set_label(const std::vector<std::string> &one_hot)
+{
+    m_labels = one_hot;
+    m_one_hot = true;
+    return *this;
+}
+//----------------------------------------------------------------------------
+reweighter& reweighter::set_reference(int cls)
+{
+    m_reference = cls;
+    return *this;
+}
+//----------------------------------------------------------------------------
+reweighter& reweighter::set_fraction(int cls, double fraction)
+{
+    m_fractions[cls] = fraction;
+    return *this;
+}
+//----------------------------------------------------------------------------
+reweighter& reweighter::set_cap(double cap)
+{
+    m_cap = cap;
+    return *this;
+}
+//----------------------------------------------------------------------------
+std::vector<std::string> reweighter::columns() const
+{
+    std::vector<std::string> names;
+    for (auto &d : m_dimensions)
+    {
+        names.push_back(d.column);
+    }
+    names.insert(names.end(), m_labels.begin(), m_labels.end());
+    return names;
+}
+//----------------------------------------------------------------------------
+long reweighter::bin(const double *values, std::size_t stride) const
+{
+    long flat = 0;
+    for (std::size_t i = 0; i < m_dimensions.size(); ++i)
+    {
+        const dimension &d = m_dimensions[i];
+        long b = d.table(values[i * stride]);
+        if (b < 0)
+        {
+            return -1;
+        }
+        flat = flat * d.table.bins() + b;
+    }
+    return flat;
+}
+//----------------------------------------------------------------------------
+int reweighter::label(const double *values, std::size_t stride) const
+{
+    values += m_dimensions.size() * stride;
+    if (!m_one_hot)
+    {
+        return (int) values[0];
+    }
+    for (std::size_t i = 0; i < m_labels.size(); ++i)
+    {
+        if ((int) values[i * stride] == 1)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+//----------------------------------------------------------------------------
+template <class Function>
+void reweighter::for_blocks(const agile::dataframe &D, unsigned int n,
+    Function f) const
+{
+    if (m_labels.empty())
+    {
+        throw std::logic_error("no label set to reweight classes by.");
+    }
+    std::vector<const agile::column*> cols;
+    for (auto &name : columns())
+    {
+        cols.push_back(&D.get_column(name));
+    }
+    const std::size_t rows = D.rows();
+
+    agile::for_row_ranges(rows, n, [&](unsigned int t, std::size_t first,
+        std::size_t last)
+    {
+        std::vector<double> values(cols.size() * block_rows);
+        for (std::size_t row = first; row < last; row += block_rows)
+        {
+            std::size_t len = std::min(block_rows, last - row);
+            for (std::size_t c = 0; c < cols.size(); ++c)
+            {
+                cols[c]->copy_to(&values[c * block_rows], row, len);
+            }
+            f(t, row, len, values.data());
+        }
+    });
+}
+//----------------------------------------------------------------------------
+reweighter& reweighter::fill(const agile::dataframe &D,
+    unsigned int n_threads)
+{
+    // every thread fills its own histograms, which are summed at the end
+    const unsigned int n = agile::row_threads(D.rows(), n_threads);
+    std::vector<std::vector<std::vector<double>>> partial(n);
+    for_blocks(D, n, [&](unsigned int t, std::size_t, std::size_t len,
+        const double *values)
+    {
+        auto &hists = partial[t];
+        for (std::size_t i = 0; i < len; ++i)
+        {
+            long b = bin(values + i, block_rows);
+            int cls = label(values + i, block_rows);
+            if ((b < 0) || (cls < 0))
+            {
+                continue;
+            }
+            if ((std::size_t) cls >= hists.size())
+            {
+                hists.resize(cls + 1, std::vector<double>(m_bins, 0.0));
+            }
+            hists[cls][b] += 1.0;
+        }
+    });
+
+    m_counts.clear();
+    for (auto &hists : partial)
+    {
+        if (hists.size() > m_counts.size())
+        {
+            m_counts.resize(hists.size(), std::vector<double>(m_bins, 0.0));
+        }
+        for (std::size_t cls = 0; cls < hists.size(); ++cls)
+        {
+            for (std::size_t b = 0; b < m_bins; ++b)
+            {
+                m_counts[cls][b] += hists[cls][b];
+            }
+        }
+    }
+    if ((m_reference < 0) || ((std::size_t) m_reference >= m_counts.size()))
+    {
+        throw std::runtime_error("no entries of the reference class found "
+            "to reweight to.");
+    }
+
+    auto fraction = [this](int cls)
+    {
+        auto found = m_fractions.find(cls);
+        return (found == m_fractions.end()) ? 1.0 : found->second;
+    };
+    const auto &reference = m_counts[m_reference];
+    m_corrections.assign(m_counts.size(), std::vector<double>(m_bins, 1.0));
+    for (std::size_t cls = 0; cls < m_counts.size(); ++cls)
+    {
+        if ((int) cls == m_reference)
+        {
+            continue;
+        }
+        double ratio = fraction(m_reference) / fraction(cls);
+        for (std::size_t b = 0; b < m_bins; ++b)
+        {
+            m_corrections[cls][b] = std::min(std::max(reference[b], 1.0) /
+                (ratio * std::max(m_counts[cls][b], 1.0)), m_cap);
+        }
+    }
+    return *this;
+}
+//----------------------------------------------------------------------------
+double reweighter::correction(int cls, long b) const
+{
+    if ((b < 0) || (cls < 0) || ((std::size_t) cls >= m_corrections.size()))
+    {
+        return 0.0;
+    }
+    return m_corrections[cls][b];
+}
+//----------------------------------------------------------------------------
+std::vector<double> reweighter::weights(const agile::dataframe &D,
+    unsigned int n_threads) const
+{
+    if (m_corrections.empty())
+    {
+        throw std::logic_error("reweighter must be filled before weighting.");
+    }
+    std::vector<double> w(D.rows());
+    for_blocks(D, agile::row_threads(D.rows(), n_threads), [&](unsigned int,
+        std::size_t row, std::size_t len, const double *values)
+    {
+        for (std::size_t i = 0; i < len; ++i)
+        {
+            w[row + i] = correction(label(values + i, block_rows),
+                bin(values + i, block_rows));
+        }
+    });
+    return w;
+}
+//----------------------------------------------------------------------------
+void reweighter::add_weights(agile::dataframe &D, const std::string &name,
+    unsigned int n_threads) const
+{
+    auto w = weights(D, n_threads);
+    agile::column C(agile::float64);
+    C.append(w.data(), agile::float64, w.size());
+    D.add_column(name, std::move(C));
+}
+//----------------------------------------------------------------------------
+double reweighter::get_weight(const std::map<std::string, double> &vars) const
+{
+    if (m_corrections.empty())
+    {
+        throw std::logic_error("reweighter must be filled before weighting.");
+    }
+    auto names = columns();
+    std::vector<double> values(names.size());
+    for (std::size_t i = 0; i < names.size(); ++i)
+    {
+        auto found = vars.find(names[i]);
+        if (found == vars.end())
+        {
+            throw std::out_of_range("no key named \'" + names[i] +
+                "\' found in map.");
+        }
+        values[i] = found->second;
+    }
+    return correction(label(values.data(), 1), bin(values.data(), 1));
+}
+
+}
+}
@@ -0,0 +1,134 @@
+#include "include/reweighter.hh"
+#include "dataframe/include/checks.hh"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+using agile::root::binner;
+using agile::root::reweighter;
+using agile::checks::check;
+
+// bins of pt {20, 50, 100, 250} by |eta| {0, 1.2, 2.5}, flattened with eta
+// varying fastest, or -1 outside
+long reference_bin(double pt, double eta)
+{
+    eta = std::fabs(eta);
+    if ((pt < 20) || (pt > 250) || (eta > 2.5))
+    {
+        return -1;
+    }
+    int b_pt = (pt < 50) ? 0 : ((pt < 100) ? 1 : 2);
+    return b_pt * 2 + ((eta < 1.2) ? 0 : 1);
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    // a flavour as one label column and as one-hot columns, with some
+    // entries outside the binning and some with no flavour at all
+    const std::size_t n = 300000;
+    const double fractions[] = {0.54, 0.35, 0.11}, cap = 20;
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    agile::dataframe D;
+    D.set_column_names({"pt", "eta", "flavour", "light", "bottom", "charm"});
+    std::vector<int> flavour(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        double pt = 15 + 250 * uniform(gen), eta = -2.8 + 5.6 * uniform(gen);
+        double r = uniform(gen) + pt / 1000;
+        int f = (r < 0.5) ? 0 : ((r < 0.8) ? 1 : 2);
+        f = (uniform(gen) < 0.01) ? -1 : f;
+        flavour[i] = f;
+        D.push_back(std::vector<double>{pt, eta, double(f), double(f == 0),
+            double(f == 1), double(f == 2)});
+    }
+
+    // the counts and weights by brute force
+    std::vector<std::vector<double>> counts(3, std::vector<double>(6, 0.0));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        long b = reference_bin(D.at(i, "pt"), D.at(i, "eta"));
+        if ((b >= 0) && (flavour[i] >= 0))
+        {
+            counts[flavour[i]][b] += 1;
+        }
+    }
+    auto expected_weight = [&](std::size_t i)
+    {
+        long b = reference_bin(D.at(i, "pt"), D.at(i, "eta"));
+        int f = flavour[i];
+        if ((b < 0) || (f < 0))
+        {
+            return 0.0;
+        }
+        if (f == 0)
+        {
+            return 1.0;
+        }
+        return std::min(std::max(counts[0][b], 1.0) / ((fractions[0] / 
+            fractions[f]) * std::max(counts[f][b], 1.0)), cap);
+    };
+
+    for (bool one_hot : {false, true})
+    {
+        for (unsigned int threads : {1u, 4u})
+        {
+            const std::string where = std::string(one_hot ? "one-hot" : 
+                "label column") + ", " + std::to_string(threads) + 
+                " thread(s)";
+            binner eta("eta", {0, 1.2, 2.5});
+            eta.set_abs(true);
+            reweighter R;
+            R.add_dimension(binner("pt", {20, 50, 100, 250}))
+             .add_dimension(eta)
+             .set_cap(cap);
+            if (one_hot)
+            {
+                R.set_label({"light", "bottom", "charm"});
+            }
+            else
+            {
+                R.set_label("flavour");
+            }
+            for (int f = 0; f < 3; ++f)
+            {
+                R.set_fraction(f, fractions[f]);
+            }
+            R.fill(D, threads);
+            check(R.counts() == counts, where + ": counts");
+
+            auto w = R.weights(D, threads);
+            bool same = (w.size() == n), by_name = true;
+            for (std::size_t i = 0; same && (i < n); ++i)
+            {
+                same = std::fabs(w[i] - expected_weight(i)) <= 
+                    1e-12 * expected_weight(i);
+            }
+            check(same, where + ": weights");
+
+            for (std::size_t i = 0; i < 2000; ++i)
+            {
+                if (flavour[i] < 0)
+                {
+                    continue;
+                }
+                std::map<std::string, double> vars;
+                for (auto &name : D.get_column_names())
+                {
+                    vars[name] = D.at(i, name);
+                }
+                by_name = by_name && (R.get_weight(vars) == w[i]);
+            }
+            check(by_name, where + ": get_weight() agrees with weights()");
+
+            agile::dataframe E(D);
+            R.add_weights(E, "w", threads);
+            check((E.columns() == D.columns() + 1) && 
+                (E.at(n - 1, "w") == w[n - 1]), where + ": add_weights()");
+        }
+    }
+
+    return agile::checks::report("reweighter_test");
+}
@@ -0,0 +1,153 @@
+//-----------------------------------------------------------------------------
+//  selection.cxx:
+//  Implementation for binnings and cuts compiled into one kernel
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "include/selection.hh"
+#include <algorithm>
+#include <cmath>
+
+namespace agile
+{
+namespace root
+{
+
+//----------------------------------------------------------------------------
+bin_table::bin_table()
+: m_lo(0.0), m_hi(-1.0), m_scale(0.0), m_abs(false), m_uniform(false)
+{
+}
+//----------------------------------------------------------------------------
+bin_table::bin_table(binner b)
+: m_binner(b), m_edges(b.get_bins()), m_lo(0.0), m_hi(-1.0), m_scale(0.0),
+  m_abs(b.is_absolute()), m_uniform(false)
+{
+    if (m_edges.size() < 2)
+    {
+        return;
+    }
+    m_lo = m_edges.front();
+    m_hi = m_edges.back();
+
+    // evenly spaced to within rounding, the bin is just a multiplication
+    const std::size_t n = m_edges.size() - 1;
+    const double width = (m_hi - m_lo) / n;
+    m_uniform = (width > 0.0);
+    for (std::size_t i = 1; m_uniform && (i <= n); ++i)
+    {
+        double expected = m_lo + i * width;
+        m_uniform = std::fabs(m_edges[i] - expected) <= 1e-9 * width;
+    }
+    m_scale = m_uniform ? 1.0 / width : 0.0;
+}
+//----------------------------------------------------------------------------
+int bin_table::operator()(double val) const
+{
+    if (!m_uniform)
+    {
+        return m_binner.lookup(val);
+    }
+    val = m_abs ? std::fabs(val) : val;
+    if (!((val >= m_lo) && (val <= m_hi)))
+    {
+        return -1;
+    }
+    const int last = static_cast<int>(m_edges.size()) - 2;
+    int bin = std::min(static_cast<int>((val - m_lo) * m_scale), last);
+
+    // the multiplication can land one off right at an edge
+    bin -= (val < m_edges[bin]) ? 1 : 0;
+    bin += ((bin < last) && (val >= m_edges[bin + 1])) ? 1 : 0;
+    return bin;
+}
+
+//----------------------------------------------------------------------------
+selection& selection::add_cut(std::size_t input, const binner &b)
+{
+    step s;
+    s.input = input;
+    s.table = bin_table(b);
+    m_cuts.push_back(s);
+    return *this;
+}
+//----------------------------------------------------------------------------
+selection& selection::add_binning(std::size_t input, const binner &b)
+{
+    step s;
+    s.input = input;
+    s.table = bin_table(b);
+    m_binnings.push_back(s);
+    return *this;
+}
+//----------------------------------------------------------------------------
+std::size_t selection::inputs() const
+{
+    std::size_t n = 0;
+    for (auto &s : m_cuts)
+    {
+        n = std::max(n, s.input + 1);
+    }
+    for (auto &s : m_binnings)
+    {
+        n = std::max(n, s.input + 1);
+    }
+    return n;
+}
+//----------------------------------------------------------------------------
+// Each cut and binning is one loop over the whole block, rather than every
+// step for one entry at a time. The cuts are just comparisons, which the
+// compiler can vectorize; looking up a bin branches (and uneven edges need
+// a binary search), so the binning loops stay scalar.
+std::size_t selection::evaluate(const double * const *inputs, std::size_t n,
+    std::uint8_t *mask, std::int32_t * const *bins) const
+{
+    std::fill(mask, mask + n, 1);
+    for (auto &s : m_cuts)
+    {
+        const double *in = inputs[s.input];
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            mask[i] &= s.table.contains(in[i]);
+        }
+    }
+    for (std::size_t j = 0; j < m_binnings.size(); ++j)
+    {
+        const step &s = m_binnings[j];
+        const double *in = inputs[s.input];
+        std::int32_t *out = bins[j];
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            out[i] = s.table(in[i]);
+            mask[i] &= (out[i] >= 0);
+        }
+    }
+    std::size_t passed = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        passed += mask[i];
+    }
+    return passed;
+}
+//----------------------------------------------------------------------------
+bool selection::pass(const double *values) const
+{
+    for (auto &s : m_cuts)
+    {
+        if (!s.table.contains(values[s.input]))
+        {
+            return false;
+        }
+    }
+    for (auto &s : m_binnings)
+    {
+        if (!s.table.contains(values[s.input]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+}
@@ -0,0 +1,146 @@
+#include "include/selection.hh"
+#include "dataframe/include/checks.hh"
+#include <iostream>
+#include <limits>
+
+using agile::root::binner;
+using agile::root::bin_table;
+using agile::root::selection;
+
+using agile::checks::check;
+
+// the bin by a straight scan: edges[i] <= val < edges[i + 1], with the top
+// edge in the last bin and anything outside -1
+int reference_bin(const std::vector<double> &edges, double val)
+{
+    const int n = edges.size() - 1;
+    for (int i = 0; i < n; ++i)
+    {
+        if ((val >= edges[i]) && (val < edges[i + 1]))
+        {
+            return i;
+        }
+    }
+    return (val == edges.back()) ? n - 1 : -1;
+}
+
+// compares bin_table, binner::lookup() and binner::get_bin() against the
+// scan, on every edge, between the edges, and outside them
+void check_binning(const std::string &name, std::vector<double> edges,
+    bool uniform)
+{
+    binner b(name, edges);
+    bin_table table(b);
+    check(table.uniform() == uniform, name + ": uniform()");
+    check(table.bins() == edges.size() - 1, name + ": bins()");
+
+    std::vector<double> values(edges);
+    for (std::size_t i = 0; i + 1 < edges.size(); ++i)
+    {
+        double width = edges[i + 1] - edges[i];
+        for (int k = 1; k < 10; ++k)
+        {
+            values.push_back(edges[i] + k * width / 10);
+        }
+        values.push_back(std::nextafter(edges[i + 1], edges[i]));
+        values.push_back(std::nextafter(edges[i], edges[i + 1]));
+    }
+    for (double val : values)
+    {
+        int expected = reference_bin(edges, val);
+        std::string where = name + " at " + std::to_string(val);
+        check(table(val) == expected, where + ": bin_table");
+        check(b.lookup(val) == expected, where + ": lookup()");
+        check(b.get_bin(val) == expected, where + ": get_bin()");
+        check(table.contains(val), where + ": contains()");
+    }
+    check(table(edges.back()) == (int) edges.size() - 2,
+        name + ": top edge in the last bin");
+
+    const double outside[] = {edges.front() - 1,
+        std::nextafter(edges.front(), -1e300),
+        std::nextafter(edges.back(), 1e300), edges.back() + 1,
+        std::numeric_limits<double>::quiet_NaN()};
+    for (double val : outside)
+    {
+        std::string where = name + " at " + std::to_string(val);
+        check(table(val) == -1, where + ": bin_table outside");
+        check(b.lookup(val) == -1, where + ": lookup() outside");
+        check(!table.contains(val), where + ": contains() outside");
+        bool threw = false;
+        try
+        {
+            b.get_bin(val);
+        }
+        catch (std::out_of_range &e)
+        {
+            threw = true;
+        }
+        check(threw, where + ": get_bin() throws outside");
+    }
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    check_binning("uniform", {0, 1, 2, 3, 4}, true);
+    check_binning("offset", {-2.5, -1, 0.5, 2, 3.5, 5}, true);
+
+    // tenths don't add up exactly, so the edges land off by one ulp
+    std::vector<double> tenths;
+    for (int i = 0; i <= 10; ++i)
+    {
+        tenths.push_back(i * 0.1);
+    }
+    check_binning("tenths", tenths, true);
+
+    check_binning("pt", {20, 50, 100, 200, 500}, false);
+    check_binning("narrow", {0, 1e-9, 1, 1e9}, false);
+    check_binning("single", {1, 2}, true);
+
+    // absolute values
+    binner eta("eta", {0, 1.2, 2.5});
+    eta.set_abs(true);
+    bin_table abs_table(eta);
+    check(abs_table(-2.0) == 1, "abs: -2 in bin 1");
+    check(abs_table(-0.5) == 0, "abs: -0.5 in bin 0");
+    check(abs_table(-2.5) == 1, "abs: -2.5 on the top edge");
+    check(abs_table(-3.0) == -1, "abs: -3 outside");
+
+    // too few edges bins nothing
+    check(bin_table(binner("empty", {1})).bins() == 0, "one edge: no bins");
+    check(bin_table(binner("empty", {1}))(1) == -1, "one edge: -1");
+
+    // selection: bin input 0, cut on input 2 (input 1 is unused)
+    selection s;
+    s.add_binning(0, binner("x", {0, 1, 2}))
+     .add_cut(2, binner("y", {0, 10}));
+    check(s.inputs() == 3, "selection: inputs()");
+    check(s.binnings() == 1, "selection: binnings()");
+
+    const std::size_t n = 6;
+    double x[n] = {0.5, 1.5, 2.0, 2.5, -0.1, 1.0};
+    double unused[n] = {0, 0, 0, 0, 0, 0};
+    double y[n] = {5, 5, 10, 5, 5, 11};
+    const double *inputs[] = {x, unused, y};
+
+    std::uint8_t mask[n];
+    std::int32_t bin[n];
+    std::int32_t *bins[] = {bin};
+    std::size_t passed = s.evaluate(inputs, n, mask, bins);
+
+    const std::uint8_t want_mask[n] = {1, 1, 1, 0, 0, 0};
+    const std::int32_t want_bin[n] = {0, 1, 1, -1, -1, 1};
+    check(passed == 3, "selection: 3 entries pass");
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        std::string where = "selection entry " + std::to_string(i);
+        check(mask[i] == want_mask[i], where + ": mask");
+        check(bin[i] == want_bin[i], where + ": bin");
+
+        double values[] = {x[i], unused[i], y[i]};
+        check(s.pass(values) == (mask[i] == 1), where + ": pass()");
+    }
+
+    return agile::checks::report("selection_test");
+}
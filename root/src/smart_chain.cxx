@@ -9,6 +9,13 @@
 #include "TChain.h"
 #include "TFile.h"
 #include "TError.h"
+#include "TEnv.h"
+#include "RVersion.h"
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+#include "TROOT.h"
+#else
+#include "TThread.h"
+#endif
 #include <sstream>
 #include <iostream>
 
@@ -18,13 +25,22 @@ namespace root
 {
 //----------------------------------------------------------------------------
 smart_chain::smart_chain(std::string tree_name)
-: TChain(tree_name.c_str()), m_tree_name(tree_name)
+: TChain(tree_name.c_str()), m_tree_name(tree_name), m_cache_size(0), 
+m_learn_entries(0)
 { 
 }
 //----------------------------------------------------------------------------
 int smart_chain::add(std::string file_name, long long nentries) 
 { 
     m_files.push_back(file_name); 
+    if (nentries == 0) 
+    { 
+        return 0; 
+    }
+    if (nentries > 0) 
+    { 
+        return TChain::Add(file_name.c_str(), nentries); 
+    }
     TFile file(file_name.c_str()); 
     if (!file.IsOpen() || file.IsZombie()) 
     { 
@@ -43,6 +59,32 @@ const {
     return m_set_branches; 
 }
 //----------------------------------------------------------------------------
+void smart_chain::set_cache(long long bytes, int learn_entries) 
+{ 
+    m_cache_size = (bytes < 0) ? 0 : bytes; 
+    m_learn_entries = (learn_entries < 0) ? 0 : learn_entries; 
+    SetCacheSize(m_cache_size); 
+    if (m_cache_size == 0) 
+    { 
+        return; 
+    }
+    if (m_learn_entries > 0) 
+    { 
+        SetCacheLearnEntries(m_learn_entries); 
+        return; 
+    }
+    for (auto &name : m_set_branches) 
+    { 
+        AddBranchToCache(name.c_str(), true); 
+    }
+    StopCacheLearningPhase(); 
+}
+//----------------------------------------------------------------------------
+void smart_chain::set_prefetch(bool on) 
+{ 
+    gEnv->SetValue("TFile.AsyncPrefetching", on ? 1 : 0); 
+}
+//----------------------------------------------------------------------------
 void smart_chain::SetBranchAddressPrivate(std::string name, void* branch) 
 { 
     check_for_dup(name); 
@@ -68,6 +110,10 @@ void smart_chain::SetBranchAddressPrivate(std::string name, void* branch)
     { 
         throw_bad_branch(name); 
     }
+    if ((m_cache_size > 0) && (m_learn_entries == 0)) 
+    { 
+        AddBranchToCache(name.c_str(), true); 
+    }
 
 }
 //----------------------------------------------------------------------------
@@ -104,6 +150,15 @@ const {
     }
 }
 //----------------------------------------------------------------------------
+void enable_root_threads()
+{
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+    ROOT::EnableThreadSafety();
+#else
+    TThread::Initialize();
+#endif
+}
+//----------------------------------------------------------------------------
 MissingBranchError::MissingBranchError(const std::string& what_arg)
 : std::runtime_error(what_arg)
 {
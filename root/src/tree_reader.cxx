@@ -4,6 +4,17 @@
 //  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
 //-----------------------------------------------------------------------------
 #include "include/tree_reader.hh"
+#include "dataframe/include/parallel.hh"
+#include "include/file_index.hh"
+#include "include/dataset_cache.hh"
+#include "TBranch.h"
+#include "TFile.h"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <sstream>
+#include <tuple>
 
 namespace agile
 {
@@ -12,7 +23,10 @@ namespace root
 
 //----------------------------------------------------------------------------
 tree_reader::tree_reader(std::string filename, std::string tree_name)
-: m_smart_chain(0), m_size(0), m_tree_name(tree_name), m_binned_present(false)
+: m_smart_chain(0), m_files_resolved(0), m_threads(1), m_cache_size(0), 
+m_learn_entries(0), m_branch_stats(false), m_size(0), m_tree_name(tree_name), 
+m_binned_present(false),
+m_constraint_present(false), m_selection_ready(false)
 {
     if(tree_name != "")
     {
@@ -20,8 +34,7 @@ tree_reader::tree_reader(std::string filename, std::string tree_name)
         m_smart_chain = new smart_chain(tree_name);
         if (filename != "")
         {
-            m_smart_chain->add(filename);
-            m_size = m_smart_chain->GetEntries();
+            m_files.push_back(filename);
         }
     }
     else if (filename != "")
@@ -33,7 +46,10 @@ tree_reader::tree_reader(std::string filename, std::string tree_name)
 //----------------------------------------------------------------------------
 tree_reader::tree_reader(const std::vector<std::string>& files, 
     std::string tree_name)
-: m_smart_chain(0), m_size(0), m_tree_name(tree_name), m_binned_present(false)
+: m_smart_chain(0), m_files_resolved(0), m_threads(1), m_cache_size(0), 
+m_learn_entries(0), m_branch_stats(false), m_size(0), m_tree_name(tree_name), 
+m_binned_present(false),
+m_constraint_present(false), m_selection_ready(false)
 {
     if (tree_name == "")
     {
@@ -41,11 +57,7 @@ tree_reader::tree_reader(const std::vector<std::string>& files,
             tree name to load files.");
     }
     m_smart_chain = new smart_chain(tree_name);
-    for (auto &file : files)
-    {
-        m_smart_chain->add(file);
-    }
-    m_size = m_smart_chain->GetEntries();
+    m_files = files;
 }
 //----------------------------------------------------------------------------
 tree_reader::~tree_reader()
@@ -58,9 +70,69 @@ void tree_reader::add_file(std::string filename, std::string tree_name)
     if (!m_smart_chain)
     {
         m_smart_chain = new smart_chain(tree_name);
+        m_tree_name = tree_name;
+    }
+    m_files.push_back(filename);
+}
+//----------------------------------------------------------------------------
+void tree_reader::set_index(const std::string &path)
+{
+    m_index_path = path;
+}
+//----------------------------------------------------------------------------
+void tree_reader::set_dataset_cache(const std::string &directory)
+{
+    m_dataset_cache = directory;
+}
+//----------------------------------------------------------------------------
+void tree_reader::resolve_files()
+{
+    if (m_files_resolved == m_files.size())
+    {
+        return;
+    }
+    std::vector<std::string> pending(m_files.begin() + m_files_resolved, 
+        m_files.end());
+
+    file_index index(m_index_path);
+    auto counts = index.entries(pending, m_tree_name, m_threads);
+    index.save();
+
+    // with the counts known, the chain doesn't open anything until it reads
+    for (std::size_t i = 0; i < pending.size(); ++i)
+    {
+        m_smart_chain->add(pending[i], counts[i]);
+        m_file_entries.push_back(counts[i]);
+        m_size += counts[i];
+    }
+    m_files_resolved = m_files.size();
+}
+//----------------------------------------------------------------------------
+void tree_reader::set_threads(unsigned int n)
+{
+    m_threads = n;
+}
+//----------------------------------------------------------------------------
+void tree_reader::set_cache(long long bytes, int learn_entries)
+{
+    if (!m_smart_chain)
+    {
+        throw std::runtime_error("no files added to smart_chain.");
     }
-    m_smart_chain->add(filename);
-    m_size = m_smart_chain->GetEntries();
+    resolve_files();
+    m_cache_size = bytes;
+    m_learn_entries = learn_entries;
+    m_smart_chain->set_cache(bytes, learn_entries);
+}
+//----------------------------------------------------------------------------
+void tree_reader::set_prefetch(bool on)
+{
+    smart_chain::set_prefetch(on);
+}
+//----------------------------------------------------------------------------
+void tree_reader::set_branch_stats(bool on)
+{
+    m_branch_stats = on;
 }
 //----------------------------------------------------------------------------
 void tree_reader::set_branch(std::string branch_name, numeric_type type)
@@ -73,6 +145,12 @@ void tree_reader::set_branch(std::string branch_name, numeric_type type)
     {
         throw std::runtime_error("no files added to smart_chain.");
     }
+    resolve_files();
+    if (storage.empty())
+    {
+        // only the branches we ask for get read by GetEntry()
+        m_smart_chain->SetBranchStatus("*", 0);
+    }
     storage.emplace_back(new number_container);
 
     var_traits new_trait(storage.size() - 1, type);
@@ -115,26 +193,43 @@ bool tree_reader::entry_in_range()
     {
         return true;
     }
-    bool ok = true;
+    if (!m_selection_ready)
+    {
+        compile_selection();
+    }
+    for (std::size_t k = 0; k < m_selection_inputs.size(); ++k)
+    {
+        m_selection_values[k] = 
+            storage[m_selection_inputs[k]]->get_value<double>();
+    }
+    return m_selection.pass(m_selection_values.data());
+}
+//----------------------------------------------------------------------------
+void tree_reader::compile_selection()
+{
+    m_selection = selection();
+    m_selection_inputs.clear();
     for (auto &name : binned_names)
     {
-        ok = ok && m_binned_vars[name].in_range(
-            storage.at(traits[name].pos)->get_value<double>());
-        if(!ok) return false;
+        m_selection.add_binning(m_selection_inputs.size(), 
+            m_binned_vars[name]);
+        m_selection_inputs.push_back(traits.at(name).pos);
     }
     for (auto &name : constraint_names)
     {
-        ok = ok && m_constraint_vars[name].in_range(
-            storage.at(traits[name].pos)->get_value<double>());
-        if(!ok) return false;
+        m_selection.add_cut(m_selection_inputs.size(), 
+            m_constraint_vars[name]);
+        m_selection_inputs.push_back(traits.at(name).pos);
     }
-    return ok;
+    m_selection_values.resize(m_selection_inputs.size());
+    m_selection_ready = true;
 }
 //----------------------------------------------------------------------------
 void tree_reader::create_binning(const std::string &branch_name, 
     const std::initializer_list<double> &il, bool absolute)
 {
     binned_names.push_back(branch_name);
+    m_selection_ready = false;
 
     m_binned_vars[branch_name].set_name(branch_name)
                               .set_bins(il)
@@ -157,6 +252,7 @@ void tree_reader::create_binning(const std::string &branch_name,
     const std::vector<double> &v, bool absolute)
 {
     binned_names.push_back(branch_name);
+    m_selection_ready = false;
 
     m_binned_vars[branch_name].set_name(branch_name)
                               .set_bins(v)
@@ -176,6 +272,7 @@ void tree_reader::create_constraint(const std::string &branch_name,
     const std::initializer_list<double> &il, bool absolute)
 {
     constraint_names.push_back(branch_name);
+    m_selection_ready = false;
 
     m_constraint_vars[branch_name].set_name(branch_name)
                               .set_bins(il)
@@ -198,6 +295,7 @@ void tree_reader::create_constraint(const std::string &branch_name,
     const std::vector<double> &v, bool absolute)
 {
     constraint_names.push_back(branch_name);
+    m_selection_ready = false;
 
     m_constraint_vars[branch_name].set_name(branch_name)
                               .set_bins(v)
@@ -212,111 +310,139 @@ void tree_reader::create_constraint(const std::string &branch_name,
     }
     m_constraint_present = true;
 }
+namespace
+{
 //----------------------------------------------------------------------------
-void tree_reader::set_branches(const std::string &yamlfile)
+// reads a map of (possibly abs(...)) variable names to bin edges, like the
+// binning and constraints sections of the branch config
+std::vector<std::tuple<std::string, std::vector<double>, bool>> 
+read_bins(const YAML::Node &node, const std::string &what)
 {
-    YAML::Node tmp = YAML::LoadFile(yamlfile);
+    std::vector<std::tuple<std::string, std::vector<double>, bool>> v;
+    std::map<std::string, std::vector<double>> bins;
     try
     {
-        YAML::Node config = tmp["branches"];
-        std::map<std::string, std::string> vars = 
-        config.as<std::map<std::string, std::string>>();
+        bins = node.as<std::map<std::string, std::vector<double>>>();
+    }
+    catch(YAML::BadConversion &e)
+    {
+        return v;
+    }
+    for (auto &entry : bins)
+    {
+        auto expression(agile::no_spaces(entry.first));
 
-        for (auto &entry : vars)
+        if (expression.find("abs(") == std::string::npos)
         {
-            auto type = entry.second;
-            if (type == "double")
-            {
-                set_branch(entry.first, agile::root::double_precision);
-            }
-            else if (type == "float")
-            {
-                set_branch(entry.first, agile::root::single_precision);
-            }
-            else if (type == "int")
-            {
-                set_branch(entry.first, agile::root::integer);
-            }
-            else
+            v.emplace_back(entry.first, entry.second, false);
+        }
+        else
+        {
+            auto close_paren = expression.find_first_of(")");
+            auto open_paren = expression.find_first_of("(");
+            std::string arg;
+            if (close_paren == std::string::npos)
             {
-                throw std::domain_error(
-                    "type " + type + " for branch " + entry.first + ".");
+                arg = expression.substr(open_paren + 1);
+                throw std::invalid_argument(
+                    "missing close parentheses for " + what + arg);
             }
-        }
+            arg = expression.substr(
+                open_paren + 1, close_paren - open_paren - 1);
+
+            v.emplace_back(arg, entry.second, true);
+        }      
+    }
+    return v;
+}
+}
+//----------------------------------------------------------------------------
+void tree_reader::set_branches(const std::string &yamlfile, 
+    const std::string &formula)
+{
+    YAML::Node tmp = YAML::LoadFile(yamlfile);
+    std::map<std::string, std::string> vars;
+    try
+    {
+        YAML::Node config = tmp["branches"];
+        vars = config.as<std::map<std::string, std::string>>();
     }
     catch(YAML::BadConversion &e)
     {
         throw std::runtime_error(
             "configuration files must have a map entitled 'branches'");
     }
-    try
-    {   
-        YAML::Node binning = tmp["binning"];
-
-        auto bins = binning.as<std::map<std::string, std::vector<double>>>();
+    auto binning = read_bins(tmp["binning"], "argument ");
+    auto constraints = read_bins(tmp["constraints"], "constraint argument ");
 
-        for (auto &entry : bins)
+    // work out which branches are needed at all
+    std::set<std::string> needed;
+    if (formula != "")
+    {
+        std::vector<std::string> available;
+        for (auto &entry : vars)
         {
-            auto expression(agile::no_spaces(entry.first));
-
-            if (expression.find("abs(") == std::string::npos)
-            {
-                create_binning(entry.first, entry.second);
-            }
-            else
+            available.push_back(entry.first);
+        }
+        for (auto &name : agile::formula(formula).columns(available))
+        {
+            if (vars.count(name) == 0)
             {
-                auto close_paren = expression.find_first_of(")");
-                auto open_paren = expression.find_first_of("(");
-                std::string arg;
-                if (close_paren == std::string::npos)
+                // categ_ variables are made from the binning
+                if (name.compare(0, 6, "categ_") == 0)
                 {
-                    arg = expression.substr(open_paren + 1);
-                    throw std::invalid_argument(
-                        "missing close parentheses for argument " + arg);
+                    continue;
                 }
-                arg = expression.substr(
-                    open_paren + 1, close_paren - open_paren - 1);
-
-                create_binning(arg, entry.second, true);
-            }      
+                throw std::runtime_error("formula needs branch " + name + 
+                    ", which isn\'t in " + yamlfile + ".");
+            }
+            needed.insert(name);
+        }
+        for (auto &entry : binning)
+        {
+            needed.insert(std::get<0>(entry));
+        }
+        for (auto &entry : constraints)
+        {
+            needed.insert(std::get<0>(entry));
         }
     }
-    catch(YAML::BadConversion &e){}
-    try
-    {   
-        YAML::Node binning = tmp["constraints"];
-
-        auto bins = binning.as<std::map<std::string, std::vector<double>>>();
 
-        for (auto &entry : bins)
+    for (auto &entry : vars)
+    {
+        if ((formula != "") && (needed.count(entry.first) == 0))
         {
-            auto expression(agile::no_spaces(entry.first));
-
-            if (expression.find("abs(") == std::string::npos)
-            {
-                create_constraint(entry.first, entry.second);
-            }
-            else
-            {
-                auto close_paren = expression.find_first_of(")");
-                auto open_paren = expression.find_first_of("(");
-                std::string arg;
-                if (close_paren == std::string::npos)
-                {
-                    arg = expression.substr(open_paren + 1);
-                    throw std::invalid_argument(
-                        "missing close parentheses for constraint argument " + arg);
-                }
-                arg = expression.substr(
-                    open_paren + 1, close_paren - open_paren - 1);
-
-                create_constraint(arg, entry.second, true);
-            }      
+            continue;
+        }
+        auto type = entry.second;
+        if (type == "double")
+        {
+            set_branch(entry.first, agile::root::double_precision);
+        }
+        else if (type == "float")
+        {
+            set_branch(entry.first, agile::root::single_precision);
+        }
+        else if (type == "int")
+        {
+            set_branch(entry.first, agile::root::integer);
+        }
+        else
+        {
+            throw std::domain_error(
+                "type " + type + " for branch " + entry.first + ".");
         }
     }
-    catch(YAML::BadConversion &e){}
-
-    
+    for (auto &entry : binning)
+    {
+        create_binning(std::get<0>(entry), std::get<1>(entry), 
+            std::get<2>(entry));
+    }
+    for (auto &entry : constraints)
+    {
+        create_constraint(std::get<0>(entry), std::get<1>(entry), 
+            std::get<2>(entry));
+    }
 }
 //----------------------------------------------------------------------------
 std::map<std::string, std::string> tree_reader::get_var_types()
@@ -345,50 +471,514 @@ std::map<std::string, std::vector<double>> tree_reader::get_constraints()
 agile::dataframe tree_reader::get_dataframe(int entries, int start, 
     bool verbose)
 {
-    if ((entries > (int)m_size) || ((start + entries) > (int)m_size))
+    dataset_cache cache(m_dataset_cache);
+    if (!cache.enabled())
     {
-        throw dimension_error(
-            "tried to access element in TTree beyond range.");
+        return dispatch(entries, start, verbose, nullptr);
     }
+    resolve_files();
+    resolve_range(entries, start);
+
+    agile::dataframe D;
+    std::string description = describe_extraction(entries, start);
+    if (cache.load(description, D))
+    {
+        if (verbose)
+        {
+            std::cout << "\nLoaded agile::dataframe from " 
+                      << cache.path(description) << std::endl;
+        }
+        return D;
+    }
+    D = dispatch(entries, start, verbose, nullptr);
+    cache.store(description, D);
+    return D;
+}
+//----------------------------------------------------------------------------
+std::string tree_reader::describe_extraction(int entries, int start)
+{
+    std::ostringstream ss;
+    ss.precision(17);
+    ss << "agile::root::tree_reader dataset 1\ntree " << m_tree_name << "\n";
+    for (auto &file : m_files)
+    {
+        file_record record;
+        std::string path = canonical_path(file);
+        stat_file(path, record);
+        ss << "file " << path << " " << record.mtime << " " << record.size 
+           << "\n";
+    }
+    for (auto &name : feature_names)
+    {
+        ss << "branch " << name << " " << variable_type_map[name] << "\n";
+    }
+    for (auto &name : binned_names)
+    {
+        auto &bins = m_binned_vars[name];
+        ss << "binning " << name << " " << bins.is_absolute();
+        for (auto edge : bins.get_bins())
+        {
+            ss << " " << edge;
+        }
+        ss << "\n";
+    }
+    for (auto &name : constraint_names)
+    {
+        auto &bins = m_constraint_vars[name];
+        ss << "constraint " << name << " " << bins.is_absolute();
+        for (auto edge : bins.get_bins())
+        {
+            ss << " " << edge;
+        }
+        ss << "\n";
+    }
+    ss << "entries " << start << " " << entries << "\n";
+    return ss.str();
+}
+//----------------------------------------------------------------------------
+std::vector<std::string> tree_reader::extracted_names()
+{
+    auto names = feature_names;
+    if (m_binned_present)
+    {
+        for (auto &entry : binned_names)
+        {
+            names.push_back("categ_" + entry);
+        }
+    }
+    return names;
+}
+//----------------------------------------------------------------------------
+agile::dataframe tree_reader::extract(int entries, int start, bool verbose, 
+    const weight_function &weight)
+{
+    resolve_range(entries, start);
 
     if (verbose)
     {
-        std::cout << "Pulling agile::dataframe from tree_reader..." << std::endl;
+        std::cout << "\nPulling agile::dataframe from tree_reader..." << std::endl;
     }
-    entries = (entries < 0) ? m_size : entries;
-    start = (start < 0) ? 0 : start;
-    auto stop = start + entries;
+    const int stop = start + entries;
 
-    int curr_entry = 0;
-    double pct;
-    agile::dataframe D;
+    // where each branch's value comes from, resolved once
+    struct slot
+    {
+        const void *address;
+        agile::column_type type;
+        std::size_t size;
+    };
+    std::vector<slot> slots;
+    for (auto &name : feature_names)
+    {
+        auto &trait = traits.at(name);
+        slot s;
+        s.address = storage[trait.pos]->address();
+        switch(trait.type)
+        {
+            case single_precision: s.type = agile::float32; break;
+            case double_precision: s.type = agile::float64; break;
+            case integer: s.type = agile::int32; break;
+        }
+        s.size = agile::type_size(s.type);
+        slots.push_back(s);
+    }
+    if (!m_selection_ready)
+    {
+        compile_selection();
+    }
 
-    auto all_names = feature_names;
-    if (m_binned_present)
+    // values are staged in blocks of rows. Each block goes through the 
+    // selection in one go, and the rows that pass are appended to typed
+    // columns (the branches, then the bin of each binned variable).
+    const std::size_t block_rows = 4096;
+    const std::size_t n_slots = slots.size();
+    const std::size_t n_inputs = m_selection_inputs.size();
+    const std::size_t n_bins = m_selection.binnings();
+
+    std::vector<agile::column> columns;
+    std::vector<std::vector<char>> staged(n_slots);
+    for (std::size_t c = 0; c < n_slots; ++c)
     {
-        for (auto &entry : binned_names)
+        columns.emplace_back(slots[c].type);
+        staged[c].resize(block_rows * slots[c].size);
+    }
+    for (std::size_t j = 0; j < n_bins; ++j)
+    {
+        columns.emplace_back(agile::int32);
+    }
+
+    std::vector<std::vector<double>> inputs(n_inputs, 
+        std::vector<double>(block_rows));
+    std::vector<std::vector<std::int32_t>> bins(n_bins, 
+        std::vector<std::int32_t>(block_rows));
+    std::vector<const double*> input_ptrs;
+    std::vector<std::int32_t*> bin_ptrs;
+    for (auto &v : inputs)
+    {
+        input_ptrs.push_back(v.data());
+    }
+    for (auto &v : bins)
+    {
+        bin_ptrs.push_back(v.data());
+    }
+    std::vector<std::uint8_t> mask(block_rows);
+    std::vector<std::size_t> keep;
+    keep.reserve(block_rows);
+
+    agile::column weight_column;
+    std::vector<double> staged_weights(weight ? block_rows : 0);
+    std::vector<double> row(weight ? n_slots + n_bins : 0);
+
+    auto as_double = [](const char *p, agile::column_type type)
+    {
+        switch(type)
         {
-            all_names.push_back("categ_" + entry);
+            case agile::float32: 
+            {
+                float v;
+                std::memcpy(&v, p, sizeof(v));
+                return (double) v;
+            }
+            case agile::int32: 
+            {
+                std::int32_t v;
+                std::memcpy(&v, p, sizeof(v));
+                return (double) v;
+            }
+            default:
+            {
+                double v;
+                std::memcpy(&v, p, sizeof(v));
+                return v;
+            }
+        }
+    };
+
+    std::size_t in_block = 0;
+    auto flush = [&]()
+    {
+        std::size_t kept = in_block;
+        if (!m_selection.empty())
+        {
+            kept = m_selection.evaluate(input_ptrs.data(), in_block, 
+                mask.data(), bin_ptrs.data());
+        }
+        // squeeze out the rows that failed, in place
+        if (kept < in_block)
+        {
+            keep.clear();
+            for (std::size_t i = 0; i < in_block; ++i)
+            {
+                if (mask[i])
+                {
+                    keep.push_back(i);
+                }
+            }
+            for (std::size_t c = 0; c < n_slots; ++c)
+            {
+                const std::size_t size = slots[c].size;
+                char *data = staged[c].data();
+                for (std::size_t k = 0; k < kept; ++k)
+                {
+                    std::memmove(data + k * size, data + keep[k] * size, size);
+                }
+            }
+            for (auto &b : bins)
+            {
+                for (std::size_t k = 0; k < kept; ++k)
+                {
+                    b[k] = b[keep[k]];
+                }
+            }
+        }
+        for (std::size_t c = 0; c < n_slots; ++c)
+        {
+            columns[c].append(staged[c].data(), slots[c].type, kept);
+        }
+        for (std::size_t j = 0; j < n_bins; ++j)
+        {
+            columns[n_slots + j].append(bins[j].data(), agile::int32, kept);
         }
+        if (weight)
+        {
+            for (std::size_t k = 0; k < kept; ++k)
+            {
+                for (std::size_t c = 0; c < n_slots; ++c)
+                {
+                    row[c] = as_double(&staged[c][k * slots[c].size], 
+                        slots[c].type);
+                }
+                for (std::size_t j = 0; j < n_bins; ++j)
+                {
+                    row[n_slots + j] = bins[j][k];
+                }
+                staged_weights[k] = weight(row.data());
+            }
+            weight_column.append(staged_weights.data(), agile::float64, 
+                kept);
+        }
+        m_report.entries_kept += kept;
+        in_block = 0;
+    };
+
+    m_report = extraction_report();
+    const long long file_bytes = TFile::GetFileBytesRead();
+    const long long read_calls = TFile::GetFileReadCalls();
+    auto began = std::chrono::steady_clock::now();
+
+    // with branch stats on, each branch is read on its own and timed. The
+    // TBranch pointers change whenever the chain moves on to the next tree.
+    std::vector<std::string> stat_names;
+    if (m_branch_stats)
+    {
+        stat_names = m_smart_chain->get_all_branch_names();
     }
-    D.set_column_names(all_names);
-    for (curr_entry = start; curr_entry < stop; ++curr_entry)
+    std::vector<TBranch*> stat_branches(stat_names.size(), nullptr);
+    std::vector<int> last_basket(stat_names.size(), -1);
+    for (auto &name : stat_names)
     {
-        if (verbose)
+        m_report.branches.emplace_back(name);
+    }
+    int tree_number = -1;
+
+    auto read_by_branch = [&](long long entry) -> long long
+    {
+        long long local = m_smart_chain->LoadTree(entry);
+        if (m_smart_chain->GetTreeNumber() != tree_number)
         {
-            pct = (double)(curr_entry - start) / (double)(entries);
+            tree_number = m_smart_chain->GetTreeNumber();
+            TTree *tree = m_smart_chain->GetTree();
+            for (std::size_t b = 0; b < stat_names.size(); ++b)
+            {
+                stat_branches[b] = tree->GetBranch(stat_names[b].c_str());
+                last_basket[b] = -1;
+                m_report.branches[b].zip_bytes += 
+                    stat_branches[b]->GetZipBytes();
+                m_report.branches[b].tot_bytes += 
+                    stat_branches[b]->GetTotBytes();
+            }
+        }
+        long long bytes = 0;
+        for (std::size_t b = 0; b < stat_names.size(); ++b)
+        {
+            branch_io &io = m_report.branches[b];
+            auto t0 = std::chrono::steady_clock::now();
+            int read = stat_branches[b]->GetEntry(local);
+            io.seconds += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - t0).count();
+            io.bytes_read += read;
+            bytes += read;
+            if (stat_branches[b]->GetReadBasket() != last_basket[b])
+            {
+                last_basket[b] = stat_branches[b]->GetReadBasket();
+                ++io.baskets_read;
+            }
+        }
+        return bytes;
+    };
+
+    for (int curr_entry = start; curr_entry < stop; ++curr_entry)
+    {
+        if (verbose && ((curr_entry - start) % 1024 == 0))
+        {
+            double pct = (double)(curr_entry - start) / (double)(entries);
             agile::progress_bar(pct * 100);
         }
 
-        m_smart_chain->GetEntry(curr_entry);
+        m_report.bytes_read += m_branch_stats ? read_by_branch(curr_entry) :
+            m_smart_chain->GetEntry(curr_entry);
+        ++m_report.entries_read;
 
-        if (entry_in_range())
+        for (std::size_t c = 0; c < n_slots; ++c)
         {
-            D.push_back(std::move(at((unsigned int)curr_entry)));
+            std::memcpy(&staged[c][in_block * slots[c].size], 
+                slots[c].address, slots[c].size);
         }
-        
+        for (std::size_t k = 0; k < n_inputs; ++k)
+        {
+            inputs[k][in_block] = 
+                storage[m_selection_inputs[k]]->get_value<double>();
+        }
+        if (++in_block == block_rows)
+        {
+            flush();
+        }
+    }
+    flush();
+
+    m_report.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - began).count();
+    m_report.file_bytes_read = TFile::GetFileBytesRead() - file_bytes;
+    m_report.read_calls = TFile::GetFileReadCalls() - read_calls;
+
+    agile::dataframe D;
+    auto names = extracted_names();
+    for (std::size_t c = 0; c < n_slots + n_bins; ++c)
+    {
+        D.add_column(names[c], std::move(columns[c]));
+    }
+    if (weight)
+    {
+        D.add_column("JET_WEIGHT", std::move(weight_column));
+    }
+    D.narrow();
+
+    if (verbose)
+    {
+        agile::progress_bar(100);
+        std::cout << "\n" << m_report << std::endl;
+    }
+    return D;
+}
+
+//----------------------------------------------------------------------------
+void tree_reader::resolve_range(int &entries, int &start)
+{
+    start = (start < 0) ? 0 : start;
+    if (start > (long long) m_size)
+    {
+        throw dimension_error(
+            "tried to access element in TTree beyond range.");
+    }
+    entries = (entries < 0) ? m_size - start : entries;
+    if ((long long) start + entries > (long long) m_size)
+    {
+        throw dimension_error(
+            "tried to access element in TTree beyond range.");
     }
-    return std::move(D);
+}
+//----------------------------------------------------------------------------
+agile::dataframe tree_reader::dispatch(int entries, int start, bool verbose, 
+    const std::function<weight_function()> &make_weight)
+{
+    resolve_files();
+    resolve_range(entries, start);
+
+    // not worth a chain per thread for a handful of entries
+    const int min_thread_entries = 10000;
+    unsigned int n = agile::default_threads(m_threads);
+    n = std::max(1, std::min<int>(n, entries / min_thread_entries));
+
+    if (n == 1)
+    {
+        return extract(entries, start, verbose, 
+            make_weight ? make_weight() : nullptr);
+    }
+    if (verbose)
+    {
+        std::cout << "\nPulling agile::dataframe from tree_reader on " 
+                  << n << " threads..." << std::endl;
+    }
+    enable_root_threads();
+
+    // set everything up here, so the threads only read
+    std::vector<std::unique_ptr<tree_reader>> readers;
+    std::vector<weight_function> weights;
+    std::vector<int> firsts, lasts;
+    for (unsigned int t = 0; t < n; ++t)
+    {
+        firsts.push_back(start + (long long) entries * t / n);
+        lasts.push_back(start + (long long) entries * (t + 1) / n);
+
+        // each thread's chain only holds the files its range touches
+        long long offset = 0;
+        readers.push_back(clone_for_thread(firsts[t], lasts[t], offset));
+        firsts[t] -= offset;
+        lasts[t] -= offset;
+        weights.push_back(make_weight ? make_weight() : nullptr);
+    }
+
+    // ROOT's file counters are global, so they're taken around all threads
+    const long long file_bytes = TFile::GetFileBytesRead();
+    const long long read_calls = TFile::GetFileReadCalls();
+    auto began = std::chrono::steady_clock::now();
+    std::vector<agile::dataframe> parts(n);
+    agile::run_parallel(n, [&](unsigned int t)
+    {
+        parts[t] = readers[t]->extract(lasts[t] - firsts[t], firsts[t], 
+            false, weights[t]);
+    });
+
+    // the ranges are in entry order, so the result doesn't depend on timing
+    agile::dataframe D = agile::concatenate(parts);
+
+    m_report = extraction_report();
+    m_report.branches = readers.front()->m_report.branches;
+    for (auto &io : m_report.branches)
+    {
+        io = branch_io(io.name);
+    }
+    for (auto &reader : readers)
+    {
+        const extraction_report &part = reader->m_report;
+        m_report.entries_read += part.entries_read;
+        m_report.entries_kept += part.entries_kept;
+        m_report.bytes_read += part.bytes_read;
+        for (std::size_t b = 0; b < part.branches.size(); ++b)
+        {
+            branch_io &io = m_report.branches[b];
+            io.bytes_read += part.branches[b].bytes_read;
+            io.baskets_read += part.branches[b].baskets_read;
+            io.zip_bytes += part.branches[b].zip_bytes;
+            io.tot_bytes += part.branches[b].tot_bytes;
+            io.seconds += part.branches[b].seconds;
+        }
+    }
+    m_report.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - began).count();
+    m_report.file_bytes_read = TFile::GetFileBytesRead() - file_bytes;
+    m_report.read_calls = TFile::GetFileReadCalls() - read_calls;
+    if (verbose)
+    {
+        std::cout << m_report << std::endl;
+    }
+    return D;
+}
+//----------------------------------------------------------------------------
+std::unique_ptr<tree_reader> tree_reader::clone_for_thread(long long first, 
+    long long last, long long &offset)
+{
+    std::unique_ptr<tree_reader> reader(new tree_reader("", m_tree_name));
+    offset = 0;
+    long long file_start = 0;
+    for (std::size_t i = 0; i < m_files.size(); ++i)
+    {
+        long long file_end = file_start + m_file_entries[i];
+        if ((file_end > first) && (file_start < last) && 
+            (m_file_entries[i] > 0))
+        {
+            if (reader->m_files.empty())
+            {
+                offset = file_start;
+            }
+            reader->m_files.push_back(m_files[i]);
+            reader->m_file_entries.push_back(m_file_entries[i]);
+            reader->m_smart_chain->add(m_files[i], m_file_entries[i]);
+            reader->m_size += m_file_entries[i];
+        }
+        file_start = file_end;
+    }
+    reader->m_files_resolved = reader->m_files.size();
+    for (auto &name : feature_names)
+    {
+        reader->set_branch(name, traits.at(name).type);
+    }
+    for (auto &name : binned_names)
+    {
+        auto &bins = m_binned_vars[name];
+        reader->create_binning(name, bins.get_bins(), bins.is_absolute());
+    }
+    for (auto &name : constraint_names)
+    {
+        auto &bins = m_constraint_vars[name];
+        reader->create_constraint(name, bins.get_bins(), bins.is_absolute());
+    }
+    if (m_cache_size > 0)
+    {
+        reader->set_cache(m_cache_size, m_learn_entries);
+    }
+    reader->m_branch_stats = m_branch_stats;
+    return reader;
 }
 
 //-----------------------------------------------------------------------------
@@ -443,6 +1033,7 @@ double tree_reader::operator()(const unsigned int &idx, std::string col_name)
     }
 }
 
+//----------------------------------------------------------------------------
 std::map<std::string, double> tree_reader::operator()(const unsigned int &idx, 
     const std::vector<std::string> &names)
 {
@@ -494,12 +1085,72 @@ std::map<std::string, double> tree_reader::at(const unsigned int &idx,
 
 }
 
+//-----------------------------------------------------------------------------
+//  Handle based access
+//-----------------------------------------------------------------------------
+branch_handle tree_reader::handle(const std::string &name)
+{
+    branch_handle h;
+    h.bins = nullptr;
+    auto found = traits.find(name);
+    if (found == traits.end())
+    {
+        const std::string prefix("categ_");
+        auto binned = (name.compare(0, prefix.size(), prefix) == 0) ? 
+            m_binned_vars.find(name.substr(prefix.size())) : 
+            m_binned_vars.end();
+        if (binned == m_binned_vars.end())
+        {
+            throw std::out_of_range("no variable named \'" + name + 
+                "\' in tree_reader.");
+        }
+        found = traits.find(binned->first);
+        h.bins = &binned->second;
+    }
+    h.pos = found->second.pos;
+    h.type = found->second.type;
+    return h;
+}
+//----------------------------------------------------------------------------
+std::vector<branch_handle> tree_reader::handles(
+    const std::vector<std::string> &names)
+{
+    std::vector<branch_handle> v;
+    v.reserve(names.size());
+    for (auto &name : names)
+    {
+        v.push_back(handle(name));
+    }
+    return v;
+}
+//----------------------------------------------------------------------------
+double tree_reader::value(const branch_handle &h)
+{
+    double val = storage[h.pos]->get_value<double>();
+    if (h.bins)
+    {
+        return (double) h.bins->get_bin(val);
+    }
+    return val;
+}
+//----------------------------------------------------------------------------
+void tree_reader::operator()(const unsigned int &idx, 
+    const std::vector<branch_handle> &h, double *out)
+{
+    m_smart_chain->GetEntry(idx);
+    for (std::size_t i = 0; i < h.size(); ++i)
+    {
+        out[i] = value(h[i]);
+    }
+}
+
 //-----------------------------------------------------------------------------
 //  Information
 //-----------------------------------------------------------------------------
 
 std::size_t tree_reader::size()
 {
+    resolve_files();
     return m_size;
 }
 //----------------------------------------------------------------------------
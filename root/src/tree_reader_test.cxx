@@ -0,0 +1,375 @@
+#include "include/tree_reader.hh"
+#include "include/tree_writer.hh"
+#include "include/file_index.hh"
+#include "dataframe/include/checks.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <dirent.h>
+#include <unistd.h>
+
+using agile::checks::check;
+
+// bin of |eta| in {0, 1.2, 2.5}, as the config below asks for
+int eta_bin(double eta)
+{
+    eta = std::fabs(eta);
+    return (eta < 1.2) ? 0 : 1;
+}
+
+// reads the tree through a branch config with a binning, the way DeepLearn
+// and AGILEScore (with --keep categ_eta) do, and checks the categ_ column
+// comes back with the right bins for the entries the binning keeps
+void check_reader(const std::string &file, const std::string &config,
+    const agile::dataframe &written, unsigned int threads)
+{
+    const std::string where = std::to_string(threads) + " thread(s)";
+
+    agile::root::tree_reader TR;
+    TR.set_threads(threads);
+    TR.add_file(file, "jets");
+    TR.set_branches(config, "~pt+categ_eta");
+    agile::dataframe D = TR.get_dataframe(-1);
+
+    auto names = D.get_column_names();
+    check(std::count(names.begin(), names.end(), "categ_eta") == 1,
+        where + ": categ_eta column made");
+    check(std::count(names.begin(), names.end(), "pt") == 1,
+        where + ": pt column read");
+    if (agile::checks::failures())
+    {
+        return;
+    }
+    std::size_t row = 0;
+    for (std::size_t i = 0; i < written.rows(); ++i)
+    {
+        double eta = written.at(i, "eta");
+        if (std::fabs(eta) > 2.5)
+        {
+            continue;
+        }
+        if (row >= D.rows())
+        {
+            check(false, where + ": entries missing");
+            return;
+        }
+        check(D.at(row, "pt") == written.at(i, "pt"),
+            where + ": pt of entry " + std::to_string(i));
+        check(D.at(row, "categ_eta") == eta_bin(eta),
+            where + ": categ_eta of entry " + std::to_string(i));
+        ++row;
+    }
+    check(row == D.rows(), where + ": entries outside the binning dropped");
+}
+
+//----------------------------------------------------------------------------
+// writes text to filename
+void write_config(const std::string &filename, const std::string &text)
+{
+    std::ofstream out(filename);
+    out << text;
+}
+//----------------------------------------------------------------------------
+// every branch type goes into a column of its own type, with the values
+// unchanged, and the constraint drops (and counts) the entries outside it
+void check_extraction(const std::string &file, const agile::dataframe &written)
+{
+    const std::string config = "tree_reader_test_types.yaml";
+    write_config(config, "branches:\n  pt: double\n  eta: float\n"
+        "  n: int\nconstraints:\n  n: [0, 40]\n");
+
+    agile::root::tree_reader TR;
+    TR.add_file(file, "jets");
+    TR.set_branches(config);
+    agile::dataframe D = TR.get_dataframe(-1);
+    std::remove(config.c_str());
+
+    check(D.get_column(D.get_column_idx("pt")).type() == agile::float64,
+        "double branch read as float64");
+    check(D.get_column(D.get_column_idx("eta")).type() == agile::float32,
+        "float branch read as float32");
+    check(D.get_column(D.get_column_idx("n")).type() == agile::int32,
+        "int branch read as int32");
+
+    std::size_t row = 0;
+    bool same = true;
+    for (std::size_t i = 0; i < written.rows(); ++i)
+    {
+        if (written.at(i, "n") > 40)
+        {
+            continue;
+        }
+        same = same && (row < D.rows()) &&
+            (D.at(row, "pt") == written.at(i, "pt")) &&
+            (D.at(row, "eta") == written.at(i, "eta")) &&
+            (D.at(row, "n") == written.at(i, "n"));
+        ++row;
+    }
+    check(same && (row == D.rows()), "constrained entries read unchanged");
+
+    const auto &report = TR.last_extraction();
+    check(report.entries_read == (long long) written.rows(),
+        "every entry read");
+    check(report.entries_kept == (long long) D.rows(),
+        "kept entries counted");
+}
+
+//----------------------------------------------------------------------------
+// a chain of the same file twice, read on 1 to 4 threads over ranges that
+// cross from one file to the next, gives the same entries in the same order
+void check_threads(const std::string &file, const agile::dataframe &written)
+{
+    const std::string config = "tree_reader_test_threads.yaml";
+    write_config(config, "branches:\n  pt: double\n  n: int\n");
+    const int n = written.rows();
+
+    // (entries, start), where -1 entries is everything from start on
+    const std::pair<int, int> ranges[] = {{-1, -1}, {10000, 20000},
+        {-1, 40000}, {3, n - 1}, {0, 5}};
+    for (unsigned int threads = 1; threads <= 4; ++threads)
+    {
+        agile::root::tree_reader TR;
+        TR.set_threads(threads);
+        TR.add_file(file, "jets");
+        TR.add_file(file, "jets");
+        TR.set_branches(config);
+        check(TR.size() == 2 * written.rows(), "chain of two files has both");
+
+        for (auto &range : ranges)
+        {
+            const std::string where = std::to_string(threads) + 
+                " thread(s), " + std::to_string(range.first) + " from " + 
+                std::to_string(range.second);
+            agile::dataframe D = TR.get_dataframe(range.first, range.second);
+            int first = std::max(range.second, 0);
+            int entries = (range.first < 0) ? 2 * n - first : range.first;
+            check(D.rows() == (std::size_t) entries, where + ": entries");
+
+            bool same = true;
+            for (int i = 0; i < (int) D.rows(); ++i)
+            {
+                same = same && (D.at(i, "pt") == 
+                    written.at((first + i) % n, "pt")) && (D.at(i, "n") == 
+                    written.at((first + i) % n, "n"));
+            }
+            check(same, where + ": values in order");
+        }
+
+        bool threw = false;
+        try
+        {
+            TR.get_dataframe(10, 2 * n - 5);
+        }
+        catch (dimension_error &e)
+        {
+            threw = true;
+        }
+        check(threw, "reading past the end of the chain throws");
+    }
+    std::remove(config.c_str());
+}
+
+//----------------------------------------------------------------------------
+// reading through a TTreeCache with per branch stats, on one and two 
+// threads, gives the same values as a plain read, and reports every branch
+void check_io_stats(const std::string &file, const agile::dataframe &written)
+{
+    const std::string config = "tree_reader_test_io.yaml";
+    write_config(config, "branches:\n  pt: double\n  eta: float\n");
+    for (unsigned int threads = 1; threads <= 2; ++threads)
+    {
+        const std::string where = std::to_string(threads) + " thread(s)";
+        agile::root::tree_reader TR;
+        TR.set_threads(threads);
+        TR.add_file(file, "jets");
+        TR.set_branches(config);
+        TR.set_cache(8 * 1024 * 1024);
+        TR.set_branch_stats(true);
+        agile::dataframe D = TR.get_dataframe(-1);
+
+        bool same = (D.rows() == written.rows());
+        for (std::size_t i = 0; same && (i < D.rows()); ++i)
+        {
+            same = (D.at(i, "pt") == written.at(i, "pt")) &&
+                (D.at(i, "eta") == written.at(i, "eta"));
+        }
+        check(same, where + ": cached read gives the same values");
+
+        const auto &report = TR.last_extraction();
+        check(report.entries_read == (long long) written.rows(),
+            where + ": entries_read");
+        check(report.bytes_read >= (long long) (written.rows() * 12),
+            where + ": bytes_read covers both branches");
+        check(report.branches.size() == 2, where + ": a report per branch");
+        for (auto &b : report.branches)
+        {
+            check((b.bytes_read > 0) && (b.baskets_read > 0) && 
+                (b.tot_bytes > 0), where + ": " + b.name + " stats");
+        }
+    }
+    std::remove(config.c_str());
+}
+
+//----------------------------------------------------------------------------
+// the index counts a file once, and later readers take its word for it
+// (checked by doctoring the count it saved) until the file changes
+void check_index(const std::string &file, const agile::dataframe &written)
+{
+    const std::string path = "tree_reader_test.index";
+    const long long n = written.rows();
+    std::remove(path.c_str());
+    {
+        agile::root::file_index index(path);
+        auto counts = index.entries({file, file}, "jets", 2);
+        check((counts.size() == 2) && (counts[0] == n) && (counts[1] == n),
+            "index counts the entries");
+        check(index.entries({file}, "nothere", 1)[0] == 0,
+            "a missing tree has no entries");
+        index.save();
+    }
+
+    std::ifstream in(path);
+    std::string text((std::istreambuf_iterator<char>(in)),
+        std::istreambuf_iterator<char>());
+    in.close();
+    const std::string count = std::to_string(n) + "\t";
+    const std::size_t at = text.find("\n" + count);
+    check(at != std::string::npos, "index file has the count");
+    if (at == std::string::npos)
+    {
+        return;
+    }
+    text.replace(at + 1, count.size(), "123\t");
+    std::ofstream(path) << text;
+
+    agile::root::tree_reader TR;
+    TR.set_index(path);
+    TR.add_file(file, "jets");
+    check(TR.size() == 123, "tree_reader takes the count from the index");
+
+    // a record whose size doesn't match the file any more is counted again
+    agile::root::file_record record;
+    agile::root::stat_file(agile::root::canonical_path(file), record);
+    text.replace(text.find("\t" + std::to_string(record.size) + "\t"),
+        std::to_string(record.size).size() + 2, "\t1\t");
+    std::ofstream(path) << text;
+    agile::root::file_index stale(path);
+    check(stale.entries({file}, "jets")[0] == n,
+        "a file that changed is counted again");
+
+    std::remove(path.c_str());
+}
+
+//----------------------------------------------------------------------------
+// names of the files in directory ending in suffix
+std::vector<std::string> files_in(const std::string &directory,
+    const std::string &suffix)
+{
+    std::vector<std::string> names;
+    DIR *dir = opendir(directory.c_str());
+    while (dirent *entry = (dir ? readdir(dir) : nullptr))
+    {
+        std::string name(entry->d_name);
+        if ((name.size() > suffix.size()) && (name.compare(name.size() - 
+            suffix.size(), suffix.size(), suffix) == 0))
+        {
+            names.push_back(directory + "/" + name);
+        }
+    }
+    if (dir)
+    {
+        closedir(dir);
+    }
+    return names;
+}
+//----------------------------------------------------------------------------
+// the first read of a range stores it, a second reader with the same setup
+// loads it (checked by doctoring the stored frame), and a different range
+// is read from the tree and stored on its own
+void check_dataset_cache(const std::string &file, 
+    const agile::dataframe &written)
+{
+    const std::string config = "tree_reader_test_cache.yaml",
+                      directory = "tree_reader_test_cache";
+    write_config(config, "branches:\n  pt: double\n");
+    auto read = [&](int entries, int start)
+    {
+        agile::root::tree_reader TR;
+        TR.add_file(file, "jets");
+        TR.set_branches(config);
+        TR.set_dataset_cache(directory);
+        return TR.get_dataframe(entries, start);
+    };
+
+    agile::dataframe first = read(1000, 500);
+    auto frames = files_in(directory, ".adf");
+    check(frames.size() == 1, "first read stores one frame");
+    check((first.rows() == 1000) && (first.at(0, "pt") == 
+        written.at(500, "pt")), "first read comes from the tree");
+    if (frames.size() == 1)
+    {
+        agile::dataframe doctored(first);
+        doctored.set(0, "pt", -1.0);
+        doctored.to_binary(frames[0]);
+        agile::dataframe second = read(1000, 500);
+        check((second.rows() == 1000) && (second.at(0, "pt") == -1.0),
+            "second read loads the stored frame");
+    }
+    agile::dataframe other = read(1000, 501);
+    check(other.at(0, "pt") == written.at(501, "pt"),
+        "another range isn't taken from the cache");
+    check(files_in(directory, ".adf").size() == 2, 
+        "another range is stored on its own");
+
+    for (auto &name : files_in(directory, ".adf"))
+    {
+        std::remove(name.c_str());
+    }
+    for (auto &name : files_in(directory, ".key"))
+    {
+        std::remove(name.c_str());
+    }
+    rmdir(directory.c_str());
+    std::remove(config.c_str());
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    // enough entries that two threads each get a range
+    const std::size_t n = 25000;
+    agile::column pt(agile::float64, n), eta(agile::float32, n),
+        count(agile::int32, n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        pt.data<double>()[i] = 20.0 + i;
+        eta.data<float>()[i] = -3.0f + 6.0f * (i % 997) / 996.0f;
+        count.data<std::int32_t>()[i] = i % 50;
+    }
+    agile::dataframe written;
+    written.add_column("pt", std::move(pt));
+    written.add_column("eta", std::move(eta));
+    written.add_column("n", std::move(count));
+
+    const std::string file = "tree_reader_test.root",
+                      config = "tree_reader_test.yaml";
+    agile::root::write_tree(written, file, "jets");
+    write_config(config, "branches:\n  pt: double\n  eta: float\n"
+        "binning:\n  abs(eta): [0, 1.2, 2.5]\n");
+
+    check_reader(file, config, written, 1);
+    check_reader(file, config, written, 2);
+    check_extraction(file, written);
+    check_threads(file, written);
+    check_io_stats(file, written);
+    check_index(file, written);
+    check_dataset_cache(file, written);
+
+    std::remove(file.c_str());
+    std::remove(config.c_str());
+
+    return agile::checks::report("tree_reader_test");
+}
@@ -0,0 +1,109 @@
+//-----------------------------------------------------------------------------
+//  tree_writer.cxx:
+//  Implementation for writing a dataframe out as a flat TTree
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "include/tree_writer.hh"
+#include "TFile.h"
+#include "TTree.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+namespace agile
+{
+namespace root
+{
+
+namespace
+{
+//----------------------------------------------------------------------------
+// rows converted out of the columns at a time
+const std::size_t block_rows = 4096;
+
+// the branch of one column, whose address is one of these
+union leaf
+{
+    std::int8_t i8;
+    std::int16_t i16;
+    std::int32_t i32;
+    float f32;
+    double f64;
+};
+
+char leaf_code(column_type type)
+{
+    switch(type)
+    {
+        case int8: return 'B';
+        case int16: return 'S';
+        case int32: return 'I';
+        case float32: return 'F';
+        case float64: return 'D';
+        default: throw std::domain_error("column type not recognized.");
+    }
+}
+
+void store(leaf &l, column_type type, double val)
+{
+    switch(type)
+    {
+        case int8: l.i8 = static_cast<std::int8_t>(val); return;
+        case int16: l.i16 = static_cast<std::int16_t>(val); return;
+        case int32: l.i32 = static_cast<std::int32_t>(val); return;
+        case float32: l.f32 = static_cast<float>(val); return;
+        case float64: l.f64 = val; return;
+    }
+}
+}
+
+//----------------------------------------------------------------------------
+void write_tree(const agile::dataframe &D, const std::string &filename,
+    const std::string &tree_name, const std::string &mode)
+{
+    TFile file(filename.c_str(), mode.c_str());
+    if (file.IsZombie() || !file.IsOpen())
+    {
+        throw std::runtime_error("can't open " + filename + " for writing.");
+    }
+    file.cd();
+
+    // the file owns the tree, and deletes it on Close()
+    TTree *tree = new TTree(tree_name.c_str(), tree_name.c_str());
+
+    const std::size_t n_cols = D.columns();
+    const auto names = D.get_column_names();
+    std::vector<leaf> leaves(n_cols);
+    std::vector<column_type> types(n_cols);
+    for (std::size_t c = 0; c < n_cols; ++c)
+    {
+        types[c] = D.get_column_type(c);
+        std::string leaflist = names[c] + "/" + leaf_code(types[c]);
+        tree->Branch(names[c].c_str(), &leaves[c], leaflist.c_str());
+    }
+
+    // converted a block of rows at a time, column by column
+    std::vector<double> block(n_cols * block_rows);
+    for (std::size_t first = 0; first < D.rows(); first += block_rows)
+    {
+        std::size_t n = std::min(block_rows, D.rows() - first);
+        for (std::size_t c = 0; c < n_cols; ++c)
+        {
+            D.get_column(c).copy_to(&block[c * block_rows], first, n);
+        }
+        for (std::size_t r = 0; r < n; ++r)
+        {
+            for (std::size_t c = 0; c < n_cols; ++c)
+            {
+                store(leaves[c], types[c], block[c * block_rows + r]);
+            }
+            tree->Fill();
+        }
+    }
+    tree->Write();
+    file.Close();
+}
+
+} // end ns root
+} // end ns agile
@@ -0,0 +1,234 @@
+//-----------------------------------------------------------------------------
+//  code_generator.cxx:
+//  Implementation for turning a trained neural_net into a standalone header
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "code_generator.hh"
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+
+namespace agile
+{
+
+namespace
+{
+//----------------------------------------------------------------------------
+// a string literal holding s
+std::string quote(const std::string &s)
+{
+    std::string q = "\"";
+    for (auto c : s)
+    {
+        if ((c == '\"') || (c == '\\'))
+        {
+            q += '\\';
+        }
+        q += c;
+    }
+    return q + "\"";
+}
+//----------------------------------------------------------------------------
+void write_names(std::ostream &out, const std::string &what,
+    const std::vector<std::string> &names)
+{
+    out << "constexpr const char *" << what << "_names[n_" << what << "s] = {";
+    for (std::size_t i = 0; i < names.size(); ++i)
+    {
+        out << (i ? ", " : "") << quote(names[i]);
+    }
+    out << "};\n";
+}
+//----------------------------------------------------------------------------
+void write_activation(std::ostream &out, const std::string &y,
+    std::size_t n, layer_type type)
+{
+    std::string loop = "    for (std::size_t i = 0; i < " +
+        std::to_string(n) + "; ++i)\n";
+    switch(type)
+    {
+        case linear:
+            return;
+        case rectified:
+            out << loop << "    {\n        " << y << "[i] = (" << y
+                << "[i] > 0.0) ? " << y << "[i] : 0.0;\n    }\n";
+            return;
+        case sigmoid:
+            out << loop << "    {\n        " << y << "[i] = 1.0 / (1.0 + "
+                << "std::exp(-" << y << "[i]));\n    }\n";
+            return;
+        case softmax:
+            out << "    {\n        double top = " << y << "[0], sum = 0.0;\n"
+                << "    " << loop
+                << "        {\n            top = (" << y << "[i] > top) ? "
+                << y << "[i] : top;\n        }\n"
+                << "    " << loop
+                << "        {\n            " << y << "[i] = std::exp(" << y
+                << "[i] - top);\n            sum += " << y << "[i];\n"
+                << "        }\n"
+                << "    " << loop
+                << "        {\n            " << y << "[i] /= sum;\n"
+                << "        }\n    }\n";
+            return;
+        default: throw std::domain_error("layer type not recognized.");
+    }
+}
+}
+
+//----------------------------------------------------------------------------
+code_generator::code_generator(neural_net &net, bool scale)
+: m_plan(net, scale), m_name("agile_net"), m_unroll(4096)
+{
+}
+//----------------------------------------------------------------------------
+code_generator& code_generator::set_name(const std::string &name)
+{
+    bool ok = !name.empty() && !std::isdigit(name[0]);
+    for (auto c : name)
+    {
+        ok &= (std::isalnum(c) || (c == '_'));
+    }
+    if (!ok)
+    {
+        throw std::invalid_argument("\'" + name +
+            "\' isn't a valid C++ namespace name.");
+    }
+    m_name = name;
+    return *this;
+}
+//----------------------------------------------------------------------------
+code_generator& code_generator::set_unroll(std::size_t max_weights)
+{
+    m_unroll = max_weights;
+    return *this;
+}
+//----------------------------------------------------------------------------
+void code_generator::write(std::ostream &out) const
+{
+    const inference_plan &p = m_plan;
+    std::string guard = m_name;
+    for (auto &c : guard)
+    {
+        c = std::toupper(c);
+    }
+    out << std::setprecision(17);
+
+    out << "//" << std::string(77, '-') << "\n"
+        << "//  " << m_name << ".hh:\n"
+        << "//  Generated by the AGILEPack code generator -- do not edit.\n"
+        << "//  predict() takes the inputs in input_names order and gives "
+        << "the\n//  outputs in output_names order.\n"
+        << "//" << std::string(77, '-') << "\n\n"
+        << "#ifndef " << guard << "__GENERATED__HH\n"
+        << "#define " << guard << "__GENERATED__HH\n\n"
+        << "#include <cmath>\n#include <cstddef>\n\n"
+        << "namespace " << m_name << "\n{\n\n"
+        << "constexpr std::size_t n_inputs = " << p.m_inputs.size() << ";\n"
+        << "constexpr std::size_t n_outputs = " << p.m_length.back()
+        << ";\n\n";
+    write_names(out, "input", p.m_inputs);
+    std::vector<std::string> outputs = p.m_outputs;
+    outputs.resize(p.m_length.back());
+    write_names(out, "output", outputs);
+
+    // the weights of every layer that isn't unrolled
+    out << "\nnamespace detail\n{\n";
+    for (std::size_t l = 0; l < p.m_stages.size(); ++l)
+    {
+        const agile::matrix &W = p.m_stages[l].W;
+        const agile::vector &b = p.m_stages[l].b;
+        if ((std::size_t) W.size() <= m_unroll)
+        {
+            continue;
+        }
+        out << "constexpr double W" << l << "[" << W.rows() << "]["
+            << W.cols() << "] = {\n";
+        for (int i = 0; i < W.rows(); ++i)
+        {
+            out << "    {";
+            for (int j = 0; j < W.cols(); ++j)
+            {
+                out << (j ? ", " : "") << W(i, j);
+            }
+            out << "},\n";
+        }
+        out << "};\nconstexpr double b" << l << "[" << b.size() << "] = {";
+        for (int i = 0; i < b.size(); ++i)
+        {
+            out << (i ? ", " : "") << b(i);
+        }
+        out << "};\n";
+    }
+    out << "}\n\n";
+
+    out << "inline void predict(const double *in, double *out)\n{\n";
+
+    // network inputs, derived and scaled
+    out << "    double x0[" << p.m_length[0] << "];\n";
+    for (std::size_t i = 0; i < p.m_slot.size(); ++i)
+    {
+        std::string raw = (p.m_slot[i] < 0) ? p.m_expr[i].to_code("in") :
+            "in[" + std::to_string(p.m_slot[i]) + "]";
+        out << "    x0[" << i << "] = ";
+        if ((p.m_mul(i) == 1.0) && (p.m_add(i) == 0.0))
+        {
+            out << raw << ";\n";
+        }
+        else
+        {
+            out << raw << " * " << p.m_mul(i) << " + " << p.m_add(i)
+                << ";\n";
+        }
+    }
+
+    for (std::size_t l = 0; l < p.m_stages.size(); ++l)
+    {
+        const auto &s = p.m_stages[l];
+        std::string x = "x" + std::to_string(l),
+                    y = "x" + std::to_string(l + 1);
+        out << "\n    // layer " << l << ": " << s.W.cols() << " -> "
+            << s.W.rows() << "\n    double " << y << "[" << s.W.rows()
+            << "];\n";
+        if ((std::size_t) s.W.size() <= m_unroll)
+        {
+            for (int i = 0; i < s.W.rows(); ++i)
+            {
+                out << "    " << y << "[" << i << "] = " << s.b(i);
+                for (int j = 0; j < s.W.cols(); ++j)
+                {
+                    out << "\n        + " << s.W(i, j) << " * " << x << "["
+                        << j << "]";
+                }
+                out << ";\n";
+            }
+        }
+        else
+        {
+            out << "    for (std::size_t i = 0; i < " << s.W.rows()
+                << "; ++i)\n    {\n        double sum = detail::b" << l
+                << "[i];\n        for (std::size_t j = 0; j < " << s.W.cols()
+                << "; ++j)\n        {\n            sum += detail::W" << l
+                << "[i][j] * " << x << "[j];\n        }\n        " << y
+                << "[i] = sum;\n    }\n";
+        }
+        write_activation(out, y, s.W.rows(), s.type);
+    }
+
+    out << "\n    for (std::size_t i = 0; i < n_outputs; ++i)\n    {\n"
+        << "        out[i] = x" << p.m_stages.size() << "[i];\n    }\n}\n\n"
+        << "}\n\n#endif\n";
+}
+//----------------------------------------------------------------------------
+void code_generator::write(const std::string &filename) const
+{
+    std::ofstream file(filename);
+    if (!file.good())
+    {
+        throw std::runtime_error("can't write generated code to " +
+            filename + ".");
+    }
+    write(file);
+}
+
+}
@@ -0,0 +1,135 @@
+// The generated code has to be compiled before it can be run, so this is
+// built twice. Built plainly (code_generator_test), it writes the test
+// network and the code for it next to itself, unrolled, looping and a mix
+// of both. Built with AGILE_GENERATED_CODE and that directory on the
+// include path (code_generator_check), it runs the code against
+// neural_net::predict_map.
+
+#include "include/code_generator.hh"
+#include "include/test_network.hh"
+#include "dataframe/include/checks.hh"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef AGILE_GENERATED_CODE
+#include "unrolled_net.hh"
+#include "looped_net.hh"
+#include "mixed_net.hh"
+#endif
+
+using agile::checks::check;
+
+// the directory the program is in, where the network and code go
+std::string own_directory(const std::string &program)
+{
+    std::size_t slash = program.rfind('/');
+    return (slash == std::string::npos) ? "." : program.substr(0, slash);
+}
+
+#ifndef AGILE_GENERATED_CODE
+//----------------------------------------------------------------------------
+int main(int argc, char const *argv[])
+{
+    const std::string dir = own_directory(argv[0]);
+
+    agile::dataframe D = agile::checks::test_frame(2000);
+    agile::neural_net net;
+    agile::checks::build_test_network(net, D);
+    net.to_yaml(dir + "/code_generator_test.yaml");
+
+    // the layers have 96, 512 and 32 weights
+    const std::pair<std::string, std::size_t> kinds[] = {
+        {"unrolled_net", 4096}, {"looped_net", 0}, {"mixed_net", 100}};
+    for (auto &kind : kinds)
+    {
+        agile::code_generator gen(net);
+        gen.set_name(kind.first).set_unroll(kind.second);
+        check(gen.unroll() == kind.second, kind.first + ": unroll()");
+
+        std::string file = dir + "/" + kind.first + ".hh";
+        gen.write(file);
+        std::stringstream written, expected;
+        written << std::ifstream(file).rdbuf();
+        gen.write(expected);
+        check(written.str() == expected.str(), kind.first +
+            ": the file and the stream get the same code");
+        check(written.str().find("namespace " + kind.first) !=
+            std::string::npos, kind.first + ": namespace");
+    }
+
+    bool threw = false;
+    try
+    {
+        agile::code_generator(net).set_name("not a name");
+    }
+    catch (std::invalid_argument &e)
+    {
+        threw = true;
+    }
+    check(threw, "set_name() refuses a bad namespace");
+
+    return agile::checks::report("code_generator_test");
+}
+#else
+//----------------------------------------------------------------------------
+// largest difference between the outputs of predict and predict_map() over
+// the rows of D
+template <typename Predict>
+double deviation(agile::neural_net &net, const agile::dataframe &D,
+    Predict predict)
+{
+    auto inputs = net.get_base_inputs(), outputs = net.get_outputs();
+    std::vector<double> in(inputs.size()), out(outputs.size());
+    double largest = 0.0;
+    for (std::size_t r = 0; r < D.rows(); ++r)
+    {
+        for (std::size_t i = 0; i < inputs.size(); ++i)
+        {
+            in[i] = D.at(r, inputs[i]);
+        }
+        predict(in.data(), out.data());
+        auto expected = net.predict_map(agile::checks::test_inputs(D, r));
+        for (std::size_t o = 0; o < outputs.size(); ++o)
+        {
+            double diff = std::fabs(out[o] - expected[outputs[o]]);
+            largest = std::isnan(diff) ? HUGE_VAL : std::max(largest, diff);
+        }
+    }
+    return largest;
+}
+//----------------------------------------------------------------------------
+int main(int argc, char const *argv[])
+{
+    agile::neural_net net;
+    net.from_file(own_directory(argv[0]) + "/code_generator_test.yaml");
+    agile::dataframe D = agile::checks::test_frame(2000, 5);
+
+    check(net.get_base_inputs().size() == unrolled_net::n_inputs,
+        "n_inputs");
+    check(net.get_outputs().size() == unrolled_net::n_outputs, "n_outputs");
+    for (std::size_t i = 0; i < unrolled_net::n_inputs; ++i)
+    {
+        check(net.get_base_inputs()[i] == unrolled_net::input_names[i],
+            "input_names");
+    }
+    for (std::size_t o = 0; o < unrolled_net::n_outputs; ++o)
+    {
+        check(net.get_outputs()[o] == unrolled_net::output_names[o],
+            "output_names");
+    }
+
+    double unrolled = deviation(net, D, unrolled_net::predict),
+           looped = deviation(net, D, looped_net::predict),
+           mixed = deviation(net, D, mixed_net::predict);
+    check(unrolled <= 1e-9, "unrolled code matches predict_map(), off by " +
+        std::to_string(unrolled));
+    check(looped <= 1e-9, "looping code matches predict_map(), off by " +
+        std::to_string(looped));
+    check(mixed <= 1e-9, "mixed code matches predict_map(), off by " +
+        std::to_string(mixed));
+
+    return agile::checks::report("code_generator_check");
+}
+#endif
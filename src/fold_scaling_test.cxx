@@ -0,0 +1,105 @@
+#include "include/neural_net.hh"
+#include "include/inference_plan.hh"
+#include "include/test_network.hh"
+#include "dataframe/include/checks.hh"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+using agile::checks::check;
+
+typedef std::vector<std::map<std::string, double>> predictions;
+
+// predict_map() of net on every row of D
+predictions predict_all(agile::neural_net &net, const agile::dataframe &D)
+{
+    predictions all;
+    for (std::size_t r = 0; r < D.rows(); ++r)
+    {
+        all.push_back(net.predict_map(agile::checks::test_inputs(D, r)));
+    }
+    return all;
+}
+//----------------------------------------------------------------------------
+// largest difference between two sets of predictions
+double deviation(const predictions &a, const predictions &b)
+{
+    double largest = 0.0;
+    for (std::size_t r = 0; r < a.size(); ++r)
+    {
+        for (auto &entry : a[r])
+        {
+            largest = std::max(largest,
+                std::fabs(entry.second - b[r].at(entry.first)));
+        }
+    }
+    return largest;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    agile::dataframe D = agile::checks::test_frame(2000, 1),
+                     held_out = agile::checks::test_frame(2000, 4);
+    agile::neural_net net;
+    agile::checks::build_test_network(net, D);
+    check(!net.scaling_folded(), "not folded to begin with");
+
+    predictions before = predict_all(net, held_out);
+
+    // a tolerance nothing meets leaves the network alone
+    bool threw = false;
+    try
+    {
+        net.fold_scaling(-1.0);
+    }
+    catch (std::runtime_error &e)
+    {
+        threw = true;
+    }
+    check(threw, "fold_scaling() throws past the tolerance");
+    check(!net.scaling_folded(), "not folded after throwing");
+    check(deviation(before, predict_all(net, held_out)) == 0.0,
+        "weights put back after throwing");
+
+    double folded_by = net.fold_scaling(1e-9);
+    check(net.scaling_folded(), "folded");
+    check(folded_by <= 1e-9, "fold_scaling() returns its deviation");
+    check(net.fold_scaling() == 0.0, "folding twice does nothing");
+
+    predictions after = predict_all(net, held_out);
+    double moved = deviation(before, after);
+    check(moved < 1e-9, "folded predict_map() matches the original, off by "
+        + std::to_string(moved));
+
+    // a plan of the folded network skips the scaling
+    agile::inference_plan plan(net);
+    std::vector<double> in(plan.inputs().size()), out(plan.outputs().size());
+    double plan_moved = 0.0;
+    for (std::size_t r = 0; r < held_out.rows(); ++r)
+    {
+        for (std::size_t i = 0; i < in.size(); ++i)
+        {
+            in[i] = held_out.at(r, plan.inputs()[i]);
+        }
+        plan.predict(in.data(), out.data());
+        for (std::size_t o = 0; o < out.size(); ++o)
+        {
+            plan_moved = std::max(plan_moved,
+                std::fabs(out[o] - before[r].at(plan.outputs()[o])));
+        }
+    }
+    check(plan_moved < 1e-9, "folded plan matches the original");
+
+    // the fold survives saving, and isn't applied twice on loading
+    const std::string file = "fold_scaling_test.yaml";
+    net.to_yaml(file);
+    agile::neural_net loaded;
+    loaded.from_yaml(file);
+    std::remove(file.c_str());
+    check(loaded.scaling_folded(), "folded after a YAML round trip");
+    check(deviation(after, predict_all(loaded, held_out)) < 1e-12,
+        "YAML round trip predicts the same");
+
+    return agile::checks::report("fold_scaling_test");
+}
@@ -0,0 +1,193 @@
+//-----------------------------------------------------------------------------
+//  inference_plan.cxx:
+//  Implementation for a trained neural_net compiled down to flat arrays
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "inference_plan.hh"
+#include <cstdint>
+
+namespace agile
+{
+
+namespace
+{
+//----------------------------------------------------------------------------
+// doubles in a cache line
+const std::size_t line = 64 / sizeof(double);
+
+typedef Eigen::Map<agile::vector, Eigen::Aligned> buffer;
+
+//----------------------------------------------------------------------------
+// the first cache line boundary at or after p
+double* line_start(double *p)
+{
+    std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(p);
+    std::uintptr_t bytes = line * sizeof(double);
+    return reinterpret_cast<double*>((addr + bytes - 1) / bytes * bytes);
+}
+//----------------------------------------------------------------------------
+// the activations again, in place so that nothing is allocated
+void activate(buffer v, layer_type type)
+{
+    switch(type)
+    {
+        case linear:
+            return;
+        case rectified:
+            v = v.cwiseMax(0.0);
+            return;
+        case sigmoid:
+            v = (1.0 + (-v.array()).exp()).inverse().matrix();
+            return;
+        case softmax:
+            v = (v.array() - v.maxCoeff()).exp().matrix();
+            v /= v.sum();
+            return;
+        default: throw std::domain_error("layer type not recognized.");
+    }
+}
+}
+
+//----------------------------------------------------------------------------
+inference_plan::inference_plan()
+: m_workspace_size(0)
+{
+}
+//----------------------------------------------------------------------------
+inference_plan::inference_plan(neural_net &net, bool scale)
+: m_workspace_size(0)
+{
+    compile(net, scale);
+}
+//----------------------------------------------------------------------------
+void inference_plan::compile(neural_net &net, bool scale)
+{
+    if (net.n_layers == 0)
+    {
+        throw std::logic_error("can't compile an empty network.");
+    }
+    net.prepare_inputs();
+    m_inputs = net.m_base_inputs;
+    m_outputs = net.target_order;
+    m_slot = net.m_input_base;
+    m_expr = net.m_input_expr;
+
+    const long n_in = net.predictor_order.size();
+    m_mul = agile::vector::Ones(n_in);
+    m_add = agile::vector::Zero(n_in);
+
+    // a folded network takes the raw inputs
+    if (scale && !net.m_scaling_folded)
+    {
+        if (net.m_input_shift.size() != n_in)
+        {
+            throw std::out_of_range("no scaling loaded for the inputs.");
+        }
+        m_mul = net.m_input_scale.cwiseInverse();
+        m_add = -net.m_input_shift.cwiseProduct(m_mul);
+    }
+
+    m_stages.clear();
+    m_length.assign(1, n_in);
+    for (unsigned int i = 0; i < net.n_layers; ++i)
+    {
+        stage s;
+        s.W = net.stack[i]->get_weights();
+        s.b = net.stack[i]->get_bias();
+        s.type = net.stack[i]->get_layer_type();
+        if (s.W.cols() != (long) m_length.back())
+        {
+            throw std::logic_error("layer " + std::to_string(i) +
+                " doesn't take the outputs of the one below it.");
+        }
+        m_length.push_back(s.W.rows());
+        m_stages.push_back(std::move(s));
+    }
+
+    // every buffer takes up whole cache lines
+    m_offset.clear();
+    m_workspace_size = 0;
+    for (auto length : m_length)
+    {
+        m_offset.push_back(m_workspace_size);
+        m_workspace_size += (length + line - 1) / line * line;
+    }
+    m_own = make_workspace();
+}
+//----------------------------------------------------------------------------
+inference_plan::workspace inference_plan::make_workspace() const
+{
+    workspace w;
+    // one line spare, so the buffers can start on a line boundary
+    w.m_storage.assign(m_workspace_size + line, 0.0);
+    return w;
+}
+//----------------------------------------------------------------------------
+void inference_plan::predict(const double *in, double *out, 
+    workspace &w) const
+{
+    if (m_stages.empty())
+    {
+        throw std::logic_error("inference_plan used before compile().");
+    }
+    if (w.m_storage.size() != m_workspace_size + line)
+    {
+        throw std::invalid_argument("workspace wasn't made by this plan.");
+    }
+    double *base = line_start(w.m_storage.data());
+    load_inputs(in, base + m_offset[0]);
+
+    for (unsigned int i = 0; i < m_stages.size(); ++i)
+    {
+        const stage &s = m_stages[i];
+        buffer y(base + m_offset[i + 1], m_length[i + 1]);
+        y.noalias() = s.W * buffer(base + m_offset[i], m_length[i]);
+        y += s.b;
+        activate(y, s.type);
+    }
+    const double *y = base + m_offset.back();
+    std::copy(y, y + m_length.back(), out);
+}
+//----------------------------------------------------------------------------
+void inference_plan::load_inputs(const double *in, double *x) const
+{
+    for (unsigned int i = 0; i < m_slot.size(); ++i)
+    {
+        double raw = (m_slot[i] < 0) ? m_expr[i](in) : in[m_slot[i]];
+        x[i] = raw * m_mul(i) + m_add(i);
+    }
+}
+//----------------------------------------------------------------------------
+void inference_plan::predict(const double *in, double *out)
+{
+    predict(in, out, m_own);
+}
+//----------------------------------------------------------------------------
+std::map<std::string, double> inference_plan::predict(
+    const std::map<std::string, double> &x) const
+{
+    std::vector<double> values(m_inputs.size());
+    for (unsigned int i = 0; i < m_inputs.size(); ++i)
+    {
+        auto found = x.find(m_inputs[i]);
+        if (found == x.end())
+        {
+            throw std::out_of_range("no key named \'" + m_inputs[i] +
+                "\' found in map.");
+        }
+        values[i] = found->second;
+    }
+    std::vector<double> y(m_length.empty() ? 0 : m_length.back());
+    workspace w = make_workspace();
+    predict(values.data(), y.data(), w);
+
+    std::map<std::string, double> prediction;
+    for (unsigned int i = 0; i < m_outputs.size(); ++i)
+    {
+        prediction[m_outputs[i]] = y[i];
+    }
+    return prediction;
+}
+
+}
@@ -0,0 +1,131 @@
+#include "include/inference_plan.hh"
+#include "include/test_network.hh"
+#include "dataframe/include/checks.hh"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+using agile::checks::check;
+
+// counts every allocation, to check predict() doesn't make any
+std::atomic<long> allocations(0);
+
+void* operator new(std::size_t n)
+{
+    ++allocations;
+    if (void *p = std::malloc(n ? n : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+//----------------------------------------------------------------------------
+// one plan shared by several threads, each with its own workspace, gives
+// every thread the answers a single thread gets
+void check_shared(const agile::inference_plan &plan, 
+    const agile::dataframe &D)
+{
+    const std::size_t n_in = plan.inputs().size(),
+                      n_out = plan.outputs().size(), rows = D.rows();
+    std::vector<double> in(rows * n_in), expected(rows * n_out);
+    for (std::size_t r = 0; r < rows; ++r)
+    {
+        for (std::size_t i = 0; i < n_in; ++i)
+        {
+            in[r * n_in + i] = D.at(r, plan.inputs()[i]);
+        }
+    }
+    auto w = plan.make_workspace();
+    for (std::size_t r = 0; r < rows; ++r)
+    {
+        plan.predict(&in[r * n_in], &expected[r * n_out], w);
+    }
+
+    const unsigned int n_threads = 8;
+    std::vector<std::vector<double>> got(n_threads, 
+        std::vector<double>(rows * n_out));
+    agile::run_parallel(n_threads, [&](unsigned int t)
+    {
+        auto own = plan.make_workspace();
+        // each thread goes over every row a few times, starting somewhere
+        // else, so they're all predicting at once
+        for (int pass = 0; pass < 5; ++pass)
+        {
+            for (std::size_t k = 0; k < rows; ++k)
+            {
+                std::size_t r = (k + t * rows / n_threads) % rows;
+                plan.predict(&in[r * n_in], &got[t][r * n_out], own);
+            }
+        }
+    });
+    bool same = true;
+    for (auto &g : got)
+    {
+        same = same && (g == expected);
+    }
+    check(same, "threads sharing a plan get the single thread answers");
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    agile::dataframe D = agile::checks::test_frame(2000);
+    agile::neural_net net;
+    agile::checks::build_test_network(net, D);
+    agile::inference_plan plan(net);
+
+    check(plan.inputs() == net.get_base_inputs(), "inputs()");
+    check(plan.outputs() == net.get_outputs(), "outputs()");
+
+    const std::size_t n_in = plan.inputs().size(),
+                      n_out = plan.outputs().size();
+    std::vector<double> in(n_in), out(n_out);
+    double largest = 0.0, largest_map = 0.0;
+    long allocated = 0;
+    for (std::size_t r = 0; r < D.rows(); ++r)
+    {
+        auto x = agile::checks::test_inputs(D, r);
+        for (std::size_t i = 0; i < n_in; ++i)
+        {
+            in[i] = x[plan.inputs()[i]];
+        }
+        auto expected = net.predict_map(x);
+        auto by_map = plan.predict(x);
+
+        long before = allocations;
+        plan.predict(in.data(), out.data());
+        allocated += allocations - before;
+
+        for (std::size_t o = 0; o < n_out; ++o)
+        {
+            const std::string &name = plan.outputs()[o];
+            largest = std::max(largest, std::fabs(out[o] - expected[name]));
+            largest_map = std::max(largest_map, 
+                std::fabs(by_map[name] - expected[name]));
+        }
+    }
+    check(largest < 1e-12, "predict() matches predict_map(), off by " +
+        std::to_string(largest));
+    check(largest_map < 1e-12, "predict() of a map matches predict_map()");
+    check(allocated == 0, "predict() allocated " + std::to_string(allocated)
+        + " times");
+
+    // recompiling gives the same plan
+    agile::inference_plan again;
+    again.compile(net);
+    std::vector<double> out_again(n_out);
+    again.predict(in.data(), out_again.data());
+    plan.predict(in.data(), out.data());
+    check(out == out_again, "compile() on a default plan");
+
+    check_shared(plan, D);
+
+    return agile::checks::report("inference_plan_test");
+}
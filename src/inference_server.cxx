@@ -0,0 +1,261 @@
+//-----------------------------------------------------------------------------
+//  inference_server.cxx:
+//  Implementation for the local micro-batching inference service
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "inference_server.hh"
+#include "local_socket.hh"
+#include <algorithm>
+#include <limits>
+
+namespace agile
+{
+
+//----------------------------------------------------------------------------
+inference_server::inference_server(const std::string &yaml_file)
+: m_max_batch(64), m_deadline(200), m_listen(-1), m_running(false),
+  m_open(0), m_requests(0), m_batches(0)
+{
+    m_net.from_file(yaml_file);
+    setup();
+}
+//----------------------------------------------------------------------------
+inference_server::inference_server(const neural_net &net)
+: m_net(net), m_max_batch(64), m_deadline(200), m_listen(-1),
+  m_running(false), m_open(0), m_requests(0), m_batches(0)
+{
+    setup();
+}
+//----------------------------------------------------------------------------
+inference_server::~inference_server()
+{
+    stop();
+}
+//----------------------------------------------------------------------------
+void inference_server::setup()
+{
+    if (m_net.size() == 0)
+    {
+        throw std::logic_error("can't serve an empty network.");
+    }
+    m_inputs = m_net.get_base_inputs();
+    m_outputs = m_net.get_outputs();
+    m_outputs.resize(m_net.at(m_net.size() - 1)->num_outputs());
+}
+//----------------------------------------------------------------------------
+inference_server& inference_server::set_max_batch(std::size_t n)
+{
+    m_max_batch = std::max<std::size_t>(n, 1);
+    return *this;
+}
+//----------------------------------------------------------------------------
+inference_server& inference_server::set_deadline(
+    std::chrono::microseconds deadline)
+{
+    m_deadline = deadline;
+    return *this;
+}
+//----------------------------------------------------------------------------
+void inference_server::start(const std::string &socket_path)
+{
+    if (m_running)
+    {
+        throw std::logic_error("inference_server is already running.");
+    }
+    m_listen = local_socket::listen_on(socket_path);
+    m_path = socket_path;
+    m_running = true;
+    m_batcher = std::thread(&inference_server::batch_loop, this);
+    m_acceptor = std::thread(&inference_server::accept_loop, this);
+}
+//----------------------------------------------------------------------------
+void inference_server::stop()
+{
+    if (!m_running)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        m_running = false;
+    }
+    m_queue_cv.notify_all();
+
+    // wakes up accept() and every read(), so all the threads finish
+    shutdown(m_listen, SHUT_RDWR);
+    m_acceptor.join();
+    {
+        std::lock_guard<std::mutex> lock(m_connection_mutex);
+        for (int fd : m_fds)
+        {
+            shutdown(fd, SHUT_RDWR);
+        }
+    }
+    for (auto &connection : m_connections)
+    {
+        connection.thread.join();
+    }
+    m_connections.clear();
+    m_batcher.join();
+
+    close(m_listen);
+    m_listen = -1;
+    unlink(m_path.c_str());
+}
+//----------------------------------------------------------------------------
+void inference_server::accept_loop()
+{
+    while (m_running)
+    {
+        int fd = accept(m_listen, nullptr, nullptr);
+        if (fd < 0)
+        {
+            if (m_running && (errno == EINTR || errno == ECONNABORTED))
+            {
+                continue;
+            }
+            break;
+        }
+        std::lock_guard<std::mutex> lock(m_connection_mutex);
+        if (!m_running)
+        {
+            close(fd);
+            break;
+        }
+        // joins the threads of connections that have closed since the last
+        // one came in, so a long running server doesn't pile them up
+        for (auto it = m_connections.begin(); it != m_connections.end(); )
+        {
+            if (it->finished)
+            {
+                it->thread.join();
+                it = m_connections.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        m_fds.push_back(fd);
+        ++m_open;
+        m_connections.emplace_back();
+        connection &c = m_connections.back();
+        c.finished = false;
+        c.thread = std::thread(&inference_server::serve, this, fd, 
+            &c.finished);
+    }
+}
+//----------------------------------------------------------------------------
+void inference_server::serve(int fd, std::atomic<bool> *finished)
+{
+    try
+    {
+        std::vector<char> header;
+        local_socket::append_names(header, m_inputs);
+        local_socket::append_names(header, m_outputs);
+
+        request req;
+        req.in.resize(m_inputs.size());
+        req.out.resize(m_outputs.size());
+        bool open = local_socket::write_all(fd, header.data(), header.size());
+        while (open && local_socket::read_all(fd, req.in.data(),
+            req.in.size() * sizeof(double)))
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_queue_mutex);
+                if (!m_running)
+                {
+                    break;
+                }
+                req.done = false;
+                req.arrived = std::chrono::steady_clock::now();
+                m_queue.push_back(&req);
+            }
+            m_queue_cv.notify_one();
+            {
+                std::unique_lock<std::mutex> lock(req.m);
+                req.cv.wait(lock, [&req]() { return req.done; });
+            }
+            open = local_socket::write_all(fd, req.out.data(),
+                req.out.size() * sizeof(double));
+        }
+    }
+    catch(std::exception &e)
+    {
+        std::cerr << "inference_server: " << e.what() << std::endl;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_connection_mutex);
+        m_fds.erase(std::find(m_fds.begin(), m_fds.end(), fd));
+        close(fd);
+    }
+    // one fewer connection may be all a waiting batch was waiting for
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        --m_open;
+    }
+    m_queue_cv.notify_one();
+    *finished = true;
+}
+//----------------------------------------------------------------------------
+void inference_server::batch_loop()
+{
+    std::vector<request*> batch;
+    agile::matrix X, Y;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_queue_mutex);
+            m_queue_cv.wait(lock, [this]()
+            {
+                return !m_running || !m_queue.empty();
+            });
+            if (m_queue.empty())
+            {
+                return;
+            }
+            // hold on for more until the oldest request's deadline, unless
+            // every connection is already waiting on this batch
+            auto deadline = m_queue.front()->arrived + m_deadline;
+            m_queue_cv.wait_until(lock, deadline, [this]()
+            {
+                return !m_running ||
+                    (m_queue.size() >= std::min<std::size_t>(m_max_batch, m_open));
+            });
+            std::size_t n = std::min(m_queue.size(), m_max_batch);
+            batch.assign(m_queue.begin(), m_queue.begin() + n);
+            m_queue.erase(m_queue.begin(), m_queue.begin() + n);
+        }
+
+        X.resize(batch.size(), m_inputs.size());
+        for (std::size_t i = 0; i < batch.size(); ++i)
+        {
+            X.row(i) = Eigen::Map<const agile::rowvec>(batch[i]->in.data(),
+                m_inputs.size());
+        }
+        try
+        {
+            Y = m_net.predict_batch(X, true, m_max_batch);
+        }
+        catch(std::exception &e)
+        {
+            std::cerr << "inference_server: " << e.what() << std::endl;
+            Y = agile::matrix::Constant(batch.size(), m_outputs.size(),
+                std::numeric_limits<double>::quiet_NaN());
+        }
+        for (std::size_t i = 0; i < batch.size(); ++i)
+        {
+            request &req = *batch[i];
+            std::lock_guard<std::mutex> lock(req.m);
+            Eigen::Map<agile::rowvec>(req.out.data(), m_outputs.size()) =
+                Y.row(i);
+            req.done = true;
+            req.cv.notify_one();
+        }
+        ++m_batches;
+        m_requests += batch.size();
+    }
+}
+
+}
@@ -0,0 +1,140 @@
+#include "include/inference_server.hh"
+#include "include/inference_client.hh"
+#include "include/test_network.hh"
+#include "dataframe/include/checks.hh"
+#include <algorithm>
+#include <dirent.h>
+#include <iostream>
+#include <unistd.h>
+
+using agile::checks::check;
+
+// threads in this process, or -1 without /proc to count them in
+int threads_running()
+{
+    DIR *dir = opendir("/proc/self/task");
+    if (!dir)
+    {
+        return -1;
+    }
+    int n = 0;
+    while (dirent *entry = readdir(dir))
+    {
+        n += (entry->d_name[0] != '.');
+    }
+    closedir(dir);
+    return n;
+}
+//----------------------------------------------------------------------------
+// largest difference between what client answers for rows [begin, end) of
+// D and the expected outputs of those rows
+double deviation(agile::inference_client &client, const agile::dataframe &D,
+    const std::vector<std::map<std::string, double>> &expected,
+    std::size_t begin, std::size_t end)
+{
+    double largest = 0.0;
+    for (std::size_t r = begin; r < end; ++r)
+    {
+        auto got = client.predict(agile::checks::test_inputs(D, r));
+        for (auto &entry : expected[r])
+        {
+            largest = std::max(largest,
+                std::fabs(got[entry.first] - entry.second));
+        }
+    }
+    return largest;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    agile::dataframe D = agile::checks::test_frame(2000);
+    agile::neural_net net;
+    agile::checks::build_test_network(net, D);
+
+    // predict_map() isn't for several threads at once, so the answers are
+    // worked out here
+    std::vector<std::map<std::string, double>> expected;
+    for (std::size_t r = 0; r < D.rows(); ++r)
+    {
+        expected.push_back(net.predict_map(agile::checks::test_inputs(D, r)));
+    }
+
+    const std::string path = "/tmp/inference_server_test." +
+        std::to_string(getpid()) + ".sock";
+    agile::inference_server server(net);
+    server.set_max_batch(16).set_deadline(std::chrono::microseconds(500));
+    server.start(path);
+
+    // clients at once, so requests get batched together
+    const unsigned int n_clients = 4;
+    const std::size_t rows = D.rows() / n_clients;
+    std::vector<double> largest(n_clients, HUGE_VAL);
+    std::vector<std::string> failed(n_clients);
+    std::vector<std::thread> clients;
+    for (unsigned int c = 0; c < n_clients; ++c)
+    {
+        clients.emplace_back([&, c]()
+        {
+            try
+            {
+                agile::inference_client client(path);
+                largest[c] = deviation(client, D, expected, c * rows,
+                    (c + 1) * rows);
+            }
+            catch (std::exception &e)
+            {
+                failed[c] = e.what();
+            }
+        });
+    }
+    for (auto &t : clients)
+    {
+        t.join();
+    }
+    for (unsigned int c = 0; c < n_clients; ++c)
+    {
+        std::string who = "client " + std::to_string(c);
+        check(failed[c].empty(), who + " failed: " + failed[c]);
+        check(largest[c] < 1e-12, who + " matches predict_map(), off by " +
+            std::to_string(largest[c]));
+    }
+    check(server.requests() == n_clients * rows, "requests()");
+    check(server.batches() > 0 && server.batches() <= server.requests(),
+        "batches()");
+
+    agile::inference_client names(path);
+    check(names.inputs() == server.inputs(), "client gets the inputs");
+    check(names.outputs() == server.outputs(), "client gets the outputs");
+    names.disconnect();
+
+    // one connection after another shouldn't leave a thread behind each
+    int threads = threads_running();
+    for (int i = 0; i < 50; ++i)
+    {
+        agile::inference_client client(path);
+        check(deviation(client, D, expected, i, i + 1) < 1e-12,
+            "connection " + std::to_string(i));
+    }
+    if (threads > 0)
+    {
+        check(threads_running() <= threads + 2, "finished connections "
+            "are joined, " + std::to_string(threads_running()) +
+            " threads running after starting with " +
+            std::to_string(threads));
+    }
+
+    server.stop();
+    bool refused = false;
+    try
+    {
+        agile::inference_client late(path);
+    }
+    catch (std::exception &e)
+    {
+        refused = true;
+    }
+    check(refused, "no connections after stop()");
+
+    return agile::checks::report("inference_server_test");
+}
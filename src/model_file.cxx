@@ -0,0 +1,322 @@
+//-----------------------------------------------------------------------------
+//  model_file.cxx:
+//  Implementation for the binary model format
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "model_file.hh"
+#include <cstring>
+#include <fstream>
+
+namespace agile
+{
+
+namespace
+{
+//----------------------------------------------------------------------------
+bool little_endian()
+{
+    const std::uint16_t probe = 1;
+    return *reinterpret_cast<const unsigned char*>(&probe) == 1;
+}
+//----------------------------------------------------------------------------
+std::size_t align_up(std::size_t n)
+{
+    const std::size_t a = model_format::alignment;
+    return (n + a - 1) / a * a;
+}
+//----------------------------------------------------------------------------
+template <typename T>
+void put(std::string &buf, const T &val)
+{
+    buf.append(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+//----------------------------------------------------------------------------
+template <typename T>
+T get(const char *base, std::size_t length, std::size_t &pos)
+{
+    if (pos + sizeof(T) > length)
+    {
+        throw std::runtime_error("model file header is truncated.");
+    }
+    T val;
+    std::memcpy(&val, base + pos, sizeof(T));
+    pos += sizeof(T);
+    return val;
+}
+//----------------------------------------------------------------------------
+const std::size_t preamble_size = 8 + 4 + 4 + 8 + 8;
+const std::size_t descriptor_size = 8 + 8 + 8;
+
+const std::string matrix_tag("#EM|"), block_tag("#EB|");
+
+//----------------------------------------------------------------------------
+bool starts_with(const std::string &s, const std::string &tag)
+{
+    return s.compare(0, tag.size(), tag) == 0;
+}
+//----------------------------------------------------------------------------
+// calls f on every scalar in the tree under node, which may reassign it
+template <typename F>
+void for_scalars(YAML::Node node, const F &f)
+{
+    if (node.IsScalar())
+    {
+        f(node);
+    }
+    else if (node.IsSequence())
+    {
+        for (std::size_t i = 0; i < node.size(); ++i)
+        {
+            for_scalars(node[i], f);
+        }
+    }
+    else if (node.IsMap())
+    {
+        for (auto it = node.begin(); it != node.end(); ++it)
+        {
+            for_scalars(it->second, f);
+        }
+    }
+}
+//----------------------------------------------------------------------------
+std::string emit(const YAML::Node &node)
+{
+    YAML::Emitter out;
+    out << node;
+    return out.c_str();
+}
+//----------------------------------------------------------------------------
+// takes whatever store is installed off the thread for as long as it lives,
+// so the conversions below see (and write) the real "#EM|" strings
+class no_store
+{
+public:
+    no_store() : m_previous(use_matrix_store(nullptr)) {}
+    ~no_store() { use_matrix_store(m_previous); }
+private:
+    matrix_store *m_previous;
+};
+}
+
+//-----------------------------------------------------------------------------
+//  Writing
+//-----------------------------------------------------------------------------
+void write_model_file(const std::string &filename, const std::string &metadata,
+    const std::vector<agile::matrix> &blocks)
+{
+    if (!little_endian())
+    {
+        throw std::runtime_error(
+            "model files are only supported on little endian hosts.");
+    }
+    const std::size_t metadata_offset = preamble_size +
+        descriptor_size * blocks.size();
+
+    std::vector<std::uint64_t> offsets;
+    std::size_t offset = align_up(metadata_offset + metadata.size());
+    for (auto &M : blocks)
+    {
+        offsets.push_back(offset);
+        offset = align_up(offset + M.size() * sizeof(double));
+    }
+
+    std::string header;
+    header.reserve(metadata_offset + metadata.size() + model_format::alignment);
+    header.append(model_format::magic, sizeof(model_format::magic));
+    put(header, model_format::version);
+    put(header, static_cast<std::uint32_t>(blocks.size()));
+    put(header, static_cast<std::uint64_t>(metadata.size()));
+    put(header, static_cast<std::uint64_t>(metadata_offset));
+    for (std::size_t i = 0; i < blocks.size(); ++i)
+    {
+        put(header, static_cast<std::uint64_t>(blocks[i].rows()));
+        put(header, static_cast<std::uint64_t>(blocks[i].cols()));
+        put(header, offsets[i]);
+    }
+    header.append(metadata);
+
+    std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+    if (!output.good())
+    {
+        throw std::runtime_error("can't open " + filename + " for writing.");
+    }
+    const std::string padding(model_format::alignment, '\0');
+    header.append(padding, 0, align_up(header.size()) - header.size());
+    output.write(header.data(), header.size());
+
+    std::size_t written = header.size();
+    for (std::size_t i = 0; i < blocks.size(); ++i)
+    {
+        output.write(padding.data(), offsets[i] - written);
+        output.write(reinterpret_cast<const char*>(blocks[i].data()),
+            blocks[i].size() * sizeof(double));
+        written = offsets[i] + blocks[i].size() * sizeof(double);
+    }
+    if (!output.good())
+    {
+        throw std::runtime_error("failed writing " + filename + ".");
+    }
+}
+//----------------------------------------------------------------------------
+bool is_model_file(const std::string &filename)
+{
+    std::ifstream input(filename, std::ios::binary);
+    char magic[sizeof(model_format::magic)];
+    return input.read(magic, sizeof(magic)) &&
+        (std::memcmp(magic, model_format::magic, sizeof(magic)) == 0);
+}
+//----------------------------------------------------------------------------
+void yaml_to_model_file(const std::string &yaml_file,
+    const std::string &model_file)
+{
+    no_store guard;
+    YAML::Node document = YAML::LoadFile(yaml_file);
+
+    std::vector<agile::matrix> blocks;
+    for_scalars(document, [&blocks](YAML::Node &node)
+    {
+        if (starts_with(node.Scalar(), matrix_tag))
+        {
+            blocks.push_back(destringify(node.Scalar()));
+            node = block_tag + std::to_string(blocks.size() - 1);
+        }
+    });
+    write_model_file(model_file, emit(document), blocks);
+}
+//----------------------------------------------------------------------------
+void model_file_to_yaml(const std::string &model_file,
+    const std::string &yaml_file)
+{
+    mapped_model model(model_file);
+    std::ofstream file(yaml_file);
+    if (!file.good())
+    {
+        throw std::runtime_error("can't open " + yaml_file + " for writing.");
+    }
+    file << emit(model.to_yaml());
+}
+
+//-----------------------------------------------------------------------------
+//  Reading
+//-----------------------------------------------------------------------------
+mapped_model::mapped_model(const std::string &filename)
+{
+    if (!filename.empty())
+    {
+        open(filename);
+    }
+}
+//----------------------------------------------------------------------------
+void mapped_model::open(const std::string &filename)
+{
+    close();
+    if (!little_endian())
+    {
+        throw std::runtime_error(
+            "model files are only supported on little endian hosts.");
+    }
+    m_file.open(filename);
+    const char *base = m_file.data();
+    const std::size_t length = m_file.size();
+
+    if ((length < preamble_size) ||
+        (std::memcmp(base, model_format::magic, sizeof(model_format::magic))))
+    {
+        close();
+        throw std::runtime_error(filename + " is not an AGILEPack model file.");
+    }
+    std::size_t pos = sizeof(model_format::magic);
+    auto version = get<std::uint32_t>(base, length, pos);
+    if (version != model_format::version)
+    {
+        close();
+        throw std::runtime_error(filename + " has model format version " +
+            std::to_string(version) + ", expected " +
+            std::to_string(model_format::version) + ".");
+    }
+    auto n_blocks = get<std::uint32_t>(base, length, pos);
+    auto metadata_length = get<std::uint64_t>(base, length, pos);
+    auto metadata_offset = get<std::uint64_t>(base, length, pos);
+
+    try
+    {
+        for (std::uint32_t i = 0; i < n_blocks; ++i)
+        {
+            auto rows = get<std::uint64_t>(base, length, pos);
+            auto cols = get<std::uint64_t>(base, length, pos);
+            auto offset = get<std::uint64_t>(base, length, pos);
+
+            if ((offset % model_format::alignment) || (offset > length) ||
+                (cols && (rows > (length - offset) / sizeof(double) / cols)))
+            {
+                throw std::runtime_error("block " + std::to_string(i) +
+                    " of " + filename + " is misaligned or truncated.");
+            }
+            m_rows.push_back(rows);
+            m_cols.push_back(cols);
+            m_offsets.push_back(offset);
+        }
+        if ((metadata_offset > length) ||
+            (metadata_length > length - metadata_offset))
+        {
+            throw std::runtime_error("metadata of " + filename +
+                " is truncated.");
+        }
+        m_metadata.assign(base + metadata_offset, metadata_length);
+        m_document = YAML::Load(m_metadata);
+    }
+    catch (...)
+    {
+        close();
+        throw;
+    }
+}
+//----------------------------------------------------------------------------
+void mapped_model::close()
+{
+    m_file.close();
+    m_metadata.clear();
+    m_document = YAML::Node();
+    m_rows.clear();
+    m_cols.clear();
+    m_offsets.clear();
+}
+//----------------------------------------------------------------------------
+mapped_model::matrix_map mapped_model::block(std::size_t idx) const
+{
+    if (idx >= m_rows.size())
+    {
+        throw std::out_of_range("model file has no block " +
+            std::to_string(idx) + ".");
+    }
+    return matrix_map(reinterpret_cast<const double*>(m_file.data() +
+        m_offsets[idx]), m_rows[idx], m_cols[idx]);
+}
+//----------------------------------------------------------------------------
+mapped_model::matrix_map mapped_model::block(
+    const std::string &reference) const
+{
+    if (!starts_with(reference, block_tag))
+    {
+        throw std::invalid_argument("not a block reference: " +
+            reference.substr(0, 16));
+    }
+    return block(std::stoul(reference.substr(block_tag.size())));
+}
+//----------------------------------------------------------------------------
+YAML::Node mapped_model::to_yaml() const
+{
+    no_store guard;
+    YAML::Node document = YAML::Load(m_metadata);
+    for_scalars(document, [this](YAML::Node &node)
+    {
+        if (starts_with(node.Scalar(), block_tag))
+        {
+            node = stringify(agile::matrix(block(node.Scalar())));
+        }
+    });
+    return document;
+}
+
+}
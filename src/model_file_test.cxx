@@ -0,0 +1,176 @@
+#include "include/model_file.hh"
+#include "include/test_network.hh"
+#include "dataframe/include/checks.hh"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using agile::checks::check;
+
+// largest difference between the predict_map() of a and b over D
+double deviation(agile::neural_net &a, agile::neural_net &b,
+    const agile::dataframe &D)
+{
+    double largest = 0.0;
+    for (std::size_t r = 0; r < D.rows(); ++r)
+    {
+        auto x = agile::checks::test_inputs(D, r);
+        auto y_a = a.predict_map(x), y_b = b.predict_map(x);
+        for (auto &entry : y_a)
+        {
+            double diff = std::fabs(entry.second - y_b[entry.first]);
+            largest = std::isnan(diff) ? HUGE_VAL : std::max(largest, diff);
+        }
+    }
+    return largest;
+}
+//----------------------------------------------------------------------------
+std::string slurp(const std::string &filename)
+{
+    std::stringstream ss;
+    ss << std::ifstream(filename, std::ios::binary).rdbuf();
+    return ss.str();
+}
+//----------------------------------------------------------------------------
+// true if opening filename as a model file throws a runtime_error
+bool refused(const std::string &filename)
+{
+    try
+    {
+        agile::mapped_model model(filename);
+    }
+    catch (std::runtime_error &e)
+    {
+        return true;
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------
+// blocks written straight out come back the same, each on a 64 byte boundary
+void check_blocks()
+{
+    const std::string file = "model_file_test.blocks";
+    std::vector<agile::matrix> blocks = {agile::matrix::Random(3, 5),
+        agile::matrix::Random(1, 1), agile::matrix(0, 4),
+        agile::matrix::Random(7, 2)};
+    agile::write_model_file(file, "blocks: [\"#EB|0\", \"#EB|3\"]", blocks);
+
+    agile::mapped_model model(file);
+    check(model.blocks() == blocks.size(), "blocks()");
+    for (std::size_t i = 0; i < blocks.size(); ++i)
+    {
+        std::string which = "block " + std::to_string(i);
+        auto M = model.block(i);
+        check((M.rows() == blocks[i].rows()) &&
+            (M.cols() == blocks[i].cols()), which + ": shape");
+        check(agile::matrix(M) == blocks[i], which + ": values");
+        check(reinterpret_cast<std::uintptr_t>(M.data()) %
+            agile::model_format::alignment == 0, which + ": aligned");
+    }
+    check(model.document()["blocks"].size() == 2, "document()");
+    check(agile::matrix(model.block(
+        model.document()["blocks"][1].as<std::string>())) == blocks[3],
+        "block() of a reference");
+
+    bool threw = false;
+    try
+    {
+        model.block(blocks.size());
+    }
+    catch (std::out_of_range &e)
+    {
+        threw = true;
+    }
+    check(threw, "block() past the end throws");
+    model.close();
+    std::remove(file.c_str());
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    check_blocks();
+
+    agile::dataframe D = agile::checks::test_frame(2000, 1),
+                     held_out = agile::checks::test_frame(1000, 10);
+    agile::neural_net net;
+    agile::checks::build_test_network(net, D);
+
+    const std::string yaml = "model_file_test.yaml",
+                      binary = "model_file_test.bin",
+                      back = "model_file_test_back.yaml",
+                      direct = "model_file_test_direct.bin",
+                      broken = "model_file_test_broken.bin";
+    net.to_yaml(yaml);
+    net.to_binary(direct);
+    agile::yaml_to_model_file(yaml, binary);
+    agile::model_file_to_yaml(binary, back);
+
+    check(agile::is_model_file(binary), "is_model_file() of a model file");
+    check(!agile::is_model_file(yaml), "is_model_file() of YAML");
+
+    // every matrix of the network (W and b of three layers) is a block
+    agile::mapped_model model(binary);
+    check(model.blocks() >= 6, "the weights are blocks");
+    bool aligned = true;
+    for (std::size_t i = 0; i < model.blocks(); ++i)
+    {
+        aligned = aligned && (reinterpret_cast<std::uintptr_t>(
+            model.block(i).data()) % agile::model_format::alignment == 0);
+    }
+    check(aligned, "the blocks are aligned");
+    model.close();
+
+    // the binary form of the YAML, and the YAML of that, are the same
+    // network as the YAML
+    agile::neural_net from_yaml, from_binary, from_back, from_direct;
+    from_yaml.from_file(yaml);
+    from_binary.from_file(binary);
+    from_back.from_file(back);
+    from_direct.from_file(direct);
+    check(deviation(from_yaml, from_binary, held_out) == 0.0,
+        "binary conversion of the YAML is the same network");
+    check(deviation(from_yaml, from_back, held_out) == 0.0,
+        "YAML conversion of that is the same network");
+    check(deviation(net, from_direct, held_out) == 0.0,
+        "to_binary() saves the network as it is");
+    check(deviation(net, from_yaml, held_out) == 0.0,
+        "to_yaml() saves the network as it is");
+    check(from_yaml.get_base_inputs() == from_binary.get_base_inputs(),
+        "same inputs");
+    check(from_yaml.get_outputs() == from_binary.get_outputs(),
+        "same outputs");
+
+    // a file cut short anywhere, or with the wrong magic or version, is
+    // refused rather than read past its end
+    const std::string whole = slurp(binary);
+    bool all_refused = true;
+    for (std::size_t length : {std::size_t(0), std::size_t(12),
+        std::size_t(40), std::size_t(100), whole.size() / 2,
+        whole.size() - 1})
+    {
+        std::ofstream(broken, std::ios::binary | std::ios::trunc)
+            .write(whole.data(), length);
+        all_refused = all_refused && refused(broken);
+    }
+    check(all_refused, "truncated files are refused");
+
+    std::string wrong_magic(whole), wrong_version(whole);
+    wrong_magic[0] = 'X';
+    wrong_version[8] = 99;
+    std::ofstream(broken, std::ios::binary | std::ios::trunc) << wrong_magic;
+    check(!agile::is_model_file(broken) && refused(broken),
+        "wrong magic is refused");
+    std::ofstream(broken, std::ios::binary | std::ios::trunc)
+        << wrong_version;
+    check(refused(broken), "wrong version is refused");
+
+    for (auto &file : {yaml, binary, back, direct, broken})
+    {
+        std::remove(file.c_str());
+    }
+    return agile::checks::report("model_file_test");
+}
@@ -43,8 +43,6 @@ void model_frame::model_formula(const std::string &formula)
 
 void model_frame::generate(bool verbose)
 {
-    agile::matrix T = eigen_spew(DF);
-
     m_X.resize(DF.rows(), inputs.size());
     m_Y.resize(DF.rows(), outputs.size());
 
@@ -63,7 +61,7 @@ void model_frame::generate(bool verbose)
     double pct;
     for (auto &name : inputs)
     {
-        m_X.col(idx) = T.col(DF.get_column_idx(name));
+        extract(name, m_X.col(idx).data());
         ++idx;
         ++ctr;
         if (verbose)
@@ -78,7 +76,7 @@ void model_frame::generate(bool verbose)
     {
         for (auto &name : outputs)
         {
-            m_Y.col(idx) = T.col(DF.get_column_idx(name));
+            extract(name, m_Y.col(idx).data());
             ++idx;
             ++ctr;
             if (verbose)
@@ -91,11 +89,25 @@ void model_frame::generate(bool verbose)
     }
     if (weighting_variable != "")
     {
-        m_weighting = T.col(DF.get_column_idx(weighting_variable));
+        m_weighting.resize(DF.rows());
+        extract(weighting_variable, m_weighting.data());
         weights_set = true;
     }
 }
 
+//----------------------------------------------------------------------------
+void model_frame::extract(const std::string &name, double *out)
+{
+    auto derived = m_derived.find(name);
+    if (derived != m_derived.end())
+    {
+        derived->second.evaluate(DF, out);
+    }
+    else
+    {
+        DF.copy_column(DF.get_column_idx(name), out);
+    }
+}
 //----------------------------------------------------------------------------
 void model_frame::scale(bool verbose)
 {
@@ -103,27 +115,30 @@ void model_frame::scale(bool verbose)
     {
         throw std::runtime_error("must load an X into model frame before scaling.");
     }
-    unsigned int columns_to_extract = inputs.size();
-    int idx = 0;
-    double pct;
     if (verbose)
     {
         std::cout << "\nScaling model frame..." << std::endl;
     }
+
+    // one multi-threaded pass over all of the inputs
+    std::vector<const double*> columns;
+    for (unsigned int idx = 0; idx < inputs.size(); ++idx)
+    {
+        columns.push_back(m_X.col(idx).data());
+    }
+    m_scaling = agile::make_scaling(inputs, 
+        agile::column_statistics(columns, m_X.rows()));
+
+    int idx = 0;
     for (auto &name : inputs)
     {
-        agile::calc_normalization(m_X.col(idx), name, m_scaling);
         m_X.col(idx).array() -= m_scaling.mean[name];
         m_X.col(idx) /= m_scaling.sd[name];
         ++idx;
-        if (verbose)
-        {
-            pct = (double)(idx) / (double)(columns_to_extract);
-            agile::progress_bar(pct * 100);
-        }
     }
     if (verbose)
     {
+        agile::progress_bar(100);
         std::cout << std::endl;
     }
 }
@@ -169,97 +184,24 @@ agile::vector& model_frame::weighting()
     }  
 }
 //----------------------------------------------------------------------------
-// parses formulas of the form bottom ~ pt + eta | weight
+// parses formulas of the form bottom ~ pt + eta + log(m) + I(tau2/tau1) | weight
 void model_frame::parse_formula(std::string formula)
 {
-    auto pipe = formula.find_first_of("|");
-
-    if (pipe != std::string::npos)
-    {
-        weighting_variable = agile::no_spaces(formula.substr(pipe + 1));
-        formula = formula.substr(0, pipe);
-        exclusions.insert(weighting_variable);
-    }
-
-    formula = agile::no_spaces(formula);
-    bool parsing = true, wildcard = false;
-    auto tilde = formula.find_first_of("~");
-    if (tilde != formula.find_last_of("~"))
-    {
-        std::string e("can't specify multiple \'is a function of\'");
-        e.append(" operators (uses of \'~\') in one formula.");
-        throw agile::parsing_error(e);
-    }
+    agile::formula parsed(formula);
 
-    auto wildcard_find = formula.find_first_of("*");
-    if (wildcard_find != formula.find_last_of("*"))
+    weighting_variable = parsed.weight();
+    outputs = parsed.outputs();
+    if (outputs.empty())
     {
-        std::string e("can't specify multiple \'include all defined");
-        e.append(" variables\' operators (uses of \'*\') in one formula.");
-        throw agile::parsing_error(e);
+        outputs.push_back("");
     }
-    
-    if (wildcard_find != std::string::npos)
-    {
-        wildcard = true;
-        std::string::iterator end_pos = std::remove(
-            formula.begin(), formula.end(), '*');
+    inputs = parsed.expand_inputs(DF.get_column_names());
+    m_derived = parsed.derived();
 
-        formula.erase(end_pos, formula.end());
-    }
-    auto lhs = formula.substr(0, tilde);
-    auto rhs = formula.substr(tilde + 1);
-    auto end = lhs.find_first_of('+');
-    unsigned long int start = 0;
-    while(parsing == true)
-    {
-        auto new_var = lhs.substr(start, end - start);
-        outputs.push_back(new_var);
-        if (wildcard)
-        {
-            exclusions.insert(new_var);
-        }  
-        
-        if (end == std::string::npos) parsing = false;
-        start = end + 1;
-        end = lhs.find_first_of('+', start);
-    }
-    parsing = true;
-    start = (rhs[0] == '-' || rhs[0] == '+') ? 1 : 0;
-    end = rhs.find_first_of("+-", start);
-    while(parsing == true)
-    {
-        auto new_var = rhs.substr(start, end - start);
-        if (rhs[start - 1] == '-')
-        {
-            exclusions.insert(new_var);
-        }
-        else
-        {
-            if (!wildcard)
-            {
-                inputs.push_back(new_var);
-            }
-        }
-        if (end == std::string::npos) parsing = false;
-        start = end + 1;
-        end = rhs.find_first_of("+-", start);
-    }
-    if (wildcard)
-    {
-        for (auto &name : DF.get_column_names())
-        {
-            if (exclusions.count(name) == 0)
-            {
-                inputs.push_back(name);
-            }
-        }    
-    }
     x_set = (inputs.size() == 0) ? false : true;
     y_set = (outputs.size() == 0) ? false : true;
 }
 //----------------------------------------------------------------------------
-
 std::vector<std::string> model_frame::get_inputs()
 {
     return inputs;
@@ -270,8 +212,14 @@ std::vector<std::string> model_frame::get_outputs()
     return outputs;
 }
 //----------------------------------------------------------------------------
-parsing_error::parsing_error(const std::string &what)
-: std::runtime_error(what)
-{}
+std::map<std::string, std::string> model_frame::get_derived()
+{
+    std::map<std::string, std::string> derived;
+    for (auto &entry : m_derived)
+    {
+        derived[entry.first] = entry.second.source();
+    }
+    return derived;
+}
 
 }
\ No newline at end of file
@@ -0,0 +1,235 @@
+//-----------------------------------------------------------------------------
+//  model_set.cxx:
+//  Implementation for scoring samples with several networks at once
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "model_set.hh"
+#include "dataframe/include/parallel.hh"
+#include <algorithm>
+#include <atomic>
+
+namespace agile
+{
+
+//----------------------------------------------------------------------------
+model_set::model_set()
+{
+}
+//----------------------------------------------------------------------------
+model_set& model_set::add(const std::string &yaml_file)
+{
+    std::string name = yaml_file.substr(yaml_file.find_last_of('/') + 1);
+    return add(yaml_file, name.substr(0, name.find_last_of('.')));
+}
+//----------------------------------------------------------------------------
+model_set& model_set::add(const std::string &yaml_file,
+    const std::string &name)
+{
+    neural_net net;
+    net.from_file(yaml_file);
+    return add(net, name);
+}
+//----------------------------------------------------------------------------
+model_set& model_set::add(neural_net &net, const std::string &name,
+    bool scale)
+{
+    inference_plan plan(net, scale);
+
+    model m;
+    m.name = name;
+    for (std::size_t i = 0; i < plan.m_slot.size(); ++i)
+    {
+        feature f;
+        f.slot = -1;
+        f.expr = -1;
+        if (plan.m_slot[i] >= 0)
+        {
+            f.slot = input_slot(plan.m_inputs[plan.m_slot[i]]);
+        }
+        else
+        {
+            // derived inputs are the same if their formulae are
+            const std::string &source = plan.m_expr[i].source();
+            auto same = std::find_if(m_exprs.begin(), m_exprs.end(),
+                [&source](const agile::expression &e)
+            {
+                return e.source() == source;
+            });
+            f.expr = same - m_exprs.begin();
+            if (same == m_exprs.end())
+            {
+                agile::expression e(source);
+                for (auto &var : e.variables())
+                {
+                    input_slot(var);
+                }
+                e.bind(m_inputs);
+                m_exprs.push_back(std::move(e));
+            }
+        }
+        f.mul = plan.m_mul(i);
+        f.add = plan.m_add(i);
+
+        auto same = std::find_if(m_features.begin(), m_features.end(),
+            [&f](const feature &g)
+        {
+            return (g.slot == f.slot) && (g.expr == f.expr) &&
+                (g.mul == f.mul) && (g.add == f.add);
+        });
+        m.features.push_back(same - m_features.begin());
+        if (same == m_features.end())
+        {
+            m_features.push_back(f);
+        }
+    }
+    m.stages = plan.m_stages;
+
+    std::vector<std::string> columns = plan.outputs();
+    m.first_output = m_outputs.size();
+    m.n_outputs = m.stages.back().W.rows();
+    columns.resize(m.n_outputs);
+    for (std::size_t k = 0; k < m.n_outputs; ++k)
+    {
+        if (columns[k].empty())
+        {
+            columns[k] = "output_" + std::to_string(k);
+        }
+        if (!name.empty())
+        {
+            columns[k] = (m.n_outputs == 1) ? name : name + "_" + columns[k];
+        }
+        if (std::find(m_outputs.begin(), m_outputs.end(), columns[k]) !=
+            m_outputs.end())
+        {
+            throw std::invalid_argument("two models both give a column " +
+                columns[k] + ", give them different names.");
+        }
+    }
+    m_outputs.insert(m_outputs.end(), columns.begin(), columns.end());
+    m_models.push_back(std::move(m));
+    return *this;
+}
+//----------------------------------------------------------------------------
+std::size_t model_set::input_slot(const std::string &name)
+{
+    auto found = std::find(m_inputs.begin(), m_inputs.end(), name);
+    if (found != m_inputs.end())
+    {
+        return found - m_inputs.begin();
+    }
+    m_inputs.push_back(name);
+    return m_inputs.size() - 1;
+}
+//----------------------------------------------------------------------------
+std::size_t model_set::total_inputs() const
+{
+    std::size_t total = 0;
+    for (auto &m : m_models)
+    {
+        total += m.features.size();
+    }
+    return total;
+}
+//----------------------------------------------------------------------------
+agile::matrix model_set::predict_batch(const agile::matrix &X,
+    std::size_t tile_rows, unsigned int n_threads) const
+{
+    if (m_models.empty())
+    {
+        throw std::logic_error("can't predict with an empty model_set.");
+    }
+    if (X.cols() != (long) m_inputs.size())
+    {
+        throw std::invalid_argument("batch has " + std::to_string(X.cols()) +
+            " columns, models need " + std::to_string(m_inputs.size()) +
+            " inputs.");
+    }
+    agile::matrix Y(X.rows(), m_outputs.size());
+
+    tile_rows = std::max<std::size_t>(tile_rows, 1);
+    const std::size_t rows = X.rows();
+    const std::size_t n_tiles = (rows + tile_rows - 1) / tile_rows;
+    unsigned int workers = std::max<std::size_t>(1, std::min<std::size_t>(
+        agile::default_threads(n_threads), n_tiles));
+
+    std::atomic<std::size_t> next(0);
+    agile::run_parallel(workers, [&](unsigned int)
+    {
+        std::vector<const double*> base(m_inputs.size());
+        agile::matrix R, F, A, Z;
+        agile::expression::scratch work;
+        for (std::size_t t = next++; t < n_tiles; t = next++)
+        {
+            const std::size_t first = t * tile_rows;
+            const long n = std::min(tile_rows, rows - first);
+
+            // the shared work: derived inputs, then scaling, once each
+            for (std::size_t k = 0; k < base.size(); ++k)
+            {
+                base[k] = X.col(k).data() + first;
+            }
+            R.resize(n, m_exprs.size());
+            for (std::size_t e = 0; e < m_exprs.size(); ++e)
+            {
+                m_exprs[e].evaluate(base.data(), n, R.col(e).data(), work);
+            }
+            F.resize(n, m_features.size());
+            for (std::size_t j = 0; j < m_features.size(); ++j)
+            {
+                const feature &f = m_features[j];
+                if (f.slot >= 0)
+                {
+                    F.col(j) = (X.col(f.slot).segment(first, n).array() *
+                        f.mul + f.add).matrix();
+                }
+                else
+                {
+                    F.col(j) = (R.col(f.expr).array() * f.mul +
+                        f.add).matrix();
+                }
+            }
+
+            // then each network off the shared columns
+            for (auto &m : m_models)
+            {
+                A.resize(n, m.features.size());
+                for (std::size_t i = 0; i < m.features.size(); ++i)
+                {
+                    A.col(i) = F.col(m.features[i]);
+                }
+                for (auto &s : m.stages)
+                {
+                    Z.noalias() = A * s.W.transpose();
+                    Z.rowwise() += s.b.transpose();
+                    agile::functions::activate_rows(Z, s.type);
+                    A.swap(Z);
+                }
+                Y.block(first, m.first_output, n, m.n_outputs) = A;
+            }
+        }
+    });
+    return Y;
+}
+//----------------------------------------------------------------------------
+agile::dataframe model_set::predict(const agile::dataframe &D,
+    std::size_t tile_rows, unsigned int n_threads) const
+{
+    agile::matrix X(D.rows(), m_inputs.size());
+    for (std::size_t c = 0; c < m_inputs.size(); ++c)
+    {
+        D.copy_column(D.get_column_idx(m_inputs[c]), X.col(c).data());
+    }
+    agile::matrix Y = predict_batch(X, tile_rows, n_threads);
+
+    agile::dataframe scores;
+    for (std::size_t k = 0; k < m_outputs.size(); ++k)
+    {
+        agile::column C(agile::float64, Y.rows());
+        agile::vector::Map(C.data<double>(), Y.rows()) = Y.col(k);
+        scores.add_column(m_outputs[k], std::move(C));
+    }
+    return scores;
+}
+
+}
@@ -0,0 +1,130 @@
+#include "include/model_set.hh"
+#include "include/test_network.hh"
+#include "dataframe/include/checks.hh"
+#include <algorithm>
+#include <iostream>
+
+using agile::checks::check;
+
+// largest difference between column `column` of scores and output `output`
+// of predict_map() of net, over the rows of D
+double deviation(agile::neural_net &net, const agile::dataframe &D,
+    const agile::dataframe &scores, const std::string &column,
+    const std::string &output)
+{
+    double largest = 0.0;
+    for (std::size_t r = 0; r < D.rows(); ++r)
+    {
+        auto expected = net.predict_map(agile::checks::test_inputs(D, r));
+        double diff = std::fabs(scores.at(r, column) - expected[output]);
+        largest = std::isnan(diff) ? HUGE_VAL : std::max(largest, diff);
+    }
+    return largest;
+}
+
+//----------------------------------------------------------------------------
+// scoring a frame a chunk at a time and putting the scores back together, as
+// AGILEScore does, gives the scores of the whole frame
+void check_chunks(const agile::model_set &models)
+{
+    std::vector<agile::dataframe> chunks = {agile::checks::test_frame(700, 7),
+        agile::checks::test_frame(1, 8), agile::checks::test_frame(1299, 9)};
+    agile::dataframe whole = agile::concatenate(chunks);
+
+    std::vector<agile::dataframe> parts;
+    for (auto &chunk : chunks)
+    {
+        parts.push_back(models.predict(chunk));
+    }
+    agile::dataframe chunked = agile::concatenate(parts),
+                     expected = models.predict(whole);
+
+    check(chunked.rows() == whole.rows(), "chunks: a score per row");
+    check(chunked.get_column_names() == models.outputs(), "chunks: columns");
+    double largest = 0.0;
+    for (std::size_t r = 0; r < whole.rows(); ++r)
+    {
+        for (auto &column : models.outputs())
+        {
+            largest = std::max(largest,
+                std::fabs(chunked.at(r, column) - expected.at(r, column)));
+        }
+    }
+    check(largest < 1e-12, "chunks match the whole frame, off by " +
+        std::to_string(largest));
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    agile::dataframe D = agile::checks::test_frame(2000, 1),
+                     held_out = agile::checks::test_frame(3000, 6);
+
+    // two networks on the same inputs, and one taking some of them (and c
+    // on its own, which they don't) with a single output. All are scaled on
+    // D, so whatever inputs they have in common are shared.
+    agile::neural_net first, second, third;
+    agile::checks::build_test_network(first, D);
+    agile::checks::build_test_network(second, D);
+    third.add_data(D);
+    third.model_formula("y0 ~ c + a + log(abs(a*c)+1)");
+    third.emplace_back(new layer(3, 8, rectified));
+    third.emplace_back(new layer(8, 1, sigmoid));
+    third.check(false);
+
+    agile::model_set models;
+    models.add(first, "first").add(second, "second").add(third, "third");
+
+    check(models.size() == 3, "size()");
+    check(models.inputs() == std::vector<std::string>({"a", "b", "c"}),
+        "inputs() merged in the order first seen");
+    check(models.outputs() == std::vector<std::string>({"first_y0",
+        "first_y1", "second_y0", "second_y1", "third"}), "outputs() named "
+        "after the models");
+    check(models.total_inputs() == 9, "total_inputs()");
+    check(models.shared_inputs() == 4, "shared_inputs(): a, b, c and the "
+        "derived input, scaled the same for every network");
+
+    agile::dataframe scores = models.predict(held_out);
+    check(scores.rows() == held_out.rows(), "a score per row");
+    const std::pair<agile::neural_net*, std::string> columns[] = {
+        {&first, "y0"}, {&first, "y1"}, {&second, "y0"}, {&second, "y1"},
+        {&third, "y0"}};
+    for (std::size_t k = 0; k < models.outputs().size(); ++k)
+    {
+        const std::string &column = models.outputs()[k];
+        double off = deviation(*columns[k].first, held_out, scores, column,
+            columns[k].second);
+        check(off < 1e-12, column + " matches predict_map(), off by " +
+            std::to_string(off));
+    }
+
+    // the same tiles on any number of threads give the same answers
+    agile::dataframe one = models.predict(held_out, 256, 1),
+                     many = models.predict(held_out, 256, 4);
+    bool same = true;
+    for (std::size_t r = 0; r < held_out.rows(); ++r)
+    {
+        for (auto &column : models.outputs())
+        {
+            same = same && (one.at(r, column) == many.at(r, column));
+        }
+    }
+    check(same, "threads don't change the scores");
+
+    check_chunks(models);
+
+    // two models can't give the same column
+    bool threw = false;
+    try
+    {
+        models.add(third, "third");
+    }
+    catch (std::invalid_argument &e)
+    {
+        threw = true;
+    }
+    check(threw, "add() refuses a repeated name");
+
+    return agile::checks::report("model_set_test");
+}
@@ -5,35 +5,86 @@
 //-----------------------------------------------------------------------------
 
 #include "neural_net.hh"
+#include "model_file.hh"
 
 namespace agile
 {
 
+namespace
+{
+//----------------------------------------------------------------------------
+// keeps the matrices stringify() is handed, so to_binary() can write them
+// out as blocks
+class block_writer : public matrix_store
+{
+public:
+    std::string put(const agile::matrix &M)
+    {
+        blocks.push_back(M);
+        return "#EB|" + std::to_string(blocks.size() - 1);
+    }
+    agile::matrix get(const std::string &reference)
+    {
+        return blocks.at(std::stoul(reference.substr(4)));
+    }
+    std::vector<agile::matrix> blocks;
+};
+//----------------------------------------------------------------------------
+// hands destringify() the blocks of a mapped model file
+class block_reader : public matrix_store
+{
+public:
+    explicit block_reader(const mapped_model &model) : m_model(model) {}
+    std::string put(const agile::matrix &)
+    {
+        throw std::logic_error("can't add matrices to a mapped model.");
+    }
+    agile::matrix get(const std::string &reference)
+    {
+        return m_model.block(reference);
+    }
+private:
+    const mapped_model &m_model;
+};
+//----------------------------------------------------------------------------
+// installs a store for as long as it lives
+class store_scope
+{
+public:
+    explicit store_scope(matrix_store *store) 
+    : m_previous(use_matrix_store(store)) {}
+    ~store_scope() { use_matrix_store(m_previous); }
+private:
+    matrix_store *m_previous;
+};
+}
+
 neural_net::neural_net(int num_layers) 
-: architecture(num_layers), m_checked(false), m_weighted(false)
+: architecture(num_layers), m_checked(false), m_weighted(false),
+m_ordered_ready(false), m_scaling_folded(false)
 {
 }
 //----------------------------------------------------------------------------
 neural_net::neural_net(std::initializer_list<int> il, problem_type type) 
-: architecture(il, type),  m_checked(false), m_weighted(false)
+: architecture(il, type),  m_checked(false), m_weighted(false),
+m_ordered_ready(false), m_scaling_folded(false)
 {
 }
 //----------------------------------------------------------------------------
 neural_net::neural_net(const std::vector<int> &v, problem_type type) 
-: architecture(v, type),  m_checked(false), m_weighted(false)
+: architecture(v, type),  m_checked(false), m_weighted(false),
+m_ordered_ready(false), m_scaling_folded(false)
 {
 }
 //----------------------------------------------------------------------------
 neural_net::neural_net(const neural_net &arch) 
 : architecture(arch), predictor_order(arch.predictor_order), 
 target_order(arch.target_order), X(arch.X), Y(arch.Y),
-m_model(arch.m_model),  m_checked(false), m_weighted(false)
+m_model(arch.m_model),  m_checked(false), m_weighted(false),
+m_scaling(arch.m_scaling), m_derived(arch.m_derived), m_ordered_ready(false),
+m_scaling_folded(arch.m_scaling_folded)
 {
-    for (auto &entry : arch.stack)
-    {
-        stack.emplace_back(entry->clone());
-        ++n_layers;
-    }
+    // architecture(arch) has already cloned the layers
     n_training = X.rows();
 }
 //----------------------------------------------------------------------------
@@ -54,6 +105,10 @@ neural_net& neural_net::operator =(const neural_net &arch)
     n_training = X.rows();
     m_checked = arch.m_checked;
     m_weighted = arch.m_weighted;
+    m_scaling = arch.m_scaling;
+    m_derived = arch.m_derived;
+    m_ordered_ready = false;
+    m_scaling_folded = arch.m_scaling_folded;
     return *this;
 }
 //----------------------------------------------------------------------------
@@ -72,6 +127,10 @@ neural_net& neural_net::operator =(neural_net &&arch)
     m_model = std::move(arch.m_model);
     n_training = std::move(n_training);
     m_weighted = std::move(arch.m_weighted);
+    m_scaling = std::move(arch.m_scaling);
+    m_derived = std::move(arch.m_derived);
+    m_ordered_ready = false;
+    m_scaling_folded = arch.m_scaling_folded;
     return *this;
 }
 //----------------------------------------------------------------------------
@@ -113,6 +172,8 @@ void neural_net::model_formula(const std::string &formula,
     m_tmp_output.resize(Y.cols(), Eigen::NoChange);
 
     m_scaling = m_model.get_scaling();
+    m_derived = m_model.get_derived();
+    m_ordered_ready = false;
 }
 //----------------------------------------------------------------------------
 void neural_net::from_yaml(const std::string &filename)
@@ -127,6 +188,40 @@ void neural_net::from_yaml(std::stringstream &s)
     YAML::convert<agile::neural_net>::decode(config["network"], *this);
 }
 //----------------------------------------------------------------------------
+void neural_net::from_binary(const std::string &filename)
+{
+    mapped_model model(filename);
+    block_reader blocks(model);
+    store_scope scope(&blocks);
+    YAML::convert<agile::neural_net>::decode(model.document()["network"], 
+        *this);
+}
+//----------------------------------------------------------------------------
+void neural_net::to_binary(const std::string &filename)
+{
+    block_writer blocks;
+    YAML::Node net;
+    {
+        store_scope scope(&blocks);
+        net["network"] = *this;
+    }
+    YAML::Emitter out;
+    out << net;
+    write_model_file(filename, out.c_str(), blocks.blocks);
+}
+//----------------------------------------------------------------------------
+void neural_net::from_file(const std::string &filename)
+{
+    if (is_model_file(filename))
+    {
+        from_binary(filename);
+    }
+    else
+    {
+        from_yaml(filename);
+    }
+}
+//----------------------------------------------------------------------------
 void neural_net::to_yaml(const std::string &filename)
 {
     std::ofstream file(filename);
@@ -520,25 +615,14 @@ void neural_net::check(bool tantrum)
 std::map<std::string, double> neural_net::predict_map(
     std::map<std::string, double> v, bool scale)
 {
+    prepare_inputs();
     int idx = 0;
-    m_tmp_input.resize(predictor_order.size(), Eigen::NoChange);
-    m_tmp_output.resize(target_order.size(), Eigen::NoChange);
-    if (scale)
-    {
-        for (auto &name : predictor_order)
-        {
-            m_tmp_input(idx) = (v.at(name) - m_scaling.mean.at(name)) /  m_scaling.sd.at(name);
-            ++idx;
-        }
-    }
-    else
+    for (auto &name : m_base_inputs)
     {
-        for (auto &name : predictor_order)
-        {
-            m_tmp_input(idx) = v.at(name);
-            ++idx;
-        }
+        m_tmp_base[idx] = v.at(name);
+        ++idx;
     }
+    load_inputs(m_tmp_base.data(), scale);
     m_tmp_output = predict(m_tmp_input);
     idx = 0;
     std::map<std::string, double> prediction;
@@ -550,6 +634,157 @@ std::map<std::string, double> neural_net::predict_map(
     return std::move(prediction);
 }
 //----------------------------------------------------------------------------
+void neural_net::predict_ordered(const double *in, double *out, bool scale)
+{
+    prepare_inputs();
+    load_inputs(in, scale);
+    m_tmp_output = predict(m_tmp_input);
+    Eigen::Map<agile::vector>(out, m_tmp_output.size()) = m_tmp_output;
+}
+//----------------------------------------------------------------------------
+agile::matrix neural_net::predict_batch(const agile::matrix &X, bool scale,
+    std::size_t tile_rows, unsigned int n_threads)
+{
+    prepare_inputs();
+    if (X.cols() != (long) m_base_inputs.size())
+    {
+        throw std::invalid_argument("batch has " + std::to_string(X.cols()) +
+            " columns, network needs " + 
+            std::to_string(m_base_inputs.size()) + " inputs.");
+    }
+    scale &= !m_scaling_folded;
+    if (scale && (m_input_shift.size() != (long) predictor_order.size()))
+    {
+        throw std::out_of_range("no scaling loaded for the inputs.");
+    }
+    if (n_layers == 0)
+    {
+        throw std::logic_error("can't predict with an empty network.");
+    }
+    agile::matrix Y(X.rows(), stack.back()->num_outputs());
+    std::vector<agile::expression::scratch> work(
+        agile::default_threads(n_threads));
+    for_tiles(X.rows(), tile_rows, n_threads, 
+        [&](unsigned int worker, std::size_t first, std::size_t n)
+    {
+        // X is column major, so every base input is a contiguous run
+        std::vector<const double*> base(m_base_inputs.size());
+        for (unsigned int k = 0; k < base.size(); ++k)
+        {
+            base[k] = X.col(k).data() + first;
+        }
+        agile::matrix A(n, predictor_order.size());
+        for (unsigned int i = 0; i < predictor_order.size(); ++i)
+        {
+            if (m_input_base[i] < 0)
+            {
+                m_input_expr[i].evaluate(base.data(), n, A.col(i).data(),
+                    work[worker]);
+            }
+            else
+            {
+                A.col(i) = X.block(first, m_input_base[i], n, 1);
+            }
+        }
+        if (scale)
+        {
+            A.rowwise() -= m_input_shift.transpose();
+            A = A.array().rowwise() / m_input_scale.transpose().array();
+        }
+        forward(A);
+        Y.middleRows(first, n) = A;
+    });
+    return Y;
+}
+//----------------------------------------------------------------------------
+void neural_net::load_inputs(const double *base, bool scale)
+{
+    m_tmp_input.resize(predictor_order.size(), Eigen::NoChange);
+    for (unsigned int i = 0; i < predictor_order.size(); ++i)
+    {
+        m_tmp_input(i) = (m_input_base[i] < 0) ? 
+            m_input_expr[i](base) : base[m_input_base[i]];
+    }
+    if (scale && !m_scaling_folded)
+    {
+        if (m_input_shift.size() != m_tmp_input.size())
+        {
+            throw std::out_of_range("no scaling loaded for the inputs.");
+        }
+        m_tmp_input = (m_tmp_input - m_input_shift).cwiseQuotient(m_input_scale);
+    }
+}
+//----------------------------------------------------------------------------
+void neural_net::prepare_inputs()
+{
+    if (m_ordered_ready)
+    {
+        return;
+    }
+    m_base_inputs.clear();
+    for (auto &name : predictor_order)
+    {
+        if (m_derived.count(name) == 0)
+        {
+            m_base_inputs.push_back(name);
+        }
+    }
+    m_input_expr.assign(predictor_order.size(), agile::expression());
+    for (unsigned int i = 0; i < predictor_order.size(); ++i)
+    {
+        auto derived = m_derived.find(predictor_order[i]);
+        if (derived != m_derived.end())
+        {
+            m_input_expr[i] = agile::expression(derived->second);
+            for (auto &var : m_input_expr[i].variables())
+            {
+                if (std::find(m_base_inputs.begin(), m_base_inputs.end(), var) 
+                    == m_base_inputs.end())
+                {
+                    m_base_inputs.push_back(var);
+                }
+            }
+        }
+    }
+    m_input_base.assign(predictor_order.size(), -1);
+    for (unsigned int i = 0; i < predictor_order.size(); ++i)
+    {
+        if (m_derived.count(predictor_order[i]) == 0)
+        {
+            m_input_base[i] = std::find(m_base_inputs.begin(), 
+                m_base_inputs.end(), predictor_order[i]) - m_base_inputs.begin();
+        }
+        else
+        {
+            m_input_expr[i].bind(m_base_inputs);
+        }
+    }
+    m_tmp_base.resize(m_base_inputs.size());
+
+    // an unscaled network may well have no scaling at all
+    m_input_shift.resize(0);
+    m_input_scale.resize(0);
+    bool scaled = true;
+    for (auto &name : predictor_order)
+    {
+        scaled &= (m_scaling.mean.count(name) != 0) && 
+            (m_scaling.sd.count(name) != 0);
+    }
+    if (scaled)
+    {
+        m_input_shift.resize(predictor_order.size(), Eigen::NoChange);
+        m_input_scale.resize(predictor_order.size(), Eigen::NoChange);
+        int idx = 0;
+        for (auto &name : predictor_order)
+        {
+            m_input_shift(idx) = m_scaling.mean.at(name);
+            m_input_scale(idx) = m_scaling.sd.at(name);
+            ++idx;
+        }
+    }
+    m_ordered_ready = true;
+}
+//----------------------------------------------------------------------------
 std::vector<std::string> neural_net::get_inputs()
 {
     return predictor_order;
@@ -560,24 +795,91 @@ std::vector<std::string> neural_net::get_outputs()
     return target_order;
 }
 //----------------------------------------------------------------------------
+std::vector<std::string> neural_net::get_base_inputs()
+{
+    prepare_inputs();
+    return m_base_inputs;
+}
+//----------------------------------------------------------------------------
 void neural_net::load_scaling(const agile::scaling &scale)
 {
     m_scaling = scale;
+    m_ordered_ready = false;
     m_model.load_scaling(scale);
-
 }
 //----------------------------------------------------------------------------
 void neural_net::load_scaling(agile::scaling &&scale)
 {
     m_scaling = (scale);
+    m_ordered_ready = false;
     m_model.load_scaling(std::move(scale));
 }
 //----------------------------------------------------------------------------
+double neural_net::fold_scaling(double tol)
+{
+    if (m_scaling_folded)
+    {
+        return 0.0;
+    }
+    prepare_inputs();
+    if (n_layers == 0)
+    {
+        throw std::logic_error("can't fold scaling into an empty network.");
+    }
+    if (m_input_shift.size() != (long) predictor_order.size())
+    {
+        throw std::out_of_range("no scaling loaded for the inputs.");
+    }
+    layer &first = *stack.front();
+
+    // raw inputs spread over a few standard deviations of each one
+    const int n_check = 1000;
+    agile::matrix raw(n_check, predictor_order.size());
+    std::normal_distribution<numeric> normal(0.0, 2.0);
+    for (int i = 0; i < raw.rows(); ++i)
+    {
+        for (int j = 0; j < raw.cols(); ++j)
+        {
+            raw(i, j) = m_input_shift(j) + 
+                m_input_scale(j) * normal(agile::mersenne_engine());
+        }
+    }
+    agile::matrix scaled = (raw.rowwise() - m_input_shift.transpose()).array()
+        .rowwise() / m_input_scale.transpose().array();
+    agile::matrix before = architecture::predict_batch(scaled);
+
+    agile::matrix W = first.W;
+    agile::vector b = first.b;
+    agile::vector inv_sd = m_input_scale.cwiseInverse();
+    first.W = W * inv_sd.asDiagonal();
+    first.b = b - first.W * m_input_shift;
+
+    agile::matrix after = architecture::predict_batch(raw);
+    double deviation = (after - before).cwiseAbs().maxCoeff();
+    if (!(deviation <= tol))
+    {
+        first.W = W;
+        first.b = b;
+        std::stringstream ss;
+        ss << "folded network deviates from the original by " << deviation;
+        throw std::runtime_error(ss.str() + ".");
+    }
+    m_scaling_folded = true;
+    return deviation;
+}
+//----------------------------------------------------------------------------
+bool neural_net::scaling_folded()
+{
+    return m_scaling_folded;
+}
+//----------------------------------------------------------------------------
 void neural_net::load_model_frame_config(agile::model_frame &m)
 {
     m_scaling = m.get_scaling();
     predictor_order = m.get_inputs();
     target_order = m.get_outputs();
+    m_derived = m.get_derived();
+    m_ordered_ready = false;
 }
 //----------------------------------------------------------------------------
 agile::scaling neural_net::get_scaling()
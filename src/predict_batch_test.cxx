@@ -0,0 +1,67 @@
+#include "include/neural_net.hh"
+#include "include/test_network.hh"
+#include "dataframe/include/checks.hh"
+#include <algorithm>
+#include <iostream>
+
+using agile::checks::check;
+
+//----------------------------------------------------------------------------
+int main()
+{
+    agile::dataframe D = agile::checks::test_frame(3000);
+    agile::neural_net net;
+    agile::checks::build_test_network(net, D);
+
+    auto base = net.get_base_inputs(), outputs = net.get_outputs();
+    check(base.size() == 3, "a, b and c are the base inputs");
+
+    // the rows to predict, in get_base_inputs() order, and the answers one
+    // sample at a time
+    const std::size_t n = D.rows();
+    agile::matrix X(n, base.size()), expected(n, outputs.size()),
+        ordered(n, outputs.size());
+    for (std::size_t r = 0; r < n; ++r)
+    {
+        for (std::size_t i = 0; i < base.size(); ++i)
+        {
+            X(r, i) = D.at(r, base[i]);
+        }
+        auto predicted = net.predict_map(agile::checks::test_inputs(D, r));
+        for (std::size_t o = 0; o < outputs.size(); ++o)
+        {
+            expected(r, o) = predicted[outputs[o]];
+        }
+        agile::vector x = X.row(r).transpose();
+        agile::vector y(outputs.size());
+        net.predict_ordered(x.data(), y.data());
+        ordered.row(r) = y.transpose();
+    }
+    check((ordered - expected).cwiseAbs().maxCoeff() < 1e-12,
+        "predict_ordered() matches predict_map()");
+
+    // tiles smaller than, ragged against, and larger than the rows all
+    // match, and threads don't change the answer for a given tiling
+    const std::size_t tiles[] = {1, 7, 100, 1024, 5000};
+    for (std::size_t tile : tiles)
+    {
+        const std::string where = "tiles of " + std::to_string(tile);
+        agile::matrix Y = net.predict_batch(X, true, tile, 1);
+        check((Y.rows() == (long) n) && (Y.cols() == (long) outputs.size()),
+            where + ": shape");
+        if ((Y.rows() != (long) n) || (Y.cols() != (long) outputs.size()))
+        {
+            continue;
+        }
+        check((Y - expected).cwiseAbs().maxCoeff() < 1e-12,
+            where + ": matches predict_map()");
+        check(net.predict_batch(X, true, tile, 4) == Y,
+            where + ": the same on 4 threads");
+    }
+
+    // no rows is no outputs
+    agile::matrix none = net.predict_batch(agile::matrix(0, base.size()));
+    check(none.rows() == 0, "an empty batch");
+
+    return agile::checks::report("predict_batch_test");
+}
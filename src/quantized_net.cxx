@@ -0,0 +1,360 @@
+//-----------------------------------------------------------------------------
+//  quantized_net.cxx:
+//  Implementation for a trained neural_net with its weights quantized
+//  Author: Luke de Oliveira (luke.deoliveira@yale.edu)
+//-----------------------------------------------------------------------------
+
+#include "quantized_net.hh"
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace agile
+{
+
+namespace
+{
+//----------------------------------------------------------------------------
+// Integer dot products. With SSE2 (any x86-64), 16 bit lanes are multiplied
+// and summed in pairs by pmaddwd, 8 bit values being sign extended to 16
+// bits first. 8 bit products add up in 32 bits, which can't overflow for
+// fewer than 2^17 inputs; 16 bit ones need 64.
+//----------------------------------------------------------------------------
+inline std::int32_t dot(const std::int8_t *a, const std::int8_t *b, long n)
+{
+    std::int32_t sum = 0;
+    long j = 0;
+#ifdef __SSE2__
+    __m128i acc = _mm_setzero_si128();
+    for (; j + 16 <= n; j += 16)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i*) (a + j));
+        __m128i vb = _mm_loadu_si128((const __m128i*) (b + j));
+        __m128i a_lo = _mm_srai_epi16(_mm_unpacklo_epi8(va, va), 8);
+        __m128i a_hi = _mm_srai_epi16(_mm_unpackhi_epi8(va, va), 8);
+        __m128i b_lo = _mm_srai_epi16(_mm_unpacklo_epi8(vb, vb), 8);
+        __m128i b_hi = _mm_srai_epi16(_mm_unpackhi_epi8(vb, vb), 8);
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(a_lo, b_lo));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(a_hi, b_hi));
+    }
+    std::int32_t lanes[4];
+    _mm_storeu_si128((__m128i*) lanes, acc);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; j < n; ++j)
+    {
+        sum += static_cast<std::int32_t>(a[j]) * b[j];
+    }
+    return sum;
+}
+//----------------------------------------------------------------------------
+inline std::int64_t dot(const std::int16_t *a, const std::int16_t *b, long n)
+{
+    std::int64_t sum = 0;
+    long j = 0;
+#ifdef __SSE2__
+    __m128i acc = _mm_setzero_si128();
+    for (; j + 8 <= n; j += 8)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i*) (a + j));
+        __m128i vb = _mm_loadu_si128((const __m128i*) (b + j));
+        // each pair sum fits in 32 bits, then gets widened to 64
+        __m128i pairs = _mm_madd_epi16(va, vb);
+        __m128i sign = _mm_srai_epi32(pairs, 31);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(pairs, sign));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(pairs, sign));
+    }
+    std::int64_t lanes[2];
+    _mm_storeu_si128((__m128i*) lanes, acc);
+    sum = lanes[0] + lanes[1];
+#endif
+    for (; j < n; ++j)
+    {
+        sum += static_cast<std::int32_t>(a[j]) * b[j];
+    }
+    return sum;
+}
+
+//----------------------------------------------------------------------------
+// sigmoid tabulated on [-16, 16], linearly interpolated. That's good to
+// better than 1e-6, and anything outside falls back on std::exp.
+const double sigmoid_range = 16.0;
+const double sigmoid_steps = 128.0; // table entries per unit
+
+const std::vector<double>& sigmoid_table()
+{
+    static const std::vector<double> table = []()
+    {
+        std::vector<double> t(2 * sigmoid_range * sigmoid_steps + 2);
+        for (std::size_t i = 0; i < t.size(); ++i)
+        {
+            double x = i / sigmoid_steps - sigmoid_range;
+            t[i] = 1.0 / (1.0 + std::exp(-x));
+        }
+        return t;
+    }();
+    return table;
+}
+//----------------------------------------------------------------------------
+inline double fast_sigmoid(double x, const double *table)
+{
+    if (!((x > -sigmoid_range) && (x < sigmoid_range)))
+    {
+        return 1.0 / (1.0 + std::exp(-x));
+    }
+    double pos = (x + sigmoid_range) * sigmoid_steps;
+    std::size_t i = static_cast<std::size_t>(pos);
+    double frac = pos - i;
+    return table[i] + frac * (table[i + 1] - table[i]);
+}
+//----------------------------------------------------------------------------
+void activate(double *y, long n, layer_type type)
+{
+    switch(type)
+    {
+        case linear:
+            return;
+        case rectified:
+            for (long i = 0; i < n; ++i)
+            {
+                y[i] = (y[i] > 0.0) ? y[i] : 0.0;
+            }
+            return;
+        case sigmoid:
+        {
+            const double *table = sigmoid_table().data();
+            for (long i = 0; i < n; ++i)
+            {
+                y[i] = fast_sigmoid(y[i], table);
+            }
+            return;
+        }
+        case softmax:
+        {
+            double top = y[0], sum = 0.0;
+            for (long i = 1; i < n; ++i)
+            {
+                top = std::max(top, y[i]);
+            }
+            for (long i = 0; i < n; ++i)
+            {
+                y[i] = std::exp(y[i] - top);
+                sum += y[i];
+            }
+            for (long i = 0; i < n; ++i)
+            {
+                y[i] /= sum;
+            }
+            return;
+        }
+        default: throw std::domain_error("layer type not recognized.");
+    }
+}
+//----------------------------------------------------------------------------
+// scale taking the largest magnitude to qmax (or anything, if it's zero)
+inline double scale_for(double largest, double qmax)
+{
+    return (largest > 0.0) ? largest / qmax : 1.0;
+}
+}
+
+//----------------------------------------------------------------------------
+quantized_net::quantized_net(neural_net &net, int bits, bool scale)
+: m_plan(net, scale), m_bits(bits), m_width(0)
+{
+    if ((bits != 8) && (bits != 16))
+    {
+        throw std::invalid_argument("can only quantize to 8 or 16 bits.");
+    }
+    m_qmax = (1 << (bits - 1)) - 1;
+    for (auto &p : m_plan.m_stages)
+    {
+        stage s;
+        s.rows = p.W.rows();
+        s.cols = p.W.cols();
+        s.b = p.b;
+        s.type = p.type;
+        s.row_scale.resize(s.rows);
+        for (long i = 0; i < s.rows; ++i)
+        {
+            s.row_scale[i] = scale_for(p.W.row(i).cwiseAbs().maxCoeff(),
+                m_qmax);
+            for (long j = 0; j < s.cols; ++j)
+            {
+                long q = std::lround(p.W(i, j) / s.row_scale[i]);
+                if (bits == 8)
+                {
+                    s.W8.push_back(static_cast<std::int8_t>(q));
+                }
+                else
+                {
+                    s.W16.push_back(static_cast<std::int16_t>(q));
+                }
+            }
+        }
+        m_stages.push_back(std::move(s));
+    }
+    for (auto length : m_plan.m_length)
+    {
+        m_width = std::max(m_width, length);
+    }
+    m_own = make_workspace();
+}
+//----------------------------------------------------------------------------
+quantized_net::workspace quantized_net::make_workspace() const
+{
+    workspace w;
+    w.m_a.assign(m_width, 0.0);
+    w.m_b.assign(m_width, 0.0);
+    w.m_q8.assign((m_bits == 8) ? m_width : 0, 0);
+    w.m_q16.assign((m_bits == 16) ? m_width : 0, 0);
+    return w;
+}
+//----------------------------------------------------------------------------
+template <class Q>
+void quantized_net::run(const stage &s, std::size_t l, const Q *W,
+    const double *x, double *y, Q *q) const
+{
+    double sa;
+    if (m_input_scale.empty())
+    {
+        double largest = 0.0;
+        for (long j = 0; j < s.cols; ++j)
+        {
+            largest = std::max(largest, std::fabs(x[j]));
+        }
+        sa = scale_for(largest, m_qmax);
+    }
+    else
+    {
+        sa = m_input_scale[l];
+    }
+    const double inv = 1.0 / sa;
+    for (long j = 0; j < s.cols; ++j)
+    {
+        // clamped, then rounded half away from zero
+        double v = std::min(std::max(x[j] * inv, -m_qmax), m_qmax);
+        q[j] = static_cast<Q>(v + ((v < 0.0) ? -0.5 : 0.5));
+    }
+
+    for (long i = 0; i < s.rows; ++i)
+    {
+        y[i] = dot(W + i * s.cols, q, s.cols) * (s.row_scale[i] * sa) +
+            s.b(i);
+    }
+    activate(y, s.rows, s.type);
+}
+//----------------------------------------------------------------------------
+void quantized_net::predict(const double *in, double *out,
+    workspace &w) const
+{
+    std::size_t q_size = (m_bits == 8) ? w.m_q8.size() : w.m_q16.size();
+    if ((w.m_a.size() != m_width) || (q_size != m_width))
+    {
+        throw std::invalid_argument("workspace wasn't made by this network.");
+    }
+    double *x = w.m_a.data(), *y = w.m_b.data();
+    m_plan.load_inputs(in, x);
+    for (std::size_t l = 0; l < m_stages.size(); ++l)
+    {
+        if (m_bits == 8)
+        {
+            run(m_stages[l], l, m_stages[l].W8.data(), x, y, w.m_q8.data());
+        }
+        else
+        {
+            run(m_stages[l], l, m_stages[l].W16.data(), x, y,
+                w.m_q16.data());
+        }
+        std::swap(x, y);
+    }
+    std::copy(x, x + m_stages.back().rows, out);
+}
+//----------------------------------------------------------------------------
+void quantized_net::predict(const double *in, double *out)
+{
+    predict(in, out, m_own);
+}
+//----------------------------------------------------------------------------
+std::vector<double> quantized_net::gather(const agile::dataframe &D,
+    std::size_t max_rows) const
+{
+    const auto &names = inputs();
+    const std::size_t rows = std::min(max_rows, D.rows());
+    std::vector<double> values(rows * names.size()), col(rows);
+    for (std::size_t c = 0; c < names.size(); ++c)
+    {
+        D.get_column(names[c]).copy_to(col.data(), 0, rows);
+        for (std::size_t r = 0; r < rows; ++r)
+        {
+            values[r * names.size() + c] = col[r];
+        }
+    }
+    return values;
+}
+//----------------------------------------------------------------------------
+double quantized_net::calibrate(const agile::dataframe &D,
+    std::size_t max_rows)
+{
+    std::vector<double> values = gather(D, max_rows);
+    const std::size_t n_in = inputs().size();
+    const std::size_t rows = n_in ? values.size() / n_in : 0;
+    if (rows == 0)
+    {
+        throw std::invalid_argument("no rows to calibrate on.");
+    }
+
+    // the largest input each layer sees, running the floating point
+    // network over the sample
+    std::vector<double> largest(m_stages.size(), 0.0);
+    agile::matrix A(rows, m_plan.m_length[0]);
+    for (std::size_t r = 0; r < rows; ++r)
+    {
+        agile::vector x(A.cols());
+        m_plan.load_inputs(&values[r * n_in], x.data());
+        A.row(r) = x.transpose();
+    }
+    for (std::size_t l = 0; l < m_stages.size(); ++l)
+    {
+        const auto &p = m_plan.m_stages[l];
+        largest[l] = A.cwiseAbs().maxCoeff();
+        agile::matrix Z = A * p.W.transpose();
+        Z.rowwise() += p.b.transpose();
+        agile::functions::activate_rows(Z, p.type);
+        A.swap(Z);
+    }
+    m_input_scale.resize(m_stages.size());
+    for (std::size_t l = 0; l < m_stages.size(); ++l)
+    {
+        m_input_scale[l] = scale_for(largest[l], m_qmax);
+    }
+    return max_deviation(D, max_rows);
+}
+//----------------------------------------------------------------------------
+double quantized_net::max_deviation(const agile::dataframe &D,
+    std::size_t max_rows) const
+{
+    std::vector<double> values = gather(D, max_rows);
+    const std::size_t n_in = inputs().size();
+    const std::size_t rows = n_in ? values.size() / n_in : 0;
+    const std::size_t n_out = m_stages.back().rows;
+
+    auto pw = m_plan.make_workspace();
+    auto qw = make_workspace();
+    std::vector<double> expected(n_out), got(n_out);
+    double deviation = 0.0;
+    for (std::size_t r = 0; r < rows; ++r)
+    {
+        m_plan.predict(&values[r * n_in], expected.data(), pw);
+        predict(&values[r * n_in], got.data(), qw);
+        for (std::size_t i = 0; i < n_out; ++i)
+        {
+            deviation = std::max(deviation, std::fabs(got[i] - expected[i]));
+        }
+    }
+    return deviation;
+}
+
+}
@@ -0,0 +1,103 @@
+#include "include/quantized_net.hh"
+#include "include/test_network.hh"
+#include "dataframe/include/checks.hh"
+#include <algorithm>
+#include <iostream>
+
+using agile::checks::check;
+
+// largest difference between the outputs of Q and of the plan over D
+double deviation_from_plan(agile::quantized_net &Q, agile::inference_plan &P,
+    const agile::dataframe &D)
+{
+    const std::size_t n_in = P.inputs().size(), n_out = P.outputs().size();
+    std::vector<double> in(n_in), a(n_out), b(n_out);
+    double largest = 0.0;
+    for (std::size_t r = 0; r < D.rows(); ++r)
+    {
+        for (std::size_t i = 0; i < n_in; ++i)
+        {
+            in[i] = D.at(r, P.inputs()[i]);
+        }
+        Q.predict(in.data(), a.data());
+        P.predict(in.data(), b.data());
+        for (std::size_t o = 0; o < n_out; ++o)
+        {
+            largest = std::max(largest, std::fabs(a[o] - b[o]));
+        }
+    }
+    return largest;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    agile::dataframe train = agile::checks::test_frame(2000, 1),
+                     sample = agile::checks::test_frame(5000, 2),
+                     held_out = agile::checks::test_frame(5000, 3);
+    agile::neural_net net;
+    agile::checks::build_test_network(net, train);
+    agile::inference_plan P(net);
+
+    // the bound for each width, with room over what it comes to on this
+    // network (about 0.007 for 8 bits and 2.3e-5 for 16)
+    const std::pair<int, double> widths[] = {{8, 0.05}, {16, 1e-4}};
+    double deviation[2];
+    for (int w = 0; w < 2; ++w)
+    {
+        const int bits = widths[w].first;
+        const std::string where = std::to_string(bits) + " bit";
+        agile::quantized_net Q(net, bits);
+        check(Q.bits() == bits, where + ": bits()");
+        check(Q.inputs() == P.inputs(), where + ": inputs()");
+        check(Q.outputs() == P.outputs(), where + ": outputs()");
+        check(!Q.calibrated(), where + ": not calibrated to start with");
+
+        double dynamic = deviation_from_plan(Q, P, held_out);
+        check(dynamic < widths[w].second, where + ": dynamic scales " +
+            std::to_string(dynamic));
+
+        double reported = Q.calibrate(sample);
+        check(Q.calibrated(), where + ": calibrated()");
+        check(std::fabs(reported - Q.max_deviation(sample)) < 1e-15,
+            where + ": calibrate() returns max_deviation()");
+
+        deviation[w] = deviation_from_plan(Q, P, sample);
+        check(deviation[w] < widths[w].second, where + ": calibrated " +
+            std::to_string(deviation[w]));
+        check(deviation[w] > 0.0, where + ": actually quantized");
+        check(std::fabs(deviation[w] - reported) < 1e-15,
+            where + ": max_deviation() against the plan");
+
+        // inputs past what the sample had are clamped, so other data can
+        // come out further off, but not wildly
+        double other = deviation_from_plan(Q, P, held_out);
+        check(other < 20 * widths[w].second, where + ": calibrated, on " +
+            "other data " + std::to_string(other));
+
+        auto work = Q.make_workspace();
+        std::vector<double> in(P.inputs().size()), a(P.outputs().size()),
+            b(P.outputs().size());
+        for (std::size_t i = 0; i < in.size(); ++i)
+        {
+            in[i] = held_out.at(0, P.inputs()[i]);
+        }
+        Q.predict(in.data(), a.data());
+        Q.predict(in.data(), b.data(), work);
+        check(a == b, where + ": own and separate workspaces agree");
+    }
+    check(deviation[1] < deviation[0] / 10, "16 bits is well ahead of 8");
+
+    bool threw = false;
+    try
+    {
+        agile::quantized_net Q(net, 4);
+    }
+    catch (std::invalid_argument &e)
+    {
+        threw = true;
+    }
+    check(threw, "4 bits refused");
+
+    return agile::checks::report("quantized_net_test");
+}
@@ -2,95 +2,46 @@
 #define WEIGHTING___HH 
 
 #include "ROOT.hh"
+#include "root/include/reweighter.hh"
 //----------------------------------------------------------------------------
 
 namespace agile {
 namespace root {
 
+//----------------------------------------------------------------------------
+//  weighting -- the b-tagging flavor weights, kept for the scripts that use
+//  it. The histogramming is done by agile::root::reweighter over every 
+//  binning the tree_reader has, with light jets as the reference.
+//----------------------------------------------------------------------------
 class weighting
 {
 public:
     weighting() : charm_pct(0.11), light_pct(0.54), bottom_pct(0.35) {}
     
+    // histograms entries [start, n_entries) of tree_buf
     weighting &gen_hist(agile::root::tree_reader &tree_buf, int n_entries = 1000, int start = 0, bool verbose = true)
     {   
-        std::vector<std::string> flavors({"bottom", "charm", "light"});
-
-        auto bin_strat = tree_buf.get_binning();
-        int m_num_pt_bins = bin_strat["pt"].size();
-        int m_num_eta_bins = bin_strat["abs(eta)"].size();
-
-
-        charm_correction.resize(m_num_pt_bins);
-        bottom_correction.resize(m_num_pt_bins);
-        light_correction.resize(m_num_pt_bins);
-        charm_hist.resize(m_num_pt_bins);
-        bottom_hist.resize(m_num_pt_bins);
-        light_hist.resize(m_num_pt_bins);
-
-
-        for (int i = 0; i < m_num_pt_bins; ++i)
-        {
-            charm_correction[i].resize(m_num_eta_bins);
-            bottom_correction[i].resize(m_num_eta_bins);
-            light_correction[i].resize(m_num_eta_bins);
-
-            charm_hist[i].resize(m_num_eta_bins);
-            bottom_hist[i].resize(m_num_eta_bins);
-            light_hist[i].resize(m_num_eta_bins);
-        }
-
-
-
-        for (int cat_pT = 0; cat_pT < m_num_pt_bins; ++cat_pT)
+        m_engine = agile::root::reweighter();
+        for (auto &entry : tree_buf.get_binning())
         {
-            for (int cat_eta = 0; cat_eta < m_num_eta_bins; ++cat_eta)
+            // absolute binnings come back named abs(<var>)
+            std::string name = entry.first;
+            bool absolute = (name.compare(0, 4, "abs(") == 0);
+            if (absolute)
             {
-                light_hist[cat_pT][cat_eta] = 0;
-                charm_hist[cat_pT][cat_eta] = 0;
-                bottom_hist[cat_pT][cat_eta] = 0;
-            }
-        }
-        for (int i = start; i < n_entries; ++i)
-        {
-            tree_buf.get_entry(i);
-            if (tree_buf.entry_in_range())
-            {
-                auto vars = tree_buf(i, flavors);
-
-                if ((int)vars["charm"] == 1)
-                {
-                    int cat_pt = (int) tree_buf(i, "categ_pt");
-                    int cat_eta = (int) tree_buf(i, "categ_eta");
-                    bottom_hist[cat_pt][cat_eta] += 1;
-                }
-                else if ((int)vars["light"] == 1)
-                {
-                    int cat_pt = (int) tree_buf(i, "categ_pt");
-                    int cat_eta = (int) tree_buf(i, "categ_eta");
-                    light_hist[cat_pt][cat_eta] += 1;
-                }
-                else
-                {
-                    int cat_pt = (int) tree_buf(i, "categ_pt");
-                    int cat_eta = (int) tree_buf(i, "categ_eta");
-                    charm_hist[cat_pt][cat_eta] += 1;
-                }
-            }
-            if (verbose)
-            {
-                double pct = (double)(i - start) / (double)(n_entries);
-                agile::progress_bar(pct * 100);
-            }
-        }
-        for (int cat_pT = 0; cat_pT < m_num_pt_bins; ++cat_pT)
-        {
-            for (int cat_eta = 0; cat_eta < m_num_eta_bins; ++cat_eta)
-            {
-                bottom_correction[cat_pT][cat_eta] = std::min(std::max(light_hist[cat_pT][cat_eta], 1.0) / ((light_pct / bottom_pct) * std::max(bottom_hist[cat_pT][cat_eta], 1.0)), 20.0);
-                charm_correction[cat_pT][cat_eta] = std::min(std::max(light_hist[cat_pT][cat_eta], 1.0) / ((light_pct / charm_pct) * std::max(charm_hist[cat_pT][cat_eta], 1.0)), 20.0);
+                name = name.substr(4, name.size() - 5);
             }
+            agile::root::binner b(name, entry.second);
+            m_engine.add_dimension(b.set_abs(absolute));
         }
+        m_engine.set_label({"light", "bottom", "charm"})
+                .set_reference(0)
+                .set_fraction(0, light_pct)
+                .set_fraction(1, bottom_pct)
+                .set_fraction(2, charm_pct);
+
+        agile::dataframe D = tree_buf.get_dataframe(n_entries - start, start, verbose);
+        m_engine.fill(D);
         return *this;
     }
 //----------------------------------------------------------------------------
@@ -114,26 +65,16 @@ public:
 //----------------------------------------------------------------------------
     double get_weight(std::map<std::string, double> &vars)
     {
-        if ((int)vars["light"] == 1)
-        {
-            return 1.0;
-        }
-        else if ((int)vars["bottom"] == 1)
-        {
-            return bottom_correction[(int)vars["categ_pt"]][(int)vars["categ_eta"]];
-        }
-        else if ((int)vars["charm"] == 1)
-        {
-            return charm_correction[(int)vars["categ_pt"]][(int)vars["categ_eta"]];
-        }
-        else
+        if (((int)vars["light"] != 1) && ((int)vars["bottom"] != 1) && 
+            ((int)vars["charm"] != 1))
         {
             throw std::domain_error(
                 "Flavor type missing in map passed to weighting class");
         }
+        return m_engine.get_weight(vars);
     }
 
-
+    const agile::root::reweighter& engine() const { return m_engine; }
 
     ~weighting() = default;
 
@@ -141,12 +82,7 @@ public:
 
 private:
     double charm_pct, light_pct, bottom_pct;
-    std::vector<std::vector<double>> charm_correction, 
-                                    light_correction, 
-                                    bottom_correction, 
-                                    charm_hist, 
-                                    bottom_hist, 
-                                    light_hist;
+    agile::root::reweighter m_engine;
 };
 
 